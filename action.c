@@ -96,6 +96,8 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
 #include <json.h>
 
 #include "rsyslog.h"
@@ -193,6 +195,18 @@ int iActionNbr = 0;
 int bActionReportSuspension = 1;
 int bActionReportSuspensionCont = 0;
 
+/* circuit breaker support: actions with action.circuitBreaker="on" register
+ * here. A single background prober thread owns resume checks for all of them
+ * while their circuit is open, so workers never sleep inside actionDoRetry.
+ */
+static pthread_mutex_t mutCircuit = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t condCircuit = PTHREAD_COND_INITIALIZER;
+static action_t **circuitActions = NULL;
+static int nCircuitActions = 0;
+static pthread_t tidCircuitProber;
+static sbool bCircuitProberRunning = 0;
+static sbool bCircuitProberStop = 0;
+
 /* tables for interfacing with the v6 config system */
 static struct cnfparamdescr cnfparamdescr[] = {
 	{ "name", eCmdHdlrGetWord, 0 }, /* legacy: actionname */
@@ -211,7 +225,11 @@ static struct cnfparamdescr cnfparamdescr[] = {
 	{ "action.resumeintervalmax", eCmdHdlrPositiveInt, 0 },
 	{ "action.resumeinterval", eCmdHdlrInt, 0 },
 	{ "action.externalstate.file", eCmdHdlrString, 0 },
-	{ "action.copymsg", eCmdHdlrBinary, 0 }
+	{ "action.copymsg", eCmdHdlrBinary, 0 },
+	{ "action.maxinflight", eCmdHdlrNonNegInt, 0 },
+	{ "action.circuitbreaker", eCmdHdlrBinary, 0 },
+	{ "action.linger.ms", eCmdHdlrNonNegInt, 0 },
+	{ "action.linger.bytes", eCmdHdlrSize, 0 }
 };
 static struct cnfparamblk pblk =
 	{ CNFPARAMBLK_VERSION,
@@ -325,6 +343,241 @@ actionResetQueueParams(void)
 }
 
 
+/* circuit breaker subsystem.
+ * With action.circuitBreaker="on", the first worker that fails to resume an
+ * action "opens" its circuit and hands resume checking over to a single
+ * background prober thread. Workers then only look at the circuit state,
+ * which is O(1), instead of calling tryResume() and sleeping themselves. The
+ * prober uses its own worker instance of the action and retries with
+ * exponential backoff (starting at action.resumeInterval, capped at
+ * action.resumeIntervalMax) plus jitter, so that many actions pointing to the
+ * same dead destination do not probe in lockstep. Once a probe succeeds, the
+ * circuit is closed and workers resume via their own instances.
+ */
+
+/* compute the (jittered) delay for the next probe. We use "equal jitter",
+ * that is a random value between half and the full backoff.
+ */
+static int
+circuitJitter(const int backoff, unsigned *const seed)
+{
+	const int half = backoff / 2;
+	const int delay = backoff - half + (half > 0 ? (int) (rand_r(seed) % (half + 1)) : 0);
+	return delay < 1 ? 1 : delay;
+}
+
+static int
+circuitNextBackoff(const action_t *const pThis, const int backoff)
+{
+	int newBackoff = (backoff < 1) ? 1 : 2 * backoff;
+	if(pThis->iResumeIntervalMax > 0 && newBackoff > pThis->iResumeIntervalMax)
+		newBackoff = pThis->iResumeIntervalMax;
+	return newBackoff;
+}
+
+/* do one probe. Called by the prober thread without holding mutCircuit,
+ * the circuit is in half-open state while we are here.
+ */
+static rsRetVal
+circuitProbe(action_t *const pThis)
+{
+	DEFiRet;
+
+	if(pThis->circuitWrkrData == NULL) {
+		CHKiRet(pThis->pMod->mod.om.createWrkrInstance(&pThis->circuitWrkrData, pThis->pModData));
+	}
+	STATSCOUNTER_INC(pThis->ctrCircuitProbes, pThis->mutCtrCircuitProbes);
+	iRet = pThis->pMod->tryResume(pThis->circuitWrkrData);
+	DBGPRINTF("action '%s': circuit probe returned %d\n", pThis->pszName, iRet);
+
+finalize_it:
+	RETiRet;
+}
+
+static void *
+circuitProber(void __attribute__((unused)) *arg)
+{
+	sigset_t sigSet;
+	struct timespec tWait;
+	unsigned seed;
+	time_t ttNow;
+	time_t ttNext;
+	rsRetVal localRet;
+	int i;
+
+	/* block all signals except SIGTTIN and SIGSEGV */
+	sigfillset(&sigSet);
+	sigdelset(&sigSet, SIGTTIN);
+	sigdelset(&sigSet, SIGSEGV);
+	pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+
+	seed = (unsigned) time(NULL) ^ (unsigned) getpid();
+	pthread_mutex_lock(&mutCircuit);
+	while(!bCircuitProberStop) {
+		datetime.GetTime(&ttNow);
+		ttNext = ttNow + 60; /* re-check at least once a minute */
+		for(i = 0 ; i < nCircuitActions && !bCircuitProberStop ; ++i) {
+			action_t *const pAction = circuitActions[i];
+			if(pAction->circuitState == ACT_CIRCUIT_OPEN && ttNow >= pAction->ttCircuitProbe) {
+				pAction->circuitState = ACT_CIRCUIT_HALFOPEN;
+				pthread_mutex_unlock(&mutCircuit);
+				localRet = circuitProbe(pAction);
+				pthread_mutex_lock(&mutCircuit);
+				datetime.GetTime(&ttNow);
+				if(localRet == RS_RET_OK) {
+					pAction->circuitState = ACT_CIRCUIT_CLOSED;
+					pAction->ttCircuitClosed = ttNow;
+					if(pAction->bReportSuspension) {
+						LogMsg(0, RS_RET_RESUMED, LOG_INFO, "action '%s' "
+							"resumed (module '%s'), circuit closed",
+							pAction->pszName, pAction->pMod->pszName);
+					}
+					pthread_cond_broadcast(&condCircuit);
+				} else {
+					pAction->circuitBackoff = circuitNextBackoff(pAction, pAction->circuitBackoff);
+					pAction->ttCircuitProbe = ttNow + circuitJitter(pAction->circuitBackoff, &seed);
+					pAction->circuitState = ACT_CIRCUIT_OPEN;
+				}
+			}
+			if(pAction->circuitState == ACT_CIRCUIT_OPEN && pAction->ttCircuitProbe < ttNext)
+				ttNext = pAction->ttCircuitProbe;
+		}
+		if(bCircuitProberStop)
+			break;
+		tWait.tv_sec = ttNext;
+		tWait.tv_nsec = 0;
+		pthread_cond_timedwait(&condCircuit, &mutCircuit, &tWait);
+	}
+	pthread_mutex_unlock(&mutCircuit);
+	return NULL;
+}
+
+/* open the circuit of an action, handing over resume checks to the prober.
+ * Nothing happens if the circuit is already open or half-open.
+ */
+static void ATTR_NONNULL()
+circuitOpen(action_t *const pThis)
+{
+	time_t ttNow;
+	unsigned seed;
+	int r;
+
+	pthread_mutex_lock(&mutCircuit);
+	if(pThis->circuitState != ACT_CIRCUIT_CLOSED)
+		goto done;
+
+	datetime.GetTime(&ttNow);
+	/* if the destination failed again shortly after it was resumed, we keep
+	 * increasing the backoff instead of starting over - this prevents flapping.
+	 */
+	if(pThis->circuitBackoff > 0 && ttNow - pThis->ttCircuitClosed < pThis->circuitBackoff) {
+		pThis->circuitBackoff = circuitNextBackoff(pThis, pThis->circuitBackoff);
+	} else {
+		pThis->circuitBackoff = (pThis->iResumeInterval < 1) ? 1 : pThis->iResumeInterval;
+	}
+	seed = (unsigned) ttNow ^ (unsigned) pThis->iActionNbr;
+	pThis->ttCircuitProbe = ttNow + circuitJitter(pThis->circuitBackoff, &seed);
+	pThis->circuitState = ACT_CIRCUIT_OPEN;
+	STATSCOUNTER_INC(pThis->ctrCircuitOpened, pThis->mutCtrCircuitOpened);
+	LogMsg(0, RS_RET_SUSPENDED, LOG_WARNING, "action '%s' suspended (module '%s'), circuit "
+		"opened, probing in background, next probe in %d seconds. There should be messages "
+		"before this one giving the reason for suspension.", pThis->pszName,
+		pThis->pMod->pszName, (int) (pThis->ttCircuitProbe - ttNow));
+
+	if(!bCircuitProberRunning) {
+		bCircuitProberStop = 0;
+		r = pthread_create(&tidCircuitProber, NULL, circuitProber, NULL);
+		if(r == 0) {
+			bCircuitProberRunning = 1;
+		} else {
+			/* without prober, we fall back to probing by the workers */
+			LogError(r, RS_RET_ERR, "action '%s': could not start circuit breaker prober "
+				"thread, falling back to resume probing by workers", pThis->pszName);
+			pThis->circuitState = ACT_CIRCUIT_CLOSED;
+			pThis->bCircuitBreaker = 0;
+		}
+	} else {
+		pthread_cond_broadcast(&condCircuit);
+	}
+done:
+	pthread_mutex_unlock(&mutCircuit);
+}
+
+/* wait until the prober has closed the circuit, used for actions which
+ * must retry eternally (action.resumeRetryCount="-1"). We wake up at least
+ * once a second to check for immediate shutdown.
+ */
+static void ATTR_NONNULL()
+circuitWaitClosed(action_t *const pThis, wti_t *const pWti)
+{
+	struct timespec tWait;
+
+	pthread_mutex_lock(&mutCircuit);
+	while(pThis->circuitState != ACT_CIRCUIT_CLOSED && *pWti->pbShutdownImmediate == 0) {
+		timeoutComp(&tWait, 1000);
+		pthread_cond_timedwait(&condCircuit, &mutCircuit, &tWait);
+	}
+	pthread_mutex_unlock(&mutCircuit);
+}
+
+static rsRetVal ATTR_NONNULL()
+circuitRegister(action_t *const pThis)
+{
+	action_t **newArr;
+	DEFiRet;
+
+	pthread_mutex_lock(&mutCircuit);
+	newArr = realloc(circuitActions, (nCircuitActions + 1) * sizeof(action_t*));
+	if(newArr == NULL) {
+		pthread_mutex_unlock(&mutCircuit);
+		ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+	}
+	circuitActions = newArr;
+	circuitActions[nCircuitActions++] = pThis;
+	pThis->circuitState = ACT_CIRCUIT_CLOSED;
+	pthread_mutex_unlock(&mutCircuit);
+
+finalize_it:
+	RETiRet;
+}
+
+/* remove action from the circuit breaker. As this is only done when the
+ * config is torn down, we stop the prober first. Nobody needs it any longer
+ * at that stage (and it will be restarted on demand if need be).
+ */
+static void ATTR_NONNULL()
+circuitUnregister(action_t *const pThis)
+{
+	int i;
+
+	pthread_mutex_lock(&mutCircuit);
+	if(bCircuitProberRunning) {
+		bCircuitProberStop = 1;
+		pthread_cond_broadcast(&condCircuit);
+		pthread_mutex_unlock(&mutCircuit);
+		pthread_join(tidCircuitProber, NULL);
+		pthread_mutex_lock(&mutCircuit);
+		bCircuitProberRunning = 0;
+	}
+	for(i = 0 ; i < nCircuitActions ; ++i) {
+		if(circuitActions[i] == pThis) {
+			circuitActions[i] = circuitActions[--nCircuitActions];
+			break;
+		}
+	}
+	if(nCircuitActions == 0) {
+		free(circuitActions);
+		circuitActions = NULL;
+	}
+	pthread_mutex_unlock(&mutCircuit);
+
+	if(pThis->circuitWrkrData != NULL) {
+		pThis->pMod->mod.om.freeWrkrInstance(pThis->circuitWrkrData);
+		pThis->circuitWrkrData = NULL;
+	}
+}
+
+
 /* destructs an action descriptor object
  * rgerhards, 2007-08-01
  */
@@ -342,6 +595,8 @@ rsRetVal actionDestruct(action_t * const pThis)
 		qqueueDestruct(&pThis->pQueue);
 	}
 
+	circuitUnregister(pThis);
+
 	/* destroy stats object, if we have one (may not always be
 	 * be the case, e.g. if turned off)
 	 */
@@ -466,6 +721,12 @@ actionConstructFinalize(action_t *__restrict__ const pThis, struct nvlst *lst)
 			}
 		}
 	}
+	if(pThis->iMaxInflight > 0 && pThis->pMod->mod.om.submitAsync == NULL) {
+		LogError(0, RS_RET_CONF_PARAM_INVLD, "action '%s': action.maxInFlight is set, but "
+			"module '%s' does not support asynchronous processing - ignored",
+			pThis->pszName, pThis->pMod->pszName);
+		pThis->iMaxInflight = 0;
+	}
 
 
 	/* support statistics gathering */
@@ -492,6 +753,18 @@ actionConstructFinalize(action_t *__restrict__ const pThis, struct nvlst *lst)
 	CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("resumed"),
 		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &pThis->ctrResume));
 
+	if(pThis->bCircuitBreaker) {
+		CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("circuit.state"),
+			ctrType_Int, CTR_FLAG_NONE, &pThis->circuitState));
+		STATSCOUNTER_INIT(pThis->ctrCircuitOpened, pThis->mutCtrCircuitOpened);
+		CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("circuit.opened"),
+			ctrType_IntCtr, CTR_FLAG_RESETTABLE, &pThis->ctrCircuitOpened));
+		STATSCOUNTER_INIT(pThis->ctrCircuitProbes, pThis->mutCtrCircuitProbes);
+		CHKiRet(statsobj.AddCounter(pThis->statsobj, UCHAR_CONSTANT("circuit.probes"),
+			ctrType_IntCtr, CTR_FLAG_RESETTABLE, &pThis->ctrCircuitProbes));
+		CHKiRet(circuitRegister(pThis));
+	}
+
 	CHKiRet(statsobj.ConstructFinalize(pThis->statsobj));
 
 	/* create our queue */
@@ -585,6 +858,30 @@ actionConstructFinalize(action_t *__restrict__ const pThis, struct nvlst *lst)
 			"see https://www.rsyslog.com/mm-no-queue/", (char*)modGetName(pThis->pMod));
 	}
 	
+	if(pThis->iLingerMs > 0) {
+		if(!pThis->isTransactional || pThis->pQueue->qType == QUEUETYPE_DIRECT) {
+			LogError(0, RS_RET_CONF_PARAM_INVLD, "action '%s': action.linger.ms "
+				"requires a transactional output module and a non-direct action "
+				"queue - ignored", pThis->pszName);
+			pThis->iLingerMs = 0;
+		}
+	}
+	if(pThis->iMaxInflight > 0) {
+		/* async transactions need to hold back their batches from deletion in
+		 * the action queue, and this mechanism is shared with linger.
+		 */
+		if(pThis->pQueue->qType == QUEUETYPE_DIRECT) {
+			LogError(0, RS_RET_CONF_PARAM_INVLD, "action '%s': action.maxInFlight "
+				"requires a non-direct action queue - ignored", pThis->pszName);
+			pThis->iMaxInflight = 0;
+		} else if(pThis->iLingerMs > 0) {
+			LogError(0, RS_RET_CONF_PARAM_INVLD, "action '%s': action.linger.ms "
+				"can not be combined with action.maxInFlight - linger ignored",
+				pThis->pszName);
+			pThis->iLingerMs = 0;
+		}
+	}
+
 	/* and now reset the queue params (see comment in its function header!) */
 	actionResetQueueParams();
 
@@ -825,6 +1122,48 @@ actionSuspend(action_t * const pThis, wti_t * const pWti)
 }
 
 
+/* one retry step if the action uses the circuit breaker. If the circuit is
+ * closed, we try to resume our own worker instance once. If that fails (or the
+ * circuit is already open), the prober takes over and we do not sleep: we
+ * either suspend immediately or - with eternal retries - wait for the prober
+ * to close the circuit. The action queue (if any) buffers messages meanwhile.
+ */
+static void ATTR_NONNULL()
+actionDoRetryCircuit(action_t * const pThis, wti_t * const pWti)
+{
+	rsRetVal localRet;
+
+	if(pThis->circuitState == ACT_CIRCUIT_CLOSED) {
+		localRet = pThis->pMod->tryResume(pWti->actWrkrInfo[pThis->iActionNbr].actWrkrData);
+		DBGPRINTF("actionDoRetryCircuit: %s action->tryResume returned %d\n",
+			pThis->pszName, localRet);
+		if((getActionResumeInRow(pWti, pThis) > 9) && (getActionResumeInRow(pWti, pThis) % 10 == 0)) {
+			/* same guard against "always OK" tryResume() as in actionDoRetry() */
+			setActionResumeInRow(pWti, pThis, 0);
+			localRet = RS_RET_SUSPENDED;
+		}
+		if(localRet == RS_RET_OK) {
+			actionSetState(pThis, pWti, ACT_STATE_RDY);
+			return;
+		} else if(localRet == RS_RET_DISABLE_ACTION) {
+			actionDisable(pThis);
+			return;
+		}
+		circuitOpen(pThis);
+		if(!pThis->bCircuitBreaker)
+			return; /* prober could not be started, classic retry processing */
+	}
+
+	if(pThis->iResumeRetryCount != -1) {
+		actionSuspend(pThis, pWti);
+		if(getActionNbrResRtry(pWti, pThis) < 20)
+			incActionNbrResRtry(pWti, pThis);
+	} else {
+		circuitWaitClosed(pThis, pWti);
+	}
+}
+
+
 /* actually do retry processing. Note that the function receives a timestamp so
  * that we do not need to call the (expensive) time() API.
  * Note that we do the full retry processing here, doing the configured number of
@@ -852,6 +1191,10 @@ actionDoRetry(action_t * const pThis, wti_t * const pWti)
 
 	iRetries = 0;
 	while((*pWti->pbShutdownImmediate == 0) && getActionState(pWti, pThis) == ACT_STATE_RTRY) {
+		if(pThis->bCircuitBreaker) {
+			actionDoRetryCircuit(pThis, pWti);
+			continue;
+		}
 		DBGPRINTF("actionDoRetry: %s enter loop, iRetries=%d, ResumeInRow %d\n",
 			pThis->pszName, iRetries, getActionResumeInRow(pWti, pThis));
 			iRet = pThis->pMod->tryResume(pWti->actWrkrInfo[pThis->iActionNbr].actWrkrData);
@@ -1024,8 +1367,11 @@ actionTryResume(action_t * const pThis, wti_t * const pWti)
 		 * is always in the past. So we can not avoid doing a fresh time() call
 		 * here. -- rgerhards, 2009-03-18
 		 */
-		datetime.GetTime(&ttNow); /* cache "now" */
-		if(ttNow >= pThis->ttResumeRtry) {
+		if(pThis->bCircuitBreaker) {
+			/* the prober tells us when it is time to try again */
+			if(pThis->circuitState == ACT_CIRCUIT_CLOSED)
+				actionSetState(pThis, pWti, ACT_STATE_RTRY);
+		} else if(datetime.GetTime(&ttNow) >= pThis->ttResumeRtry) {
 			actionSetState(pThis, pWti, ACT_STATE_RTRY); /* back to retries */
 		}
 	}
@@ -1113,6 +1459,7 @@ prepareDoActionParams(action_t * __restrict__ const pAction,
 			CHKiRet(tplToString(pAction->ppTpl[i], pMsg,
 					    &actParam(iparams, pAction->iNumTpls, 0, i),
 				            ttNow));
+			pWrkrInfo->p.tx.lingerBytes += actParam(iparams, pAction->iNumTpls, 0, i).lenStr;
 		}
 	} else {
 		for(i = 0 ; i < pAction->iNumTpls ; ++i) {
@@ -1480,10 +1827,9 @@ done:
 
 static rsRetVal
 actionTryRemoveHardErrorsFromBatch(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti,
+	actWrkrIParams_t *const txParams, const unsigned nMsgs,
 	actWrkrIParams_t *const new_iparams, unsigned *new_nMsgs)
 {
-	actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
-	const unsigned nMsgs = wrkrInfo->p.tx.currIParam;
 	actWrkrIParams_t oneParamSet[CONF_OMOD_NUMSTRINGS_MAXSIZE];
 	rsRetVal ret;
 	DEFiRet;
@@ -1491,7 +1837,7 @@ actionTryRemoveHardErrorsFromBatch(action_t *__restrict__ const pThis, wti_t *__
 	*new_nMsgs = 0;
 	for(unsigned i = 0 ; i < nMsgs ; ++i) {
 		setActionResumeInRow(pWti, pThis, 0); // make sure we do not trigger OK-as-SUSPEND handling
-		memcpy(&oneParamSet, &actParam(wrkrInfo->p.tx.iparams, pThis->iNumTpls, i, 0),
+		memcpy(&oneParamSet, &actParam(txParams, pThis->iNumTpls, i, 0),
 			sizeof(actWrkrIParams_t) * pThis->iNumTpls);
 		ret = actionTryCommit(pThis, pWti, oneParamSet, 1);
 		if(ret == RS_RET_SUSPENDED) {
@@ -1505,29 +1851,25 @@ actionTryRemoveHardErrorsFromBatch(action_t *__restrict__ const pThis, wti_t *__
 	RETiRet;
 }
 
-/* Note: we currently need to return an iRet, as this is used in
- * direct mode. TODO: However, it may be worth further investigating this,
- * as it looks like there is no ultimate consumer of this code.
- * rgerhards, 2013-11-06
+/* synchronously commit a set of transaction parameters, including retry
+ * and error file processing. This is used for the worker's current
+ * transaction as well as for async transactions that did not succeed.
  */
 static rsRetVal ATTR_NONNULL()
-actionCommit(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti)
+actionCommitParams(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti,
+	actWrkrIParams_t *const txParams, const unsigned nTxMsgs)
 {
-	actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
 	/* Variables that permit us to override the batch of messages */
 	unsigned nMsgs;
 	actWrkrIParams_t *iparams = NULL;
 	int needfree_iparams = 0; // work-around for clang static analyzer false positive
 	DEFiRet;
 
-	DBGPRINTF("actionCommit[%s]: enter, %d msgs\n", pThis->pszName, wrkrInfo->p.tx.currIParam);
-	if(!pThis->isTransactional || pWti->actWrkrInfo[pThis->iActionNbr].p.tx.currIParam == 0) {
-		FINALIZE;
-	} else if(getActionState(pWti, pThis) == ACT_STATE_SUSP) {
+	if(getActionState(pWti, pThis) == ACT_STATE_SUSP) {
 		/* if we are suspended, we already tried everything to recover the
 		 * action - and failed. So all we can do here is write the error file.
 		 */
-		actionWriteErrorFile(pThis, iRet, wrkrInfo->p.tx.iparams, wrkrInfo->p.tx.currIParam);
+		actionWriteErrorFile(pThis, iRet, txParams, nTxMsgs);
 		FINALIZE;
 	}
 	DBGPRINTF("actionCommit[%s]: processing...\n", pThis->pszName);
@@ -1539,7 +1881,7 @@ actionCommit(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti)
 	 * than configured (if temporary failure), but this unavoidable and should
 	 * do no real harm. - rgerhards, 2017-10-06
 	 */
-	iRet = actionTryCommit(pThis, pWti, wrkrInfo->p.tx.iparams, wrkrInfo->p.tx.currIParam);
+	iRet = actionTryCommit(pThis, pWti, txParams, nTxMsgs);
 DBGPRINTF("actionCommit[%s]: return actionTryCommit %d\n", pThis->pszName, iRet);
 	if(iRet == RS_RET_OK) {
 		FINALIZE;
@@ -1549,21 +1891,20 @@ DBGPRINTF("actionCommit[%s]: return actionTryCommit %d\n", pThis->pszName, iRet)
 	 * are done. If it is a multi-message batch, we need to sort out the individual
 	 * message states.
 	 */
-	if(wrkrInfo->p.tx.currIParam == 1) {
+	if(nTxMsgs == 1) {
 		needfree_iparams = 0;
-		iparams = wrkrInfo->p.tx.iparams;
-		nMsgs = wrkrInfo->p.tx.currIParam;
+		iparams = txParams;
+		nMsgs = nTxMsgs;
 		if(iRet == RS_RET_DATAFAIL) {
 			FINALIZE;
 		}
 	} else {
 		DBGPRINTF("actionCommit[%s]: somewhat unhappy, full batch of %d msgs returned "
 			"status %d. Trying messages as individual actions.\n",
-			pThis->pszName, wrkrInfo->p.tx.currIParam, iRet);
-		CHKmalloc(iparams = malloc(sizeof(actWrkrIParams_t) * pThis->iNumTpls
-			* wrkrInfo->p.tx.currIParam));
+			pThis->pszName, nTxMsgs, iRet);
+		CHKmalloc(iparams = malloc(sizeof(actWrkrIParams_t) * pThis->iNumTpls * nTxMsgs));
 		needfree_iparams = 1;
-		actionTryRemoveHardErrorsFromBatch(pThis, pWti, iparams, &nMsgs);
+		actionTryRemoveHardErrorsFromBatch(pThis, pWti, txParams, nTxMsgs, iparams, &nMsgs);
 	}
 
 	if(nMsgs == 0) {
@@ -1608,10 +1949,337 @@ finalize_it:
 	if(needfree_iparams) {
 		free(iparams);
 	}
+	RETiRet;
+}
+
+
+/* an asynchronous transaction, owns the parameter buffers of its batch */
+typedef struct actAsyncTx_s {
+	action_t *pAction;
+	wti_t *pWti;
+	actWrkrIParams_t *iparams;
+	unsigned nParams;	/* number of messages in transaction */
+	int nAlloc;		/* number of allocated parameter sets (for freeing) */
+	rsRetVal status;	/* completion status as reported by module */
+	struct actAsyncTx_s *next;
+} actAsyncTx_t;
+
+static void
+actionAsyncTxDestruct(actAsyncTx_t *const tx)
+{
+	int i, j;
+
+	for(i = 0 ; i < tx->nAlloc ; ++i) {
+		for(j = 0 ; j < tx->pAction->iNumTpls ; ++j) {
+			free(actParam(tx->iparams, tx->pAction->iNumTpls, i, j).param);
+		}
+	}
+	free(tx->iparams);
+	free(tx);
+}
+
+/* completion callback handed to the module's pollCompletions(). We only
+ * record the result here; processing is done once pollCompletions()
+ * returned, so that the module is never re-entered from its own callback.
+ */
+static void
+actionAsyncCompleted(void *const pCookie, const rsRetVal status)
+{
+	actAsyncTx_t *const tx = (actAsyncTx_t*) pCookie;
+	actWrkrInfo_t *const wrkrInfo = &(tx->pWti->actWrkrInfo[tx->pAction->iActionNbr]);
+
+	tx->status = status;
+	tx->next = wrkrInfo->asyncDone;
+	wrkrInfo->asyncDone = tx;
+}
+
+/* poll the module for completed async transactions and process them.
+ * Failed transactions are committed again synchronously, which provides
+ * the regular retry, suspension and error file handling.
+ */
+static void ATTR_NONNULL()
+actionPollAsync(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti, const int timeoutMs)
+{
+	actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
+	actAsyncTx_t *tx;
+	rsRetVal localRet;
+
+	localRet = pThis->pMod->mod.om.pollCompletions(wrkrInfo->actWrkrData, timeoutMs, actionAsyncCompleted);
+	if(localRet != RS_RET_OK) {
+		DBGPRINTF("action '%s': pollCompletions returned %d\n", pThis->pszName, localRet);
+	}
+	while((tx = wrkrInfo->asyncDone) != NULL) {
+		wrkrInfo->asyncDone = tx->next;
+		--wrkrInfo->nAsyncInflight;
+		if(tx->status == RS_RET_OK) {
+			actionSetActionWorked(pThis, pWti);
+		} else {
+			DBGPRINTF("action '%s': async transaction of %u msgs failed with %d, "
+				"committing synchronously\n", pThis->pszName, tx->nParams, tx->status);
+			actionCommitParams(pThis, pWti, tx->iparams, tx->nParams);
+		}
+		actionAsyncTxDestruct(tx);
+	}
+}
+
+/* A batch whose messages are part of a still in-flight async transaction
+ * must not be deleted from the queue. So we keep these messages in state
+ * SUB and hold the batch back (pWti->bBatchHold). Once all transactions
+ * of the worker have completed, the messages are set to COMM and the held
+ * batches are released. If we need to terminate before, the queue
+ * re-enqueues the SUB messages when it deletes the batches, so they are
+ * not lost.
+ */
+static void
+actionAsyncSetBatchState(batch_t *const pBatch, const int fromState, const int toState)
+{
+	int i;
+
+	for(i = 0 ; i < pBatch->nElem ; ++i) {
+		if(pBatch->eltState[i] == fromState)
+			pBatch->eltState[i] = toState;
+	}
+}
+
+static void ATTR_NONNULL()
+actionAsyncReleaseBatches(wti_t *__restrict__ const pWti)
+{
+	heldBatch_t *pHeld;
+
+	for(pHeld = pWti->pHeldRoot ; pHeld != NULL ; pHeld = pHeld->pNext)
+		actionAsyncSetBatchState(&pHeld->batch, BATCH_STATE_SUB, BATCH_STATE_COMM);
+	actionAsyncSetBatchState(&pWti->batch, BATCH_STATE_SUB, BATCH_STATE_COMM);
+	pWti->bBatchHold = 0;
+}
+
+/* hand the worker's current transaction over to an async output module.
+ * On success, the in-flight transaction owns the parameter buffers and the
+ * worker allocates new ones for the next batch. If the transaction cannot
+ * be submitted, an error is returned and the caller commits synchronously.
+ */
+static rsRetVal ATTR_NONNULL()
+actionCommitAsync(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti)
+{
+	actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
+	actAsyncTx_t *tx = NULL;
+	DEFiRet;
+
+	while(wrkrInfo->nAsyncInflight >= pThis->iMaxInflight) {
+		if(*pWti->pbShutdownImmediate)
+			ABORT_FINALIZE(RS_RET_FORCE_TERM);
+		actionPollAsync(pThis, pWti, 1000);
+	}
+	if(getActionState(pWti, pThis) == ACT_STATE_SUSP)
+		ABORT_FINALIZE(RS_RET_SUSPENDED);
+	CHKiRet(actionPrepare(pThis, pWti));
+	if(getActionState(pWti, pThis) != ACT_STATE_ITX)
+		ABORT_FINALIZE(RS_RET_SUSPENDED);
+
+	CHKmalloc(tx = calloc(1, sizeof(actAsyncTx_t)));
+	tx->pAction = pThis;
+	tx->pWti = pWti;
+	tx->iparams = wrkrInfo->p.tx.iparams;
+	tx->nParams = wrkrInfo->p.tx.currIParam;
+	tx->nAlloc = wrkrInfo->p.tx.maxIParams;
+	CHKiRet(pThis->pMod->mod.om.submitAsync(wrkrInfo->actWrkrData, tx->iparams, tx->nParams, tx));
+
+	wrkrInfo->p.tx.iparams = NULL;
+	wrkrInfo->p.tx.maxIParams = 0;
+	++wrkrInfo->nAsyncInflight;
+	/* the worker's transaction is closed, but NOT yet committed: that is only
+	 * known when the module reports completion (see actionPollAsync()).
+	 */
+	actionSetState(pThis, pWti, ACT_STATE_RDY);
+	tx = NULL; /* now owned by module until completion */
+
+	/* pick up whatever is already done */
+	actionPollAsync(pThis, pWti, 0);
+
+finalize_it:
+	if(iRet != RS_RET_OK) {
+		DBGPRINTF("action '%s': async submission not possible, iRet %d\n", pThis->pszName, iRet);
+	}
+	free(tx); /* only set if not submitted, buffers still owned by worker */
+	RETiRet;
+}
+
+/* check if the worker has async transactions which are not yet completed */
+int ATTR_NONNULL()
+actionHasAsyncInflight(wti_t *__restrict__ const pWti)
+{
+	int i;
+
+	for(i = 0 ; i < iActionNbr ; ++i) {
+		if(pWti->actWrkrInfo[i].nAsyncInflight > 0)
+			return 1;
+	}
+	return 0;
+}
+
+/* wait until all async transactions of a worker are completed and then
+ * release the batches held for them. This is called when the worker becomes
+ * idle, before it terminates and when too many batches are held. On
+ * immediate shutdown we stop waiting; the batches then stay uncommitted
+ * and their messages are re-enqueued by the queue.
+ */
+void ATTR_NONNULL()
+actionDrainAsync(wti_t *__restrict__ const pWti)
+{
+	int i;
+	int bHasAsync = 0;
+	actWrkrInfo_t *wrkrInfo;
+
+	for(i = 0 ; i < iActionNbr ; ++i) {
+		wrkrInfo = &(pWti->actWrkrInfo[i]);
+		if(wrkrInfo->pAction != NULL && wrkrInfo->pAction->iMaxInflight > 0)
+			bHasAsync = 1;
+		while(wrkrInfo->nAsyncInflight > 0 && !*pWti->pbShutdownImmediate) {
+			actionPollAsync(wrkrInfo->pAction, pWti, 1000);
+		}
+	}
+	/* note: linger holds batches as well, but is never used together with
+	 * async transactions, so we must not touch its hold.
+	 */
+	if(bHasAsync && pWti->bBatchHold && !actionHasAsyncInflight(pWti))
+		actionAsyncReleaseBatches(pWti);
+}
+
+/* called after a batch was processed by an action with async transactions.
+ * Holds the batch while its messages are in flight, but never more batches
+ * than transactions may be in flight - otherwise a constantly busy worker
+ * would never release any of them.
+ */
+static void ATTR_NONNULL()
+actionAsyncHoldBatch(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti,
+	batch_t *__restrict__ const pBatch)
+{
+	heldBatch_t *pHeld;
+	int nHeld = 0;
+
+	if(pWti->actWrkrInfo[pThis->iActionNbr].nAsyncInflight == 0) {
+		actionAsyncReleaseBatches(pWti);
+		return;
+	}
+	actionAsyncSetBatchState(pBatch, BATCH_STATE_COMM, BATCH_STATE_SUB);
+	pWti->bBatchHold = 1;
+	for(pHeld = pWti->pHeldRoot ; pHeld != NULL ; pHeld = pHeld->pNext)
+		++nHeld;
+	if(nHeld >= pThis->iMaxInflight)
+		actionDrainAsync(pWti);
+}
+
+/* Note: we currently need to return an iRet, as this is used in
+ * direct mode. TODO: However, it may be worth further investigating this,
+ * as it looks like there is no ultimate consumer of this code.
+ * rgerhards, 2013-11-06
+ */
+static rsRetVal ATTR_NONNULL()
+actionCommit(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti)
+{
+	actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
+	DEFiRet;
+
+	DBGPRINTF("actionCommit[%s]: enter, %d msgs\n", pThis->pszName, wrkrInfo->p.tx.currIParam);
+	if(!pThis->isTransactional || wrkrInfo->p.tx.currIParam == 0) {
+		FINALIZE;
+	}
+	if(pThis->iMaxInflight > 0 && pThis->pQueue->qType != QUEUETYPE_DIRECT
+	   && actionCommitAsync(pThis, pWti) == RS_RET_OK) {
+		FINALIZE;
+	}
+	iRet = actionCommitParams(pThis, pWti, wrkrInfo->p.tx.iparams, wrkrInfo->p.tx.currIParam);
+
+finalize_it:
 	wrkrInfo->p.tx.currIParam = 0; /* reset to beginning */
+	if(pThis->isTransactional) {
+		wrkrInfo->p.tx.lingerBytes = 0;
+		wrkrInfo->p.tx.lingerStart = 0;
+	}
 	RETiRet;
 }
 
+/* support for action.linger.*: transactions are kept open across dequeue
+ * batches until they are large or old enough. The queue holds back deletion
+ * of the batches in question (wti->bBatchHold) until the commit is done, so
+ * we do not lose messages on a crash.
+ */
+static long long
+lingerNowMs(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* check if the open transaction shall be kept open after the current batch */
+static int ATTR_NONNULL()
+actionMustLinger(action_t *__restrict__ const pThis, wti_t *__restrict__ const pWti)
+{
+	actWrkrInfo_t *const wrkrInfo = &(pWti->actWrkrInfo[pThis->iActionNbr]);
+	long long now;
+
+	if(wrkrInfo->p.tx.currIParam == 0 || *pWti->pbShutdownImmediate)
+		return 0;
+	if(pThis->iLingerBytes > 0 && wrkrInfo->p.tx.lingerBytes >= (size_t) pThis->iLingerBytes)
+		return 0;
+	now = lingerNowMs();
+	if(wrkrInfo->p.tx.lingerStart == 0)
+		wrkrInfo->p.tx.lingerStart = now;
+	return now - wrkrInfo->p.tx.lingerStart < pThis->iLingerMs;
+}
+
+/* check if the worker has a lingering transaction. If so, 1 is returned and
+ * pTimeout is set to the absolute time at which it must be committed.
+ */
+int ATTR_NONNULL()
+actionGetLingerTimeout(wti_t *__restrict__ const pWti, struct timespec *const pTimeout)
+{
+	actWrkrInfo_t *wrkrInfo;
+	long long remain;
+	long long minRemain = -1;
+	int i;
+
+	if(!pWti->bBatchHold)
+		return 0;
+	for(i = 0 ; i < iActionNbr ; ++i) {
+		wrkrInfo = &(pWti->actWrkrInfo[i]);
+		if(wrkrInfo->actWrkrData == NULL || wrkrInfo->pAction->iLingerMs == 0
+		   || wrkrInfo->p.tx.currIParam == 0)
+			continue;
+		remain = wrkrInfo->pAction->iLingerMs - (lingerNowMs() - wrkrInfo->p.tx.lingerStart);
+		if(remain < 0)
+			remain = 0;
+		if(minRemain == -1 || remain < minRemain)
+			minRemain = remain;
+	}
+	if(minRemain == -1)
+		return 0;
+	timeoutComp(pTimeout, (long) minRemain);
+	return 1;
+}
+
+/* commit all lingering transactions of a worker, e.g. because the queue
+ * ran empty or the worker is about to terminate.
+ */
+void ATTR_NONNULL()
+actionFlushLinger(wti_t *__restrict__ const pWti)
+{
+	actWrkrInfo_t *wrkrInfo;
+	int i;
+
+	if(!pWti->bBatchHold)
+		return;
+	for(i = 0 ; i < iActionNbr ; ++i) {
+		wrkrInfo = &(pWti->actWrkrInfo[i]);
+		if(wrkrInfo->actWrkrData != NULL && wrkrInfo->pAction->iLingerMs > 0) {
+			DBGPRINTF("actionFlushLinger[%s]: committing %d msgs\n",
+				wrkrInfo->pAction->pszName, wrkrInfo->p.tx.currIParam);
+			actionCommit(wrkrInfo->pAction, pWti);
+		}
+	}
+	pWti->bBatchHold = 0;
+}
+
 /* Commit all active transactions in *DIRECT mode* */
 void ATTR_NONNULL()
 actionCommitAllDirect(wti_t *__restrict__ const pWti)
@@ -1632,6 +2300,19 @@ actionCommitAllDirect(wti_t *__restrict__ const pWti)
 	}
 }
 
+/* Commit the active transaction of a single action in *DIRECT mode*.
+ * This is used by rulesets which commit their actions in parallel. Besides
+ * the action's own actWrkrInfo entry, the commit modifies the execution
+ * state of pWti. So for concurrent calls on different actions of the same
+ * worker, each caller must pass its own wti which shares actWrkrInfo only.
+ */
+void ATTR_NONNULL()
+actionCommitDirect(action_t *__restrict__ const pAction, wti_t *__restrict__ const pWti)
+{
+	if(pAction->pQueue->qType == QUEUETYPE_DIRECT)
+		actionCommit(pAction, pWti);
+}
+
 /* process a single message. This is both called if we run from the
  * consumer side of an action queue as well as directly from the main
  * queue thread if the action queue is set to "direct".
@@ -1700,7 +2381,17 @@ processBatchMain(void *__restrict__ const pVoid,
 		}
 	}
 
+	if(pAction->iLingerMs > 0 && actionMustLinger(pAction, pWti)) {
+		/* keep transaction open, the queue must not yet delete this batch */
+		pWti->bBatchHold = 1;
+		FINALIZE;
+	}
+
 	iRet = actionCommit(pAction, pWti);
+	pWti->bBatchHold = 0;
+	if(pAction->iMaxInflight > 0)
+		actionAsyncHoldBatch(pAction, pWti, pBatch);
+finalize_it:
 	RETiRet;
 }
 
@@ -2073,6 +2764,14 @@ actionApplyCnfParam(action_t * const pAction, struct cnfparamvals * const pvals)
 			pAction->iResumeInterval = pvals[i].val.d.n;
 		} else if(!strcmp(pblk.descr[i].name, "action.resumeintervalMax")) {
 			pAction->iResumeIntervalMax = pvals[i].val.d.n;
+		} else if(!strcmp(pblk.descr[i].name, "action.maxinflight")) {
+			pAction->iMaxInflight = pvals[i].val.d.n;
+		} else if(!strcmp(pblk.descr[i].name, "action.circuitbreaker")) {
+			pAction->bCircuitBreaker = (sbool) pvals[i].val.d.n;
+		} else if(!strcmp(pblk.descr[i].name, "action.linger.ms")) {
+			pAction->iLingerMs = pvals[i].val.d.n;
+		} else if(!strcmp(pblk.descr[i].name, "action.linger.bytes")) {
+			pAction->iLingerBytes = pvals[i].val.d.n;
 		} else {
 			dbgprintf("action: program error, non-handled "
 			  "param '%s'\n", pblk.descr[i].name);
@@ -58,6 +58,15 @@ struct action_s {
 	int	iNbrNoExec;	/* number of matches that did not yet yield to an exec */
 	int	iExecEveryNthOccur;/* execute this action only every n-th occurence (with n=0,1 -> always) */
 	int  	iExecEveryNthOccurTO;/* timeout for n-th occurence feature */
+	int	iMaxInflight;	/* max async transactions in flight per worker, 0 --> synchronous */
+	int	iLingerMs;	/* max time to keep a transaction open across batches, 0 --> off */
+	int	iLingerBytes;	/* commit lingering transaction once it reaches this size, 0 --> unlimited */
+	sbool	bCircuitBreaker;/* resume probing is done by the background prober, not by workers */
+	int	circuitState;	/* ACT_CIRCUIT_* - shared by all workers, written under mutCircuit */
+	int	circuitBackoff;	/* current probe interval in seconds */
+	time_t	ttCircuitProbe;	/* when the prober shall try next */
+	time_t	ttCircuitClosed;/* when the circuit was last closed */
+	void	*circuitWrkrData;/* the prober's own worker instance */
 	time_t  tLastOccur;	/* time last occurence was seen (for timing them out) */
 	struct modInfo_s *pMod;/* pointer to output module handling this selector */
 	void	*pModData;	/* pointer to module data - content is module-specific */
@@ -92,8 +101,15 @@ struct action_s {
 	STATSCOUNTER_DEF(ctrSuspend, mutCtrSuspend)
 	STATSCOUNTER_DEF(ctrSuspendDuration, mutCtrSuspendDuration)
 	STATSCOUNTER_DEF(ctrResume, mutCtrResume)
+	STATSCOUNTER_DEF(ctrCircuitOpened, mutCtrCircuitOpened)
+	STATSCOUNTER_DEF(ctrCircuitProbes, mutCtrCircuitProbes)
 };
 
+/* circuit breaker states, values are visible via impstats */
+#define ACT_CIRCUIT_CLOSED 0
+#define ACT_CIRCUIT_OPEN 1
+#define ACT_CIRCUIT_HALFOPEN 2
+
 
 /* function prototypes
  */
@@ -111,6 +127,11 @@ rsRetVal activateActions(void);
 rsRetVal actionNewInst(struct nvlst *lst, action_t **ppAction);
 rsRetVal actionProcessCnf(struct cnfobj *o);
 void actionCommitAllDirect(wti_t *pWti);
+void actionCommitDirect(action_t *pAction, wti_t *pWti);
+int actionHasAsyncInflight(wti_t *pWti);
+void actionDrainAsync(wti_t *pWti);
+int actionGetLingerTimeout(wti_t *pWti, struct timespec *pTimeout);
+void actionFlushLinger(wti_t *pWti);
 void actionRemoveWorker(action_t *const pAction, void *const actWrkrData);
 void releaseDoActionParams(action_t * const pAction, wti_t * const pWti, int action_destruct);
 
@@ -349,11 +349,11 @@ finalize_it:
 
 
 static struct scriptFunct functions[] = {
-		{"hash64", 1, 2, fmHashXX, init_fmHash64, NULL},
-		{"hash64mod", 2, 3, fmHashXXmod, init_fmHash64mod, NULL},
-		{"hash32", 1, 2, fmHashXX, init_fmHash32, NULL},
-		{"hash32mod", 2, 3, fmHashXXmod, init_fmHash32mod, NULL},
-		{NULL, 0, 0, NULL, NULL, NULL} //last element to check end of array
+		{"hash64", 1, 2, fmHashXX, init_fmHash64, NULL, SCRIPTFUNC_PURE},
+		{"hash64mod", 2, 3, fmHashXXmod, init_fmHash64mod, NULL, SCRIPTFUNC_PURE},
+		{"hash32", 1, 2, fmHashXX, init_fmHash32, NULL, SCRIPTFUNC_PURE},
+		{"hash32mod", 2, 3, fmHashXXmod, init_fmHash32mod, NULL, SCRIPTFUNC_PURE},
+		{NULL, 0, 0, NULL, NULL, NULL, 0} //last element to check end of array
 };
 
 
@@ -2731,6 +2731,10 @@ doFuncCall(struct cnffunc *__restrict__ const func, struct svar *__restrict__ co
 		ret->d.n = 0;
 	} else {
 		func->fPtr(func, ret, usrptr, pWti);
+		if(!(func->flags & SCRIPTFUNC_PURE)) {
+			/* function may have modified the message or variables */
+			wtiInvalidateExprCache(pWti);
+		}
 	}
 }
 
@@ -3298,7 +3302,12 @@ cnfexprEval(const struct cnfexpr *__restrict__ const expr,
 		ret->d.estr = es_strdup(((struct cnfarray*)expr)->arr[0]);
 		break;
 	case 'V':
-		evalVar((struct cnfvar*)expr, usrptr, ret);
+		if(((struct cnfvar*)expr)->cacheIdx == -1) {
+			evalVar((struct cnfvar*)expr, usrptr, ret);
+		} else if(!wtiGetExprCache(pWti, ((struct cnfvar*)expr)->cacheIdx, ret)) {
+			evalVar((struct cnfvar*)expr, usrptr, ret);
+			wtiSetExprCache(pWti, ((struct cnfvar*)expr)->cacheIdx, ret);
+		}
 		break;
 	case '&':
 		/* TODO: think about optimization, should be possible ;) */
@@ -3334,7 +3343,12 @@ cnfexprEval(const struct cnfexpr *__restrict__ const expr,
 		varFreeMembers(&r);
 		break;
 	case 'F':
-		doFuncCall((struct cnffunc*) expr, ret, usrptr, pWti);
+		if(((struct cnffunc*)expr)->cacheIdx == -1) {
+			doFuncCall((struct cnffunc*) expr, ret, usrptr, pWti);
+		} else if(!wtiGetExprCache(pWti, ((struct cnffunc*)expr)->cacheIdx, ret)) {
+			doFuncCall((struct cnffunc*) expr, ret, usrptr, pWti);
+			wtiSetExprCache(pWti, ((struct cnffunc*)expr)->cacheIdx, ret);
+		}
 		break;
 	default:
 		ret->datatype = 'N';
@@ -3547,35 +3561,35 @@ static struct modListNode *modListRoot = NULL;
 static struct modListNode *modListLast = NULL;
 
 static struct scriptFunct functions[] = {
-	{"strlen", 1, 1, doFunct_StrLen, NULL, NULL},
-	{"getenv", 1, 1, doFunct_Getenv, NULL, NULL},
-	{"num2ipv4", 1, 1, doFunct_num2ipv4, NULL, NULL},
-	{"int2hex", 1, 1, doFunct_Int2Hex, NULL, NULL},
-	{"substring", 3, 3, doFunct_Substring, NULL, NULL},
-	{"ltrim", 1, 1, doFunct_LTrim, NULL, NULL},
-	{"rtrim", 1, 1, doFunct_RTrim, NULL, NULL},
-	{"tolower", 1, 1, doFunct_ToLower, NULL, NULL},
-	{"cstr", 1, 1, doFunct_CStr, NULL, NULL},
-	{"cnum", 1, 1, doFunct_CNum, NULL, NULL},
-	{"ip42num", 1, 1, doFunct_Ipv42num, NULL, NULL},
-	{"ipv42num", 1, 1, doFunct_Ipv42num, NULL, NULL},
-	{"re_match", 2, 2, doFunct_ReMatch, initFunc_re_match, regex_destruct},
-	{"re_extract", 5, 5, doFunc_re_extract, initFunc_re_match, regex_destruct},
-	{"field", 3, 3, doFunct_Field, NULL, NULL},
-	{"exec_template", 1, 1, doFunc_exec_template, initFunc_exec_template, NULL},
-	{"prifilt", 1, 1, doFunct_Prifilt, initFunc_prifilt, NULL},
-	{"lookup", 2, 2, doFunct_Lookup, resolveLookupTable, NULL},
-	{"dyn_inc", 2, 2, doFunct_DynInc, initFunc_dyn_stats, NULL},
-	{"replace", 3, 3, doFunct_Replace, NULL, NULL},
-	{"wrap", 2, 3, doFunct_Wrap, NULL, NULL},
-	{"random", 1, 1, doFunct_RandomGen, NULL, NULL},
-	{"format_time", 2, 2, doFunct_FormatTime, NULL, NULL},
-	{"parse_time", 1, 1, doFunct_ParseTime, NULL, NULL},
-	{"is_time", 1, 2, doFunct_IsTime, NULL, NULL},
-	{"parse_json", 2, 2, doFunc_parse_json, NULL, NULL},
-	{"script_error", 0, 0, doFunct_ScriptError, NULL, NULL},
-	{"previous_action_suspended", 0, 0, doFunct_PreviousActionSuspended, NULL, NULL},
-	{NULL, 0, 0, NULL, NULL, NULL} //last element to check end of array
+	{"strlen", 1, 1, doFunct_StrLen, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"getenv", 1, 1, doFunct_Getenv, NULL, NULL, SCRIPTFUNC_PURE},
+	{"num2ipv4", 1, 1, doFunct_num2ipv4, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"int2hex", 1, 1, doFunct_Int2Hex, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"substring", 3, 3, doFunct_Substring, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"ltrim", 1, 1, doFunct_LTrim, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"rtrim", 1, 1, doFunct_RTrim, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"tolower", 1, 1, doFunct_ToLower, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"cstr", 1, 1, doFunct_CStr, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"cnum", 1, 1, doFunct_CNum, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"ip42num", 1, 1, doFunct_Ipv42num, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"ipv42num", 1, 1, doFunct_Ipv42num, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"re_match", 2, 2, doFunct_ReMatch, initFunc_re_match, regex_destruct, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"re_extract", 5, 5, doFunc_re_extract, initFunc_re_match, regex_destruct, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"field", 3, 3, doFunct_Field, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"exec_template", 1, 1, doFunc_exec_template, initFunc_exec_template, NULL, SCRIPTFUNC_PURE},
+	{"prifilt", 1, 1, doFunct_Prifilt, initFunc_prifilt, NULL, SCRIPTFUNC_PURE},
+	{"lookup", 2, 2, doFunct_Lookup, resolveLookupTable, NULL, SCRIPTFUNC_PURE},
+	{"dyn_inc", 2, 2, doFunct_DynInc, initFunc_dyn_stats, NULL, 0},
+	{"replace", 3, 3, doFunct_Replace, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"wrap", 2, 3, doFunct_Wrap, NULL, NULL, SCRIPTFUNC_PURE|SCRIPTFUNC_CONSTFOLD},
+	{"random", 1, 1, doFunct_RandomGen, NULL, NULL, 0},
+	{"format_time", 2, 2, doFunct_FormatTime, NULL, NULL, SCRIPTFUNC_PURE},
+	{"parse_time", 1, 1, doFunct_ParseTime, NULL, NULL, 0},
+	{"is_time", 1, 2, doFunct_IsTime, NULL, NULL, 0},
+	{"parse_json", 2, 2, doFunc_parse_json, NULL, NULL, 0},
+	{"script_error", 0, 0, doFunct_ScriptError, NULL, NULL, 0},
+	{"previous_action_suspended", 0, 0, doFunct_PreviousActionSuspended, NULL, NULL, 0},
+	{NULL, 0, 0, NULL, NULL, NULL, 0} //last element to check end of array
 };
 
 static rscriptFuncPtr ATTR_NONNULL()
@@ -4117,11 +4131,45 @@ cnfvarNew(char *name)
 	if((var = malloc(sizeof(struct cnfvar))) != NULL) {
 		var->nodetype = 'V';
 		var->name = name;
+		var->cacheIdx = -1;
 		msgPropDescrFill(&var->prop, (uchar*)var->name, strlen(var->name));
 	}
 	return var;
 }
 
+/* The lexer frees the name of an include file after it has been
+ * processed. As statements need to reference their config file for
+ * their whole lifetime (e.g. for profiling), we keep a copy of each
+ * file name here. The list is small and never freed.
+ */
+struct cnfFileName {
+	char *name;
+	struct cnfFileName *next;
+};
+static struct cnfFileName *cnfFileNames = NULL;
+
+static const char *
+cnfGetSharedFileName(const char *const name)
+{
+	struct cnfFileName *fn;
+
+	if(name == NULL)
+		return NULL;
+	for(fn = cnfFileNames ; fn != NULL ; fn = fn->next) {
+		if(!strcmp(fn->name, name))
+			return fn->name;
+	}
+	if((fn = malloc(sizeof(struct cnfFileName))) == NULL)
+		return NULL;
+	if((fn->name = strdup(name)) == NULL) {
+		free(fn);
+		return NULL;
+	}
+	fn->next = cnfFileNames;
+	cnfFileNames = fn;
+	return fn->name;
+}
+
 struct cnfstmt *
 cnfstmtNew(unsigned s_type)
 {
@@ -4130,6 +4178,9 @@ cnfstmtNew(unsigned s_type)
 		cnfstmt->nodetype = s_type;
 		cnfstmt->printable = NULL;
 		cnfstmt->next = NULL;
+		cnfstmt->srcFile = cnfGetSharedFileName(cnfcurrfn);
+		cnfstmt->srcLine = yylineno;
+		cnfstmt->prof = NULL;
 	}
 	return cnfstmt;
 }
@@ -4213,6 +4264,8 @@ cnfstmtDestruct(struct cnfstmt *stmt)
 			(unsigned) stmt->nodetype);
 		break;
 	}
+	if(stmt->prof != NULL)
+		rulesetDestructStmtProf(stmt->prof);
 	free(stmt->printable);
 	free(stmt);
 }
@@ -4467,8 +4520,8 @@ static int
 getConstNumber(struct cnfexpr *expr, long long *l, long long *r)
 {
 	int ret = 0;
-	cnfexprOptimize(expr->l);
-	cnfexprOptimize(expr->r);
+	expr->l = cnfexprOptimize(expr->l);
+	expr->r = cnfexprOptimize(expr->r);
 	if(expr->l->nodetype == 'N') {
 		if(expr->r->nodetype == 'N') {
 			ret = 1;
@@ -4507,8 +4560,8 @@ static void
 constFoldConcat(struct cnfexpr *expr)
 {
 	es_str_t *estr;
-	cnfexprOptimize(expr->l);
-	cnfexprOptimize(expr->r);
+	expr->l = cnfexprOptimize(expr->l);
+	expr->r = cnfexprOptimize(expr->r);
 	if(expr->l->nodetype == 'S') {
 		if(expr->r->nodetype == 'S') {
 			estr = ((struct cnfstringval*)expr->l)->estr;
@@ -4553,6 +4606,59 @@ constFoldConcat(struct cnfexpr *expr)
 }
 
 
+/* constant folding for function calls. Functions flagged SCRIPTFUNC_CONSTFOLD
+ * do not access the message or worker state, so if all parameters are
+ * constants we can call them once at config load and replace the call
+ * by its result. The dummy wti and message pointer are only passed to
+ * satisfy the function interface, they are never accessed.
+ */
+static struct cnfexpr*
+constFoldFunc(struct cnffunc *const func)
+{
+	struct cnfexpr *expr = (struct cnfexpr*) func;
+	struct svar ret;
+	wti_t dummyWti;
+	unsigned short i;
+
+	for(i = 0 ; i < func->nParams ; ++i) {
+		func->expr[i] = cnfexprOptimize(func->expr[i]);
+	}
+
+	if(!(func->flags & SCRIPTFUNC_CONSTFOLD) || func->fPtr == NULL)
+		goto done;
+	for(i = 0 ; i < func->nParams ; ++i) {
+		if(func->expr[i]->nodetype != 'N' && func->expr[i]->nodetype != 'S')
+			goto done;
+	}
+
+	/* constant-foldable functions never access the message */
+	memset(&dummyWti, 0, sizeof(dummyWti));
+	func->fPtr(func, &ret, NULL, &dummyWti);
+	if(ret.datatype == 'N') {
+		expr = (struct cnfexpr*) cnfnumvalNew(ret.d.n);
+	} else if(ret.datatype == 'S') {
+		expr = (struct cnfexpr*) cnfstringvalNew(ret.d.estr);
+	} else {
+		varFreeMembers(&ret);
+		goto done;
+	}
+	if(expr == NULL) { /* out of memory, keep the call */
+		if(ret.datatype == 'S')
+			es_deleteStr(ret.d.estr);
+		expr = (struct cnfexpr*) func;
+		goto done;
+	}
+	if(Debug) {
+		char *fname = es_str2cstr(func->fname, NULL);
+		DBGPRINTF("optimizer: constant-folded call to %s()\n", fname);
+		free(fname);
+	}
+	cnfexprDestruct((struct cnfexpr*) func);
+done:
+	return expr;
+}
+
+
 /* optimize comparisons with syslog severity/facility. This is a special
  * handler as the numerical values also support GT, LT, etc ops.
  */
@@ -4800,6 +4906,9 @@ cnfexprOptimize(struct cnfexpr *expr)
 		expr->r = cnfexprOptimize(expr->r);
 		expr = cnfexprOptimize_NOT(expr);
 		break;
+	case 'F':
+		expr = constFoldFunc((struct cnffunc*) expr);
+		break;
 	default:/* nodetypes we cannot optimize */
 		break;
 	}
@@ -5046,6 +5155,256 @@ done:	return root;
 }
 
 
+/* Common subexpression elimination (CSE).
+ * We search a ruleset for pure function calls and property reads which
+ * occur more than once with identical arguments. Each group of such
+ * expressions is assigned a slot inside the per-worker expression cache
+ * (see wti.h), so that the value is computed only once per message. The
+ * execution engine invalidates the cache whenever the message may have
+ * been modified (set, unset, actions, impure functions, ...).
+ */
+struct cseCandidates {
+	struct cnfexpr **expr;
+	int nmemb;
+	int maxmemb;
+};
+static int nxtExprCacheIdx = 0; /* next free slot, slots are global to all rulesets */
+
+static int *
+cnfexprGetCacheIdx(struct cnfexpr *const expr)
+{
+	if(expr->nodetype == 'F')
+		return &((struct cnffunc*)expr)->cacheIdx;
+	else if(expr->nodetype == 'V')
+		return &((struct cnfvar*)expr)->cacheIdx;
+	return NULL;
+}
+
+/* check if an expression only consists of constants, message properties
+ * and pure functions, so that its value does not change while the
+ * message is unmodified.
+ */
+static int
+cnfexprIsCacheable(struct cnfexpr *const expr)
+{
+	unsigned short i;
+	int r = 0;
+
+	switch(expr->nodetype) {
+	case 'N':
+	case 'S':
+	case 'A':
+		r = 1;
+		break;
+	case 'V':
+		/* global vars may be modified by other workers at any time */
+		r = ((struct cnfvar*)expr)->prop.id != PROP_GLOBAL_VAR;
+		break;
+	case 'F':
+		if(!(((struct cnffunc*)expr)->flags & SCRIPTFUNC_PURE))
+			break;
+		for(i = 0 ; i < ((struct cnffunc*)expr)->nParams ; ++i)
+			if(!cnfexprIsCacheable(((struct cnffunc*)expr)->expr[i]))
+				goto done;
+		r = 1;
+		break;
+	case CMP_NE:
+	case CMP_EQ:
+	case CMP_LE:
+	case CMP_GE:
+	case CMP_LT:
+	case CMP_GT:
+	case CMP_STARTSWITH:
+	case CMP_STARTSWITHI:
+	case CMP_CONTAINS:
+	case CMP_CONTAINSI:
+	case OR:
+	case AND:
+	case '&':
+	case '+':
+	case '-':
+	case '*':
+	case '/':
+	case '%':
+		r = cnfexprIsCacheable(expr->l) && cnfexprIsCacheable(expr->r);
+		break;
+	case NOT:
+	case 'M':
+		r = cnfexprIsCacheable(expr->r);
+		break;
+	default:
+		break;
+	}
+done:	return r;
+}
+
+/* check if two expressions are structurally identical */
+static int
+cnfexprIsEqual(struct cnfexpr *const e1, struct cnfexpr *const e2)
+{
+	unsigned short i;
+	int r = 0;
+
+	if(e1->nodetype != e2->nodetype)
+		goto done;
+
+	switch(e1->nodetype) {
+	case 'N':
+		r = ((struct cnfnumval*)e1)->val == ((struct cnfnumval*)e2)->val;
+		break;
+	case 'S':
+		r = !es_strcmp(((struct cnfstringval*)e1)->estr, ((struct cnfstringval*)e2)->estr);
+		break;
+	case 'A':
+		if(((struct cnfarray*)e1)->nmemb != ((struct cnfarray*)e2)->nmemb)
+			break;
+		for(i = 0 ; i < ((struct cnfarray*)e1)->nmemb ; ++i)
+			if(es_strcmp(((struct cnfarray*)e1)->arr[i], ((struct cnfarray*)e2)->arr[i]))
+				goto done;
+		r = 1;
+		break;
+	case 'V':
+		r = !strcmp(((struct cnfvar*)e1)->name, ((struct cnfvar*)e2)->name);
+		break;
+	case 'F':
+		/* note: funcdata is derived from the (constant) parameters, except
+		 * for optimizer-generated prifilt() which has no parameters at all.
+		 */
+		if(((struct cnffunc*)e1)->fPtr != ((struct cnffunc*)e2)->fPtr
+		   || ((struct cnffunc*)e1)->nParams != ((struct cnffunc*)e2)->nParams
+		   || ((struct cnffunc*)e1)->nParams == 0)
+			break;
+		for(i = 0 ; i < ((struct cnffunc*)e1)->nParams ; ++i)
+			if(!cnfexprIsEqual(((struct cnffunc*)e1)->expr[i], ((struct cnffunc*)e2)->expr[i]))
+				goto done;
+		r = 1;
+		break;
+	case NOT:
+	case 'M':
+		r = cnfexprIsEqual(e1->r, e2->r);
+		break;
+	default: /* binary operations */
+		r = cnfexprIsEqual(e1->l, e2->l) && cnfexprIsEqual(e1->r, e2->r);
+		break;
+	}
+done:	return r;
+}
+
+static void
+cseAddCandidate(struct cseCandidates *const cand, struct cnfexpr *const expr)
+{
+	struct cnfexpr **newarr;
+	int newMax;
+
+	if(cand->nmemb == cand->maxmemb) {
+		newMax = (cand->maxmemb == 0) ? 16 : 2 * cand->maxmemb;
+		if((newarr = realloc(cand->expr, newMax * sizeof(struct cnfexpr*))) == NULL)
+			return; /* not fatal, we just optimize less */
+		cand->expr = newarr;
+		cand->maxmemb = newMax;
+	}
+	cand->expr[cand->nmemb++] = expr;
+}
+
+static void
+cseCollectExpr(struct cseCandidates *const cand, struct cnfexpr *const expr)
+{
+	unsigned short i;
+
+	if(expr == NULL)
+		return;
+	switch(expr->nodetype) {
+	case 'N':
+	case 'S':
+	case 'A':
+		break;
+	case 'V':
+		if(cnfexprIsCacheable(expr))
+			cseAddCandidate(cand, expr);
+		break;
+	case 'F':
+		for(i = 0 ; i < ((struct cnffunc*)expr)->nParams ; ++i)
+			cseCollectExpr(cand, ((struct cnffunc*)expr)->expr[i]);
+		if(((struct cnffunc*)expr)->nParams > 0 && cnfexprIsCacheable(expr))
+			cseAddCandidate(cand, expr);
+		break;
+	case NOT:
+	case 'M':
+		cseCollectExpr(cand, expr->r);
+		break;
+	default: /* binary operations */
+		cseCollectExpr(cand, expr->l);
+		cseCollectExpr(cand, expr->r);
+		break;
+	}
+}
+
+static void
+cseCollectStmt(struct cseCandidates *const cand, struct cnfstmt *const root)
+{
+	struct cnfstmt *stmt;
+
+	for(stmt = root ; stmt != NULL ; stmt = stmt->next) {
+		switch(stmt->nodetype) {
+		case S_IF:
+			cseCollectExpr(cand, stmt->d.s_if.expr);
+			cseCollectStmt(cand, stmt->d.s_if.t_then);
+			cseCollectStmt(cand, stmt->d.s_if.t_else);
+			break;
+		case S_FOREACH:
+			cseCollectExpr(cand, stmt->d.s_foreach.iter->collection);
+			cseCollectStmt(cand, stmt->d.s_foreach.body);
+			break;
+		case S_PRIFILT:
+			cseCollectStmt(cand, stmt->d.s_prifilt.t_then);
+			cseCollectStmt(cand, stmt->d.s_prifilt.t_else);
+			break;
+		case S_PROPFILT:
+			cseCollectStmt(cand, stmt->d.s_propfilt.t_then);
+			break;
+		case S_SET:
+			cseCollectExpr(cand, stmt->d.s_set.expr);
+			break;
+		case S_CALL_INDIRECT:
+			cseCollectExpr(cand, stmt->d.s_call_ind.expr);
+			break;
+		default: /* no expressions inside */
+			break;
+		}
+	}
+}
+
+/* assign expression cache slots to all common subexpressions of a
+ * ruleset. Must be called after the regular optimizer run.
+ */
+void
+cnfstmtOptimizeCSE(struct cnfstmt *const root)
+{
+	struct cseCandidates cand = { NULL, 0, 0 };
+	int *pIdx;
+	int i, j;
+
+	cseCollectStmt(&cand, root);
+	for(i = 0 ; i < cand.nmemb ; ++i) {
+		if(*cnfexprGetCacheIdx(cand.expr[i]) != -1)
+			continue; /* already part of a group */
+		for(j = i + 1 ; j < cand.nmemb ; ++j) {
+			pIdx = cnfexprGetCacheIdx(cand.expr[j]);
+			if(*pIdx == -1 && cnfexprIsEqual(cand.expr[i], cand.expr[j])) {
+				if(*cnfexprGetCacheIdx(cand.expr[i]) == -1) {
+					*cnfexprGetCacheIdx(cand.expr[i]) = nxtExprCacheIdx++;
+					DBGPRINTF("optimizer: common subexpression %p, type '%s' "
+						"assigned to expression cache slot %d\n", cand.expr[i],
+						tokenToString(cand.expr[i]->nodetype),
+						*cnfexprGetCacheIdx(cand.expr[i]));
+				}
+				*pIdx = *cnfexprGetCacheIdx(cand.expr[i]);
+			}
+		}
+	}
+	free(cand.expr);
+}
+
 struct cnffparamlst *
 cnffparamlstNew(struct cnfexpr *expr, struct cnffparamlst *next)
 {
@@ -5121,6 +5480,8 @@ cnffuncNew(es_str_t *fname, struct cnffparamlst* paramlst)
 		func->nParams = nParams;
 		func->funcdata = NULL;
 		func->destructable_funcdata = 1;
+		func->flags = 0;
+		func->cacheIdx = -1;
 		cstr = es_str2cstr(fname, NULL);
 		func->fPtr = funcName2Ptr(cstr, nParams);
 
@@ -5139,6 +5500,7 @@ cnffuncNew(es_str_t *fname, struct cnffparamlst* paramlst)
 		}
 		/* some functions require special initialization */
 		struct scriptFunct *foundFunc = searchModList(cstr);
+		func->flags = foundFunc->flags;
 		if(foundFunc->initFunc != NULL) {
 			foundFunc->initFunc(func);
 		}
@@ -5170,6 +5532,8 @@ cnffuncNew_prifilt(int fac)
 		func->nParams = 0;
 		func->fPtr = doFunct_Prifilt;
 		func->destructable_funcdata = 1;
+		func->flags = SCRIPTFUNC_PURE;
+		func->cacheIdx = -1;
 		((struct funcData_prifilt *)func->funcdata)->pmask[fac] = TABLE_ALLPRI;
 	}
 	return func;
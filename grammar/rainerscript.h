@@ -123,10 +123,15 @@ enum cnfFiltType { CNFFILT_NONE, CNFFILT_PRI, CNFFILT_PROP, CNFFILT_SCRIPT };
 const char* cnfFiltType2str(const enum cnfFiltType filttype);
 
 
+struct cnfstmtprof; /* opaque, handled by ruleset.c */
+
 struct cnfstmt {
 	unsigned nodetype;
 	struct cnfstmt *next;
 	uchar *printable; /* printable text for debugging */
+	const char *srcFile; /* config file of this stmt (shared, do not free), may be NULL */
+	int srcLine; /* config file line where this stmt ends */
+	struct cnfstmtprof *prof; /* profiling data, NULL if profiling is not enabled */
 	union {
 		struct {
 			struct cnfexpr *expr;
@@ -201,6 +206,7 @@ struct cnfvar {
 	unsigned nodetype;
 	char *name;
 	msgPropDescr_t prop;
+	int cacheIdx;	/* slot in per-worker expression cache, -1 if not cached */
 } __attribute__((aligned (8)));
 
 struct cnfarray {
@@ -258,6 +264,8 @@ struct cnffunc {
 	rscriptFuncPtr fPtr;
 	void *funcdata;	/* global data for function-specific use (e.g. compiled regex) */
 	uint8_t destructable_funcdata;
+	unsigned short flags;	/* SCRIPTFUNC_* flags of the function called */
+	int cacheIdx;	/* slot in per-worker expression cache, -1 if not cached */
 	struct cnfexpr *expr[];
 } __attribute__((aligned (8)));
 
@@ -269,11 +277,19 @@ struct scriptFunct {
 	rscriptFuncPtr fPtr;
 	rsRetVal (*initFunc) (struct cnffunc *);
 	void (*destruct) (struct cnffunc *);
+	unsigned short flags;
 	/* currently no optimizer entrypoint, may be added later.
 	 * Since the optimizer needs metadata about functions, it does
-	 * not seem practical to add such a function at the current state
+	 * not seem practical to add such a function at the current state.
+	 * Some metadata is provided via the flags, though.
 	 */
 };
+/* flags for scriptFunct: */
+#define SCRIPTFUNC_PURE		0x0001	/* no side effects; for identical parameters, the
+					 * result is the same while processing one message */
+#define SCRIPTFUNC_CONSTFOLD	0x0002	/* result depends on parameters only (not on message,
+					 * environment or config state); with constant parameters
+					 * the call is evaluated once at config load */
 
 
 /* future extensions
@@ -380,6 +396,7 @@ struct cnfstmt * cnfstmtNewContinue(void);
 struct cnfstmt * cnfstmtNewReloadLookupTable(struct cnffparamlst *fparams);
 void cnfstmtDestructLst(struct cnfstmt *root);
 struct cnfstmt *cnfstmtOptimize(struct cnfstmt *root);
+void cnfstmtOptimizeCSE(struct cnfstmt *root);
 struct cnfarray* cnfarrayNew(es_str_t *val);
 struct cnfarray* cnfarrayDup(struct cnfarray *old);
 struct cnfarray* cnfarrayAdd(struct cnfarray *ar, es_str_t *val);
@@ -34,6 +34,8 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <glob.h>
+#include <dirent.h>
+#include <time.h>
 #include <poll.h>
 #include <json.h>
 #include <fnmatch.h>
@@ -64,6 +66,8 @@
 #include "ratelimit.h"
 #include "srUtils.h"
 #include "parserif.h"
+#include "hashtable.h"
+#include "hashtable_itr.h"
 
 #include <regex.h>
 
@@ -97,7 +101,12 @@ static int bLegacyCnfModGlobalsPermitted;/* are legacy module-global config para
 
 #define NUM_MULTISUB 1024 /* default max number of submits */
 #define DFLT_PollInterval 10
-#define INIT_WDMAP_TAB_SIZE 1 /* default wdMap table size - is extended as needed, use 2^x value */
+#define READ_BUF_SIZE (128*1024) /* stream read buffer, large so that lines are split in bulk */
+#define INIT_WDMAP_TAB_SIZE 1024 /* initial wdmap hash table size - is extended as needed */
+#define INIT_ACTIDX_TAB_SIZE 16 /* initial size of per-edge active object index - is extended as needed */
+#define INIT_STATEDB_TAB_SIZE 1024 /* initial size of consolidated state table - is extended as needed */
+#define STATEDB_FILENAME "imfile-state.db" /* name of consolidated state file */
+#define DFLT_StateFlushInterval 10 /* seconds between writes of consolidated state file */
 #define ADD_METADATA_UNSPECIFIED -1
 
 /* If set to 1, fileTableDisplay will be compiled and used for debugging */
@@ -189,6 +198,8 @@ struct act_obj_s {
 	ratelimit_t *ratelimiter;
 	multi_submit_t multiSub;
 	int is_symlink;
+	int rdrState;		/* reader pool state, see RDR_* below */
+	act_obj_t *rdrNext;	/* next entry in reader queue */
 };
 struct fs_edge_s {
 	fs_node_t *parent;	/* node pointing to this edge */
@@ -197,6 +208,7 @@ struct fs_edge_s {
 	uchar *name;
 	uchar *path;
 	act_obj_t *active;
+	struct hashtable *actIdx; /* active objects by name - symlink targets are not included */
 	int is_file;
 	int ninst;		/* nbr of instances in instarr */
 	instanceConf_t **instarr;
@@ -211,6 +223,13 @@ struct fs_node_s {
 static rsRetVal persistStrmState(act_obj_t *);
 static rsRetVal resetConfigVariables(uchar __attribute__((unused)) *pp, void __attribute__((unused)) *pVal);
 static rsRetVal ATTR_NONNULL(1) pollFile(act_obj_t *act);
+static void ATTR_NONNULL(1) pollFileAsync(act_obj_t *act);
+static void ATTR_NONNULL(1) rdrWaitActIdle(const act_obj_t *act);
+static int ATTR_NONNULL(1) rdrActIsIdle(const act_obj_t *act);
+static void rdrWaitAllIdle(void);
+static void ATTR_NONNULL() stateDbRemove(const char *const key);
+static void ATTR_NONNULL() stateDbKey(char *const buf, const size_t lenbuf,
+	const uchar *const statefn, const char *const file_id);
 static int ATTR_NONNULL() getBasename(uchar *const __restrict__ basen, uchar *const __restrict__ path);
 static void ATTR_NONNULL() act_obj_unlink(act_obj_t *act);
 static uchar * ATTR_NONNULL(1, 2) getStateFileName(const act_obj_t *, uchar *, const size_t);
@@ -228,11 +247,14 @@ struct modConfData_s {
 	int iPollInterval;	/* number of seconds to sleep when there was no file activity */
 	int readTimeout;
 	int timeoutGranularity;		/* value in ms */
+	int nReaders;		/* number of reader threads, 1 means read on input thread */
 	instanceConf_t *root, *tail;
 	fs_node_t *conf_tree;
 	uint8_t opMode;
 	sbool configSetViaV2Method;
 	uchar *stateFileDirectory;
+	sbool bConsolidatedState;	/* keep all file states in a single state file? */
+	int stateFlushInterval;		/* seconds between writes of consolidated state file */
 	sbool sortFiles;
 	sbool normalizePath;	/* normalize file system pathes (all start with root dir) */
 	sbool haveReadTimeouts;	/* use special processing if read timeouts exist */
@@ -250,20 +272,17 @@ static modConfData_t *currModConf = NULL;/* modConf ptr to CURRENT mod conf (run
 
 #ifdef HAVE_INOTIFY_INIT
 /* We need to map watch descriptors to our actual objects. Unfortunately, the
- * inotify API does not provide us with any cookie, so a simple O(1) algorithm
- * cannot be done (what a shame...). We assume that maintaining the array is much
- * less often done than looking it up, so we keep the array sorted by watch descriptor
- * and do a binary search on the wd we get back. This is at least O(log n), which
- * is not too bad for the anticipated use case.
+ * inotify API does not provide us with any cookie, so we need to look up the
+ * wd we get back. With many thousand watches, a sorted array becomes too
+ * costly to maintain (every add and delete shifts the array), so we use a
+ * hash table keyed by wd, which gives O(1) for all operations.
  */
 struct wd_map_s {
-	int wd;		/* ascending sort key */
+	int wd;		/* key */
 	act_obj_t *act; /* point to related active object */
 };
 typedef struct wd_map_s wd_map_t;
-static wd_map_t *wdmap = NULL;
-static int nWdmap;
-static int allocMaxWdmap;
+static struct hashtable *wdmap = NULL;
 static int ino_fd;	/* fd for inotify calls */
 #endif /* #if HAVE_INOTIFY_INIT -------------------------------------------------- */
 
@@ -278,6 +297,34 @@ static int glport; /* Static port handle for FEN api*/
 #endif /* #if OS_SOLARIS -------------------------------------------------- */
 
 static prop_t *pInputName = NULL;
+static int nActSymlinkTargets;	/* nbr of active objects which are symlink targets (not in edge actIdx) */
+
+/* reader thread pool (only if readerThreads > 1). Files with new data are
+ * queued and read by the next free reader. An act object is owned by at most
+ * one reader at a time, so the order of lines inside a file is preserved.
+ * Only the input thread creates and destroys act objects. Before it touches
+ * one that may be owned by a reader, it must wait until it is idle again.
+ */
+#define RDR_IDLE 0	/* neither queued nor being read */
+#define RDR_QUEUED 1	/* waiting in queue */
+#define RDR_ACTIVE 2	/* currently being read */
+#define RDR_REPOLL 3	/* being read, but new data was signalled meanwhile */
+static pthread_t *rdrThrds = NULL;	/* NULL if pool not in use */
+static int nRdrThrds;
+static pthread_mutex_t rdrMut = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rdrWork = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t rdrIdle = PTHREAD_COND_INITIALIZER;
+static act_obj_t *rdrQueueRoot = NULL;
+static act_obj_t *rdrQueueLast = NULL;
+static int rdrNumActive;
+static sbool bRdrTerminate;
+
+/* consolidated state file */
+static struct hashtable *stateDb = NULL;	/* NULL if consolidated state file is not in use */
+static pthread_mutex_t stateDbMut = PTHREAD_MUTEX_INITIALIZER;
+static char *stateDbFile = NULL;
+static sbool bStateDbDirty;
+static time_t stateDbLastFlush;
 /* there is only one global inputName for all messages generated by this input */
 
 /* module-global parameters */
@@ -288,7 +335,10 @@ static struct cnfparamdescr modpdescr[] = {
 	{ "sortfiles", eCmdHdlrBinary, 0 },
 	{ "statefile.directory", eCmdHdlrString, 0 },
 	{ "normalizepath", eCmdHdlrBinary, 0 },
-	{ "mode", eCmdHdlrGetWord, 0 }
+	{ "mode", eCmdHdlrGetWord, 0 },
+	{ "readerthreads", eCmdHdlrPositiveInt, 0 },
+	{ "statefile.consolidated", eCmdHdlrBinary, 0 },
+	{ "statefile.flushinterval", eCmdHdlrPositiveInt, 0 }
 };
 static struct cnfparamblk modpblk =
 	{ CNFPARAMBLK_VERSION,
@@ -440,82 +490,77 @@ finalize_it:
 
 
 
-#if 0 // Code we can potentially use for new functionality // TODO: use or remove
-//TODO add a kind of portable asprintf:
-static const char * ATTR_NONNULL()
-gen_full_name(const char *const dirname, const char *const name)
+#ifdef HAVE_INOTIFY_INIT
+/* build full path name of object name inside directory dirname.
+ * Returns 0 on success, -1 if the buffer is too small.
+ */
+static int ATTR_NONNULL()
+gen_full_name(char *const full_name, const size_t len_full_name,
+	const char *const dirname, const char *const name)
 {
-	const size_t len_full_name = strlen(dirname) + 1 + strlen(name) + 1;
-	char *const full_name = malloc(len_full_name);
-	if(full_name == NULL)
-		return NULL;
-
-	snprintf(full_name, len_full_name, "%s/%s", dirname, name);
-	return full_name;
+	const size_t lendir = strlen(dirname);
+	const int need_slash = (lendir == 0 || dirname[lendir-1] != '/');
+	const int r = snprintf(full_name, len_full_name, "%s%s%s", dirname, need_slash ? "/" : "", name);
+	return (r < 0 || (size_t) r >= len_full_name) ? -1 : 0;
 }
-#endif
-
 
-#ifdef HAVE_INOTIFY_INIT
 #if ULTRA_DEBUG == 1
 static void
 dbg_wdmapPrint(const char *msg)
 {
-	int i;
-	DBGPRINTF("%s\n", msg);
-	for(i = 0 ; i < nWdmap ; ++i)
-		DBGPRINTF("wdmap[%d]: wd: %d, act %p, name: %s\n",
-			i, wdmap[i].wd, wdmap[i].act, wdmap[i].act->name);
+	DBGPRINTF("%s: wdmap has %u entries\n", msg, (wdmap == NULL) ? 0 : hashtable_count(wdmap));
 }
 #endif
 
+static unsigned int
+wdmap_hash(void *k)
+{
+	return (unsigned int) *((int*) k);
+}
+
+static int
+wdmap_keyEq(void *k1, void *k2)
+{
+	return *((int*) k1) == *((int*) k2);
+}
+
 static rsRetVal
 wdmapInit(void)
 {
 	DEFiRet;
-	free(wdmap);
-	CHKmalloc(wdmap = malloc(sizeof(wd_map_t) * INIT_WDMAP_TAB_SIZE));
-	allocMaxWdmap = INIT_WDMAP_TAB_SIZE;
-	nWdmap = 0;
+	if(wdmap != NULL)
+		hashtable_destroy(wdmap, 1);
+	CHKmalloc(wdmap = create_hashtable(INIT_WDMAP_TAB_SIZE, wdmap_hash, wdmap_keyEq, NULL));
 finalize_it:
 	RETiRet;
 }
 
 
-/* note: we search backwards, as inotify tends to return increasing wd's */
 static rsRetVal
 wdmapAdd(int wd, act_obj_t *const act)
 {
-	wd_map_t *newmap;
-	int newmapsize;
-	int i;
+	wd_map_t *etry = NULL;
+	int *key = NULL;
 	DEFiRet;
 
-	for(i = nWdmap-1 ; i >= 0 && wdmap[i].wd > wd ; --i)
-		; 	/* just scan */
-	if(i >= 0 && wdmap[i].wd == wd) {
+	if(hashtable_search(wdmap, &wd) != NULL) {
 		LogError(0, RS_RET_INTERNAL_ERROR, "imfile: wd %d already in wdmap!", wd);
 		ABORT_FINALIZE(RS_RET_FILE_ALREADY_IN_TABLE);
 	}
-	++i;
-	/* i now points to the entry that is to be moved upwards (or end of map) */
-	if(nWdmap == allocMaxWdmap) {
-		newmapsize = 2 * allocMaxWdmap;
-		CHKmalloc(newmap = realloc(wdmap, sizeof(wd_map_t) * newmapsize));
-		// TODO: handle the error more intelligently? At all possible? -- 2013-10-15
-		wdmap = newmap;
-		allocMaxWdmap = newmapsize;
+	CHKmalloc(etry = malloc(sizeof(wd_map_t)));
+	CHKmalloc(key = malloc(sizeof(int)));
+	etry->wd = *key = wd;
+	etry->act = act;
+	if(!hashtable_insert(wdmap, key, etry)) {
+		ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
 	}
-	if(i < nWdmap) {
-		/* we need to shift to make room for new entry */
-		memmove(wdmap + i + 1, wdmap + i, sizeof(wd_map_t) * (nWdmap - i));
-	}
-	wdmap[i].wd = wd;
-	wdmap[i].act = act;
-	++nWdmap;
-	DBGPRINTF("add wdmap[%d]: wd %d, act obj %p, path %s\n", i, wd, act, act->name);
+	DBGPRINTF("add wdmap: wd %d, act obj %p, path %s\n", wd, act, act->name);
 
 finalize_it:
+	if(iRet != RS_RET_OK) {
+		free(etry);
+		free(key);
+	}
 	RETiRet;
 }
 
@@ -542,48 +587,28 @@ in_setupWatch(act_obj_t *const act, const int is_file)
 done:	return wd;
 }
 
-/* compare function for bsearch() */
-static int
-wdmap_cmp(const void *k, const void *a)
-{
-	int key = *((int*) k);
-	wd_map_t *etry = (wd_map_t*) a;
-	if(key < etry->wd)
-		return -1;
-	else if(key > etry->wd)
-		return 1;
-	else
-		return 0;
-}
-/* looks up a wdmap entry and returns it's index if found
- * or -1 if not found.
- */
+/* looks up a wdmap entry and returns it or NULL if not found */
 static wd_map_t *
 wdmapLookup(int wd)
 {
-	return bsearch(&wd, wdmap, nWdmap, sizeof(wd_map_t), wdmap_cmp);
+	return (wd_map_t*) hashtable_search(wdmap, &wd);
 }
 
 
 static rsRetVal
 wdmapDel(const int wd)
 {
-	int i;
+	int key = wd;
+	wd_map_t *etry;
 	DEFiRet;
 
-	for(i = 0 ; i < nWdmap && wdmap[i].wd < wd ; ++i)
-		; 	/* just scan */
-	if(i == nWdmap ||  wdmap[i].wd != wd) {
+	etry = (wd_map_t*) hashtable_remove(wdmap, &key);
+	if(etry == NULL) {
 		DBGPRINTF("wd %d shall be deleted but not in wdmap!\n", wd);
 		FINALIZE;
 	}
-
-	if(i < nWdmap-1) {
-		/* we need to shift to delete it (see comment at wdmap definition) */
-		memmove(wdmap + i, wdmap + i + 1, sizeof(wd_map_t) * (nWdmap - i - 1));
-	}
-	--nWdmap;
-	DBGPRINTF("wd %d deleted, was idx %d\n", wd, i);
+	free(etry);
+	DBGPRINTF("wd %d deleted\n", wd);
 
 finalize_it:
 	RETiRet;
@@ -681,6 +706,17 @@ fs_node_print(const fs_node_t *const node, const int level)
 	}
 }
 
+/* look up active object by name via the edge's name index. Note that
+ * symlink targets are not indexed, as there may be multiple of them with
+ * the same name (but different sources).
+ */
+static act_obj_t * ATTR_NONNULL()
+act_obj_find(const fs_edge_t *const edge, const char *const name)
+{
+	return (act_obj_t*) hashtable_search(edge->actIdx, (void*) name);
+}
+
+
 /* add a new file system object if it not yet exists, ignore call
  * if it already does.
  */
@@ -690,19 +726,31 @@ act_obj_add(fs_edge_t *const edge, const char *const name, const int is_file,
 {
 	act_obj_t *act;
 	char basename[MAXFNAME];
+	char *idxKey;
+	int bIndexed = 0;
 	DEFiRet;
 	int fd = -1;
-	
+
 	DBGPRINTF("act_obj_add: edge %p, name '%s' (source '%s')\n", edge, name, source? source : "---");
-	for(act = edge->active ; act != NULL ; act = act->next) {
-		if(!strcmp(act->name, name)) {
-			if (!source || !act->source_name || !strcmp(act->source_name, source)) {
-				DBGPRINTF("active object '%s' already exists in '%s' - no need to add\n",
-					name, edge->path);
-				FINALIZE;
+	if(source == NULL && nActSymlinkTargets == 0) {
+		/* fast path: all active objects are in the name index */
+		if(act_obj_find(edge, name) != NULL) {
+			DBGPRINTF("active object '%s' already exists in '%s' - no need to add\n",
+				name, edge->path);
+			FINALIZE;
+		}
+	} else {
+		for(act = edge->active ; act != NULL ; act = act->next) {
+			if(!strcmp(act->name, name)) {
+				if (!source || !act->source_name || !strcmp(act->source_name, source)) {
+					DBGPRINTF("active object '%s' already exists in '%s' - no need to add\n",
+						name, edge->path);
+					FINALIZE;
+				}
 			}
 		}
 	}
+	act = NULL;
 	DBGPRINTF("need to add new active object '%s' in '%s' - checking if accessible\n", name, edge->path);
 	fd = open(name, O_RDONLY | O_CLOEXEC);
 	if(fd < 0) {
@@ -726,6 +774,12 @@ act_obj_add(fs_edge_t *const edge, const char *const name, const int is_file,
 		CHKmalloc(act->source_name = strdup(source));
 	} else {
 		act->source_name = NULL;
+		CHKmalloc(idxKey = strdup(name));
+		if(!hashtable_insert(edge->actIdx, idxKey, act)) {
+			free(idxKey);
+			ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+		}
+		bIndexed = 1;
 	}
 	#ifdef HAVE_INOTIFY_INIT
 	act->wd = in_setupWatch(act, is_file);
@@ -737,7 +791,7 @@ act_obj_add(fs_edge_t *const edge, const char *const name, const int is_file,
 		CHKmalloc(act->multiSub.ppMsgs = malloc(inst->nMultiSub * sizeof(smsg_t *)));
 		act->multiSub.maxElem = inst->nMultiSub;
 		act->multiSub.nElem = 0;
-		pollFile(act);
+		pollFileAsync(act);
 	}
 
 	/* all well, add to active list */
@@ -746,8 +800,14 @@ act_obj_add(fs_edge_t *const edge, const char *const name, const int is_file,
 	}
 	act->next = edge->active;
 	edge->active = act;
+	if(act->source_name != NULL) {
+		++nActSymlinkTargets;
+	}
 finalize_it:
 	if(iRet != RS_RET_OK) {
+		if(bIndexed) {
+			hashtable_remove(edge->actIdx, (void*) name);
+		}
 		if(act != NULL) {
 			free(act->name);
 			free(act);
@@ -760,44 +820,62 @@ finalize_it:
 }
 
 
+/* check if the file system object of an active object has gone away or
+ * was replaced (inode changed). If so, the object is unlinked.
+ * Returns 1 if it was unlinked, 0 otherwise.
+ */
+static int ATTR_NONNULL()
+act_obj_chk_gone(act_obj_t *const act)
+{
+	struct stat fileInfo;
+
+	DBGPRINTF("act_obj_chk_gone checking active obj '%s'\n", act->name);
+	const int r = lstat(act->name, &fileInfo);
+	if(r == -1) { /* object gone away? */
+		DBGPRINTF("object gone away, unlinking: '%s'\n", act->name);
+		act_obj_unlink(act);
+		return 1;
+	} else if(fileInfo.st_ino != act->ino) {
+		DBGPRINTF("file '%s' inode changed from %llu to %llu, unlinking from "
+			"internal lists\n", act->name, (long long unsigned) act->ino,
+			(long long unsigned) fileInfo.st_ino);
+		rdrWaitActIdle(act);
+		if(act->pStrm != NULL) {
+			/* we do no need to re-set later, as act_obj_unlink
+			 * will destroy the strm obj */
+			strmSet_checkRotation(act->pStrm, STRM_ROTATION_DO_NOT_CHECK);
+		}
+		act_obj_unlink(act);
+		return 1;
+	}
+	return 0;
+}
+
+
 /* this walks an edges active list and detects and acts on any changes
  * seen there. It does NOT detect newly appeared files, as they are not
  * inside the active list!
+ * Unlinking a symlink also unlinks its target, which may be the next
+ * list element, so in that case we need to restart the walk.
  */
 static void
 detect_updates(fs_edge_t *const edge)
 {
 	act_obj_t *act;
-	struct stat fileInfo;
-	int restart = 0;
-
-	for(act = edge->active ; act != NULL ; act = act->next) {
-		DBGPRINTF("detect_updates checking active obj '%s'\n", act->name);
-		const int r = lstat(act->name, &fileInfo);
-		if(r == -1) { /* object gone away? */
-			DBGPRINTF("object gone away, unlinking: '%s'\n", act->name);
-			act_obj_unlink(act);
-			restart = 1;
-			break;
-		} else if(fileInfo.st_ino != act->ino) {
-			DBGPRINTF("file '%s' inode changed from %llu to %llu, unlinking from "
-				"internal lists\n", act->name, (long long unsigned) act->ino,
-				(long long unsigned) fileInfo.st_ino);
-			if(act->pStrm != NULL) {
-				/* we do no need to re-set later, as act_obj_unlink
-				 * will destroy the strm obj */
-				strmSet_checkRotation(act->pStrm, STRM_ROTATION_DO_NOT_CHECK);
+	act_obj_t *next;
+	int restart;
+
+	do {
+		restart = 0;
+		for(act = edge->active ; act != NULL ; act = next) {
+			next = act->next;
+			const int is_symlink = act->is_symlink;
+			if(act_obj_chk_gone(act) && is_symlink) {
+				restart = 1;
+				break;
 			}
-			act_obj_unlink(act);
-			restart = 1;
-			break;
 		}
-
-	}
-
-	if (restart) {
-		detect_updates(edge);
-	}
+	} while(restart);
 }
 
 
@@ -817,7 +895,7 @@ poll_active_files(fs_edge_t *const edge)
 	for(act = edge->active ; act != NULL ; act = act->next) {
 		fen_setupWatch(act);
 		DBGPRINTF("poll_active_files: polling '%s'\n", act->name);
-		pollFile(act);
+		pollFileAsync(act);
 	}
 }
 
@@ -860,13 +938,54 @@ finalize_it:
 	RETiRet;
 }
 
+/* check a single file system object found for edge chld and add it to
+ * the active list if it matches the edge's expectations.
+ */
 static void ATTR_NONNULL()
-poll_tree(fs_edge_t *const chld)
+poll_tree_file(fs_edge_t *const chld, const char *const file)
 {
 	struct stat fileInfo;
+	int issymlink;
+
+	if(lstat(file, &fileInfo) != 0) {
+		LogError(errno, RS_RET_ERR,
+			"imfile: poll_tree cannot stat file '%s' - ignored", file);
+		return;
+	}
+
+	if (S_ISLNK(fileInfo.st_mode)) {
+		rsRetVal slink_ret = process_symlink(chld, file);
+		if (slink_ret != RS_RET_OK) {
+			return;
+		}
+		issymlink = 1;
+	} else {
+		issymlink = 0;
+	}
+	const int is_file = (S_ISREG(fileInfo.st_mode) || issymlink);
+	DBGPRINTF("poll_tree:  found '%s', File: %d (config file: %d), symlink: %d\n",
+		file, is_file, chld->is_file, issymlink);
+	if(!is_file && S_ISREG(fileInfo.st_mode)) {
+		LogMsg(0, RS_RET_ERR, LOG_WARNING,
+			"imfile: '%s' is neither a regular file, symlink, nor a "
+			"directory - ignored", file);
+		return;
+	}
+	if(!issymlink && (chld->is_file != is_file)) {
+		LogMsg(0, RS_RET_ERR, LOG_WARNING,
+			"imfile: '%s' is %s but %s expected - ignored",
+			file, (is_file) ? "FILE" : "DIRECTORY",
+			(chld->is_file) ? "FILE" : "DIRECTORY");
+		return;
+	}
+	act_obj_add(chld, file, is_file, fileInfo.st_ino, issymlink, NULL);
+}
+
+static void ATTR_NONNULL()
+poll_tree(fs_edge_t *const chld)
+{
 	glob_t files;
 	int need_globfree = 0;
-	int issymlink;
 	DBGPRINTF("poll_tree: chld %p, name '%s', path: %s\n", chld, chld->name, chld->path);
 	detect_updates(chld);
 	const int ret = glob((char*)chld->path, runModConf->sortFiles|GLOB_BRACE, NULL, &files);
@@ -878,39 +997,7 @@ poll_tree(fs_edge_t *const chld)
 			if(glbl.GetGlobalInputTermState() != 0) {
 				goto done;
 			}
-			char *const file = files.gl_pathv[i];
-			if(lstat(file, &fileInfo) != 0) {
-				LogError(errno, RS_RET_ERR,
-					"imfile: poll_tree cannot stat file '%s' - ignored", file);
-				continue;
-			}
-
-			if (S_ISLNK(fileInfo.st_mode)) {
-				rsRetVal slink_ret = process_symlink(chld, file);
-				if (slink_ret != RS_RET_OK) {
-					continue;
-				}
-				issymlink = 1;
-			} else {
-				issymlink = 0;
-			}
-			const int is_file = (S_ISREG(fileInfo.st_mode) || issymlink);
-			DBGPRINTF("poll_tree:  found '%s', File: %d (config file: %d), symlink: %d\n",
-				file, is_file, chld->is_file, issymlink);
-			if(!is_file && S_ISREG(fileInfo.st_mode)) {
-				LogMsg(0, RS_RET_ERR, LOG_WARNING,
-					"imfile: '%s' is neither a regular file, symlink, nor a "
-					"directory - ignored", file);
-				continue;
-			}
-			if(!issymlink && (chld->is_file != is_file)) {
-				LogMsg(0, RS_RET_ERR, LOG_WARNING,
-					"imfile: '%s' is %s but %s expected - ignored",
-					file, (is_file) ? "FILE" : "DIRECTORY",
-					(chld->is_file) ? "FILE" : "DIRECTORY");
-				continue;
-			}
-			act_obj_add(chld, file, is_file, fileInfo.st_ino, issymlink, NULL);
+			poll_tree_file(chld, files.gl_pathv[i]);
 		}
 	}
 
@@ -930,9 +1017,10 @@ poll_timeouts(fs_edge_t *const edge)
 	if(edge->is_file) {
 		act_obj_t *act;
 		for(act = edge->active ; act != NULL ; act = act->next) {
-			if(act->pStrm && strmReadMultiLine_isTimedOut(act->pStrm)) {
+			/* a file currently being read is not timed out */
+			if(rdrActIsIdle(act) && act->pStrm && strmReadMultiLine_isTimedOut(act->pStrm)) {
 				DBGPRINTF("timeout occured on %s\n", act->name);
-				pollFile(act);
+				pollFileAsync(act);
 			}
 		}
 	}
@@ -951,6 +1039,7 @@ act_obj_destroy(act_obj_t *const act, const int is_deleted)
 	if(act == NULL)
 		return;
 
+	rdrWaitActIdle(act);
 	DBGPRINTF("act_obj_destroy: act %p '%s' (source '%s'), wd %d, pStrm %p, is_deleted %d, in_move %d\n",
 		act, act->name, act->source_name? act->source_name : "---", act->wd, act->pStrm, is_deleted,
 		act->in_move);
@@ -970,7 +1059,11 @@ act_obj_destroy(act_obj_t *const act, const int is_deleted)
 		pollFile(act); /* get any left-over data */
 		if(inst->bRMStateOnDel) {
 			statefn = getStateFileName(act, statefile, sizeof(statefile));
-			getFullStateFileName(statefn, "", toDel, sizeof(toDel)); // TODO: check!
+			if(stateDb != NULL) {
+				stateDbKey((char*) toDel, sizeof(toDel), statefn, act->file_id);
+			} else {
+				getFullStateFileName(statefn, "", toDel, sizeof(toDel)); // TODO: check!
+			}
 			statefn = toDel;
 		}
 		persistStrmState(act);
@@ -978,7 +1071,11 @@ act_obj_destroy(act_obj_t *const act, const int is_deleted)
 		/* we delete state file after destruct in case strm obj initiated a write */
 		if(is_deleted && !act->in_move && inst->bRMStateOnDel) {
 			DBGPRINTF("act_obj_destroy: deleting state file %s\n", statefn);
-			unlink((char*)statefn);
+			if(stateDb != NULL) {
+				stateDbRemove((char*)statefn);
+			} else {
+				unlink((char*)statefn);
+			}
 		}
 	}
 	if(act->ratelimiter != NULL) {
@@ -1057,6 +1154,11 @@ act_obj_unlink(act_obj_t *act)
 	if(act->next != NULL) {
 		act->next->prev = act->prev;
 	}
+	if(act->source_name == NULL) {
+		hashtable_remove(act->edge->actIdx, act->name);
+	} else {
+		--nActSymlinkTargets;
+	}
 	act_obj_destroy(act, 1);
 	act = NULL;
 }
@@ -1072,6 +1174,7 @@ fs_node_destroy(fs_node_t *const node)
 		fs_edge_t *const toDel = edge;
 		edge = edge->next;
 		act_obj_destroy_all(toDel->active);
+		hashtable_destroy(toDel->actIdx, 0);
 		free(toDel->name);
 		free(toDel->path);
 		free(toDel->instarr);
@@ -1157,6 +1260,8 @@ fs_node_add(fs_node_t *const node,
 	CHKmalloc(newchld->node = calloc(sizeof(fs_node_t), 1));
 	CHKmalloc(newchld->path = ustrdup(ourPath));
 	CHKmalloc(newchld->instarr = calloc(sizeof(instanceConf_t*), 1));
+	CHKmalloc(newchld->actIdx = create_hashtable(INIT_ACTIDX_TAB_SIZE, hash_from_string,
+		key_equals_string, NULL));
 	newchld->instarr[0] = inst;
 	newchld->is_file = isFile;
 	newchld->ninst = 1;
@@ -1178,6 +1283,8 @@ finalize_it:
 		free(newchld->node);
 		free(newchld->path);
 		free(newchld->instarr);
+		if(newchld->actIdx != NULL)
+			hashtable_destroy(newchld->actIdx, 0);
 		free(newchld);
 		}
 	}
@@ -1286,6 +1393,277 @@ getStateFileName(const act_obj_t *const act,
 }
 
 
+/* consolidated state file support. If enabled, the states of all monitored
+ * files are kept in memory, keyed by the name the per-file state file would
+ * have, and written to a single state file once per flush interval. This
+ * avoids many small writes (one per monitored file), which is costly on
+ * network-backed disks. The file contains one line per monitored file:
+ * the key, a single space and the JSON state object.
+ * Writing is done by writing a new file and renaming it, so the file never
+ * grows beyond the current set of states.
+ */
+static void ATTR_NONNULL()
+stateDbPut(const char *const key, const char *const jstr)
+{
+	char *dbkey = NULL;
+	char *val = NULL;
+
+	pthread_mutex_lock(&stateDbMut);
+	free(hashtable_remove(stateDb, (void*) key));
+	if((dbkey = strdup(key)) == NULL || (val = strdup(jstr)) == NULL
+	   || !hashtable_insert(stateDb, dbkey, val)) {
+		LogError(0, RS_RET_OUT_OF_MEMORY, "imfile: out of memory persisting "
+			"state for key '%s' - data may be repeated on next startup", key);
+		free(dbkey);
+		free(val);
+	}
+	bStateDbDirty = 1;
+	pthread_mutex_unlock(&stateDbMut);
+}
+
+/* returns a copy of the state, which the caller must free, or NULL */
+static char * ATTR_NONNULL()
+stateDbGet(const char *const key)
+{
+	char *val;
+
+	pthread_mutex_lock(&stateDbMut);
+	val = (char*) hashtable_search(stateDb, (void*) key);
+	if(val != NULL)
+		val = strdup(val);
+	pthread_mutex_unlock(&stateDbMut);
+	return val;
+}
+
+static void ATTR_NONNULL()
+stateDbRemove(const char *const key)
+{
+	char *val;
+
+	pthread_mutex_lock(&stateDbMut);
+	val = (char*) hashtable_remove(stateDb, (void*) key);
+	if(val != NULL) {
+		free(val);
+		bStateDbDirty = 1;
+	}
+	pthread_mutex_unlock(&stateDbMut);
+}
+
+/* generate key for state db, it is the name of the per-file state file */
+static void ATTR_NONNULL()
+stateDbKey(char *const buf, const size_t lenbuf, const uchar *const statefn, const char *const file_id)
+{
+	snprintf(buf, lenbuf, "%s%s%s", (const char*) statefn, (*file_id == '\0') ? "" : ":", file_id);
+}
+
+/* write the state db to disk, if anything changed. */
+static rsRetVal
+stateDbFlush(void)
+{
+	char tmpfn[MAXFNAME];
+	FILE *fp = NULL;
+	int fd = -1;
+	DEFiRet;
+
+	pthread_mutex_lock(&stateDbMut);
+	if(!bStateDbDirty) {
+		FINALIZE;
+	}
+	snprintf(tmpfn, sizeof(tmpfn), "%s.tmp", stateDbFile);
+	fd = open(tmpfn, O_CLOEXEC | O_NOCTTY | O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if(fd < 0 || (fp = fdopen(fd, "w")) == NULL) {
+		LogError(errno, RS_RET_IO_ERROR, "imfile: cannot open state file '%s' for "
+			"persisting file states - some data will probably be duplicated "
+			"on next startup", tmpfn);
+		ABORT_FINALIZE(RS_RET_IO_ERROR);
+	}
+	fd = -1; /* now owned by fp */
+
+	if(hashtable_count(stateDb) > 0) {
+		struct hashtable_itr *const itr = hashtable_iterator(stateDb);
+		CHKmalloc(itr);
+		do {
+			fprintf(fp, "%s %s\n", (char*) hashtable_iterator_key(itr),
+				(char*) hashtable_iterator_value(itr));
+		} while(hashtable_iterator_advance(itr));
+		free(itr);
+	}
+
+	if(fflush(fp) != 0 || fsync(fileno(fp)) != 0 || ferror(fp)) {
+		LogError(errno, RS_RET_IO_ERROR, "imfile: error writing state file '%s' - "
+			"some data will probably be duplicated on next startup", tmpfn);
+		ABORT_FINALIZE(RS_RET_IO_ERROR);
+	}
+	fclose(fp);
+	fp = NULL;
+	if(rename(tmpfn, stateDbFile) != 0) {
+		LogError(errno, RS_RET_IO_ERROR, "imfile: error renaming state file '%s' to "
+			"'%s' - some data will probably be duplicated on next startup",
+			tmpfn, stateDbFile);
+		ABORT_FINALIZE(RS_RET_IO_ERROR);
+	}
+	bStateDbDirty = 0;
+	DBGPRINTF("imfile: state file %s written, %u entries\n", stateDbFile, hashtable_count(stateDb));
+
+finalize_it:
+	if(fp != NULL) {
+		fclose(fp);
+	}
+	if(fd >= 0) {
+		close(fd);
+	}
+	if(iRet != RS_RET_OK) {
+		unlink(tmpfn);
+	}
+	stateDbLastFlush = time(NULL);
+	pthread_mutex_unlock(&stateDbMut);
+	RETiRet;
+}
+
+/* flush state db if it is in use and the flush interval has expired */
+static void
+stateDbFlushIfDue(void)
+{
+	if(stateDb == NULL)
+		return;
+	if(time(NULL) - stateDbLastFlush >= runModConf->stateFlushInterval) {
+		stateDbFlush();
+	}
+}
+
+/* read the state db from disk. A missing file is not an error. */
+static void
+stateDbLoad(void)
+{
+	char *line = NULL;
+	size_t lenline = 0;
+	ssize_t len;
+	int nEntries = 0;
+
+	FILE *const fp = fopen(stateDbFile, "r");
+	if(fp == NULL) {
+		if(errno != ENOENT) {
+			LogError(errno, RS_RET_IO_ERROR, "imfile: cannot read state file '%s' - "
+				"files will be processed as if no state existed", stateDbFile);
+		}
+		return;
+	}
+	while((len = getline(&line, &lenline, fp)) > 0) {
+		if(line[len-1] == '\n')
+			line[len-1] = '\0';
+		char *const val = strchr(line, ' ');
+		if(val == NULL) {
+			DBGPRINTF("imfile: ignoring invalid line in state file: '%s'\n", line);
+			continue;
+		}
+		*val = '\0';
+		stateDbPut(line, val + 1);
+		++nEntries;
+	}
+	free(line);
+	fclose(fp);
+	bStateDbDirty = 0;
+	DBGPRINTF("imfile: %d entries read from state file %s\n", nEntries, stateDbFile);
+}
+
+/* import per-file state files from state file directory. They are deleted
+ * once the state db with their content has been written.
+ */
+static void ATTR_NONNULL()
+stateDbImport(const char *const statedir)
+{
+	char fn[MAXFNAME];
+	struct dirent *ent;
+	int nImported = 0;
+
+	DIR *const dir = opendir(statedir);
+	if(dir == NULL) {
+		LogError(errno, RS_RET_IO_ERROR, "imfile: cannot open state file directory '%s' "
+			"for importing per-file state files", statedir);
+		return;
+	}
+	while((ent = readdir(dir)) != NULL) {
+		if(strncmp(ent->d_name, "imfile-state:", sizeof("imfile-state:") - 1))
+			continue;
+		char *const existing = stateDbGet(ent->d_name);
+		if(existing != NULL) {
+			free(existing);
+			continue; /* state db has precedence */
+		}
+		snprintf(fn, sizeof(fn), "%s/%s", statedir, ent->d_name);
+		const int fd = open(fn, O_CLOEXEC | O_NOCTTY | O_RDONLY);
+		if(fd < 0)
+			continue;
+		struct json_object *const json = fjson_object_from_fd(fd);
+		close(fd);
+		if(json == NULL) {
+			LogError(0, RS_RET_ERR, "imfile: error reading state file '%s' - not imported", fn);
+			continue;
+		}
+		stateDbPut(ent->d_name, json_object_to_json_string_ext(json, JSON_C_TO_STRING_SPACED));
+		json_object_put(json);
+		++nImported;
+	}
+
+	if(nImported > 0 && stateDbFlush() == RS_RET_OK) {
+		rewinddir(dir);
+		while((ent = readdir(dir)) != NULL) {
+			if(strncmp(ent->d_name, "imfile-state:", sizeof("imfile-state:") - 1))
+				continue;
+			char *const val = stateDbGet(ent->d_name);
+			if(val != NULL) {
+				snprintf(fn, sizeof(fn), "%s/%s", statedir, ent->d_name);
+				unlink(fn);
+				free(val);
+			}
+		}
+		LogMsg(0, RS_RET_OK, LOG_INFO, "imfile: imported %d per-file state files "
+			"into state file '%s'", nImported, stateDbFile);
+	}
+	closedir(dir);
+}
+
+static void
+stateDbClose(void)
+{
+	if(stateDb == NULL)
+		return;
+	stateDbFlush();
+	hashtable_destroy(stateDb, 1);
+	stateDb = NULL;
+	free(stateDbFile);
+	stateDbFile = NULL;
+}
+
+static rsRetVal
+stateDbOpen(void)
+{
+	char fn[MAXFNAME];
+	const uchar *const wrkdir = getStateFileDir();
+	const char *const statedir = (wrkdir == NULL) ? "." : (const char*) wrkdir;
+	DEFiRet;
+
+	snprintf(fn, sizeof(fn), "%s/%s", statedir, STATEDB_FILENAME);
+	CHKmalloc(stateDbFile = strdup(fn));
+	CHKmalloc(stateDb = create_hashtable(INIT_STATEDB_TAB_SIZE, hash_from_string,
+		key_equals_string, NULL));
+	bStateDbDirty = 0;
+	stateDbLoad();
+	stateDbImport(statedir);
+	stateDbLastFlush = time(NULL);
+
+finalize_it:
+	if(iRet != RS_RET_OK) {
+		if(stateDb != NULL)
+			hashtable_destroy(stateDb, 1);
+		stateDb = NULL;
+		free(stateDbFile);
+		stateDbFile = NULL;
+	}
+	RETiRet;
+}
+
+
 /* enqueue the read file line as a message. The provided string is
  * not freed - this must be done by the caller.
  */
@@ -1349,6 +1727,45 @@ enqLine(act_obj_t *const act,
 finalize_it:
 	RETiRet;
 }
+/* obtain the state of a file from the consolidated state file. *pjson is
+ * NULL if no state exists. If only an inode-only state exists, it is moved
+ * to the full key, as it is done for per-file state files.
+ */
+static rsRetVal ATTR_NONNULL()
+getConsolidatedState(act_obj_t *const act, const uchar *const statefn, struct json_object **const pjson)
+{
+	char key[MAXFNAME];
+	char *val;
+	DEFiRet;
+
+	*pjson = NULL;
+	stateDbKey(key, sizeof(key), statefn, act->file_id);
+	DBGPRINTF("trying to obtain state for '%s', key '%s'\n", act->name, key);
+	val = stateDbGet(key);
+	if(val == NULL && act->file_id[0] != '\0') {
+		char inokey[MAXFNAME];
+		stateDbKey(inokey, sizeof(inokey), statefn, "");
+		val = stateDbGet(inokey);
+		if(val != NULL) {
+			DBGPRINTF("found inode-only state, moving it to key %s\n", key);
+			stateDbRemove(inokey);
+			stateDbPut(key, val);
+		}
+	}
+	if(val == NULL) {
+		FINALIZE;
+	}
+	*pjson = json_tokener_parse(val);
+	if(*pjson == NULL) {
+		LogError(0, RS_RET_ERR, "imfile: error reading state for '%s' from state file", act->name);
+	}
+
+finalize_it:
+	free(val);
+	RETiRet;
+}
+
+
 /* try to open a file which has a state file. If the state file does not
  * exist or cannot be read, an error is returned.
  */
@@ -1359,11 +1776,22 @@ openFileWithStateFile(act_obj_t *const act)
 	uchar pszSFNam[MAXFNAME];
 	uchar statefile[MAXFNAME];
 	int fd = -1;
+	struct json_object *jval;
+	struct json_object *json = NULL;
 	const instanceConf_t *const inst = act->edge->instarr[0];// TODO: same file, multiple instances?
 
 	uchar *const statefn = getStateFileName(act, statefile, sizeof(statefile));
 	getFileID(act);
 
+	if(stateDb != NULL) {
+		CHKiRet(getConsolidatedState(act, statefn, &json));
+		if(json == NULL) {
+			CHKiRet(OLD_openFileWithStateFile(act));
+			FINALIZE;
+		}
+		goto have_state;
+	}
+
 	getFullStateFileName(statefn, act->file_id, pszSFNam, sizeof(pszSFNam));
 	DBGPRINTF("trying to open state for '%s', state file '%s'\n", act->name, pszSFNam);
 
@@ -1410,14 +1838,14 @@ openFileWithStateFile(act_obj_t *const act)
 	}
 
 	DBGPRINTF("opened state file %s for %s\n", pszSFNam, act->name);
-	CHKiRet(strm.Construct(&act->pStrm));
-
-	struct json_object *jval;
-	struct json_object *json = fjson_object_from_fd(fd);
+	json = fjson_object_from_fd(fd);
 	if(json == NULL) {
 		LogError(0, RS_RET_ERR, "imfile: error reading state file for '%s'", act->name);
 	}
 
+have_state:
+	CHKiRet(strm.Construct(&act->pStrm));
+
 	/* we access some data items a bit dirty, as we need to refactor the whole
 	 * thing in any case - TODO
 	 */
@@ -1451,16 +1879,21 @@ openFileWithStateFile(act_obj_t *const act)
 		DBGPRINTF("prev_msg_segment present in state file 2, is: %s\n", ret);
 	}
 	fjson_object_put(json);
+	json = NULL;
 
 	CHKiRet(strm.SetFName(act->pStrm, (uchar*)act->name, strlen(act->name)));
 	CHKiRet(strm.SettOperationsMode(act->pStrm, STREAMMODE_READ));
 	CHKiRet(strm.SetsType(act->pStrm, STREAMTYPE_FILE_MONITOR));
 	CHKiRet(strm.SetFileNotFoundError(act->pStrm, inst->fileNotFoundError));
+	CHKiRet(strm.SetsIOBufSize(act->pStrm, READ_BUF_SIZE));
 	CHKiRet(strm.ConstructFinalize(act->pStrm));
 
 	CHKiRet(strm.SeekCurrOffs(act->pStrm));
 
 finalize_it:
+	if(json != NULL) {
+		fjson_object_put(json);
+	}
 	if(fd >= 0) {
 		close(fd);
 	}
@@ -1485,6 +1918,7 @@ openFileWithoutStateFile(act_obj_t *const act)
 	CHKiRet(strm.SetsType(act->pStrm, STREAMTYPE_FILE_MONITOR));
 	CHKiRet(strm.SetFName(act->pStrm, (uchar*)act->name, strlen(act->name)));
 	CHKiRet(strm.SetFileNotFoundError(act->pStrm, inst->fileNotFoundError));
+	CHKiRet(strm.SetsIOBufSize(act->pStrm, READ_BUF_SIZE));
 	CHKiRet(strm.ConstructFinalize(act->pStrm));
 
 	/* As a state file not exist, this is a fresh start. seek to file end
@@ -1621,6 +2055,222 @@ finalize_it: RETiRet;
 }
 
 
+/* queue a file for the reader pool. rdrMut must be locked. */
+static void ATTR_NONNULL()
+rdrEnqueue(act_obj_t *const act)
+{
+	act->rdrState = RDR_QUEUED;
+	act->rdrNext = NULL;
+	if(rdrQueueLast == NULL) {
+		rdrQueueRoot = act;
+	} else {
+		rdrQueueLast->rdrNext = act;
+	}
+	rdrQueueLast = act;
+	pthread_cond_signal(&rdrWork);
+}
+
+
+/* poll a file. If the reader pool is active, this is handed over to it,
+ * otherwise the file is read directly on the input thread.
+ */
+static void ATTR_NONNULL(1)
+pollFileAsync(act_obj_t *const act)
+{
+	if(rdrThrds == NULL) {
+		pollFile(act);
+		return;
+	}
+	if(act->is_symlink)
+		return; /* no reason to poll symlink file */
+
+	pthread_mutex_lock(&rdrMut);
+	if(act->rdrState == RDR_IDLE) {
+		rdrEnqueue(act);
+	} else if(act->rdrState == RDR_ACTIVE) {
+		act->rdrState = RDR_REPOLL; /* reader may already have hit EOF */
+	}
+	pthread_mutex_unlock(&rdrMut);
+}
+
+
+/* check if an act object is currently not owned by a reader. As only the input
+ * thread hands out work, the result stays valid until it calls pollFileAsync().
+ */
+static int ATTR_NONNULL(1)
+rdrActIsIdle(const act_obj_t *const act)
+{
+	int r;
+	if(rdrThrds == NULL)
+		return 1;
+	pthread_mutex_lock(&rdrMut);
+	r = (act->rdrState == RDR_IDLE);
+	pthread_mutex_unlock(&rdrMut);
+	return r;
+}
+
+
+/* wait until an act object is no longer owned by a reader */
+static void ATTR_NONNULL(1)
+rdrWaitActIdle(const act_obj_t *const act)
+{
+	if(rdrThrds == NULL)
+		return;
+	pthread_mutex_lock(&rdrMut);
+	pthread_cleanup_push(mutexCancelCleanup, &rdrMut);
+	while(act->rdrState != RDR_IDLE) {
+		pthread_cond_wait(&rdrIdle, &rdrMut);
+	}
+	pthread_cleanup_pop(1);
+}
+
+
+/* wait until all queued files have been read */
+static void
+rdrWaitAllIdle(void)
+{
+	if(rdrThrds == NULL)
+		return;
+	pthread_mutex_lock(&rdrMut);
+	pthread_cleanup_push(mutexCancelCleanup, &rdrMut);
+	while(rdrQueueRoot != NULL || rdrNumActive > 0) {
+		pthread_cond_wait(&rdrIdle, &rdrMut);
+	}
+	pthread_cleanup_pop(1);
+}
+
+
+/* a reader thread. Each act object uses its own ratelimiter and multi_submit
+ * buffer, so there is no need for per-reader submission state.
+ * Readers may be cancelled (see rdrCancelCleanup()), just like the input
+ * thread could be cancelled while it read files itself.
+ */
+static void *
+rdrWorker(void __attribute__((unused)) *arg)
+{
+	act_obj_t *act;
+
+	pthread_mutex_lock(&rdrMut);
+	while(1) {
+		pthread_cleanup_push(mutexCancelCleanup, &rdrMut);
+		while(rdrQueueRoot == NULL && !bRdrTerminate) {
+			pthread_cond_wait(&rdrWork, &rdrMut);
+		}
+		pthread_cleanup_pop(0);
+		if(rdrQueueRoot == NULL)
+			break; /* terminate requested and nothing left to do */
+		act = rdrQueueRoot;
+		rdrQueueRoot = act->rdrNext;
+		if(rdrQueueRoot == NULL)
+			rdrQueueLast = NULL;
+		act->rdrState = RDR_ACTIVE;
+		++rdrNumActive;
+		pthread_mutex_unlock(&rdrMut);
+
+		pollFile(act);
+
+		pthread_mutex_lock(&rdrMut);
+		--rdrNumActive;
+		/* new data arrived while we were busy; queue the file behind the
+		 * others, so that a single busy file does not hog this reader.
+		 */
+		if(act->rdrState == RDR_REPOLL && glbl.GetGlobalInputTermState() == 0) {
+			rdrEnqueue(act);
+		} else {
+			act->rdrState = RDR_IDLE;
+			pthread_cond_broadcast(&rdrIdle);
+		}
+	}
+	pthread_mutex_unlock(&rdrMut);
+	return NULL;
+}
+
+
+/* start the reader pool. If that fails, files are read on the input thread. */
+static void
+startReaders(const int nReaders)
+{
+	int r;
+
+	if(nReaders < 2)
+		return;
+	bRdrTerminate = 0;
+	rdrNumActive = 0;
+	rdrQueueRoot = rdrQueueLast = NULL;
+	if((rdrThrds = calloc(nReaders, sizeof(pthread_t))) == NULL) {
+		LogError(errno, RS_RET_OUT_OF_MEMORY, "imfile: cannot create reader "
+			"threads, reading files on input thread");
+		return;
+	}
+	for(nRdrThrds = 0 ; nRdrThrds < nReaders ; ++nRdrThrds) {
+		r = pthread_create(&rdrThrds[nRdrThrds], NULL, rdrWorker, NULL);
+		if(r != 0) {
+			LogError(r, RS_RET_ERR, "imfile: error creating reader thread %d "
+				"- using only %d readers", nRdrThrds, nRdrThrds);
+			break;
+		}
+	}
+	if(nRdrThrds == 0) {
+		free(rdrThrds);
+		rdrThrds = NULL;
+	}
+	DBGPRINTF("imfile: started %d reader threads\n", nRdrThrds);
+}
+
+
+/* stop the reader pool. Readers finish what is queued, which is quick, as
+ * pollFile() stops reading once termination is requested.
+ */
+static void
+stopReaders(void)
+{
+	if(rdrThrds == NULL)
+		return;
+	pthread_mutex_lock(&rdrMut);
+	bRdrTerminate = 1;
+	pthread_cond_broadcast(&rdrWork);
+	pthread_mutex_unlock(&rdrMut);
+	/* we may be cancelled while joining, so rdrCancelCleanup() must only
+	 * see readers not yet joined.
+	 */
+	while(nRdrThrds > 0) {
+		pthread_join(rdrThrds[nRdrThrds - 1], NULL);
+		--nRdrThrds;
+	}
+	free(rdrThrds);
+	rdrThrds = NULL;
+}
+
+
+/* cancellation cleanup for the input thread while the reader pool runs. The
+ * core cancels the input thread if it does not terminate in time, e.g. because
+ * we wait for a reader which is blocked on a full queue. The readers use act
+ * objects which are destroyed after this, so they must be gone before we
+ * return. They are cancelled, as they may block indefinitely.
+ */
+static void
+rdrCancelCleanup(void __attribute__((unused)) *arg)
+{
+	int i;
+
+	if(rdrThrds == NULL)
+		return;
+	pthread_mutex_lock(&rdrMut);
+	bRdrTerminate = 1;
+	pthread_cond_broadcast(&rdrWork);
+	pthread_mutex_unlock(&rdrMut);
+	for(i = 0 ; i < nRdrThrds ; ++i) {
+		pthread_cancel(rdrThrds[i]);
+	}
+	for(i = 0 ; i < nRdrThrds ; ++i) {
+		pthread_join(rdrThrds[i], NULL);
+	}
+	free(rdrThrds);
+	rdrThrds = NULL;
+	DBGPRINTF("imfile: reader threads cancelled\n");
+}
+
+
 /* create input instance, set default parameters, and
  * add it to the list of instances.
  */
@@ -1949,10 +2599,13 @@ CODESTARTbeginCnfLoad
 	loadModConf->configSetViaV2Method = 0;
 	loadModConf->readTimeout = 0; /* default: no timeout */
 	loadModConf->timeoutGranularity = 1000; /* default: 1 second */
+	loadModConf->nReaders = 1;
 	loadModConf->haveReadTimeouts = 0; /* default: no timeout */
 	loadModConf->normalizePath = 1;
 	loadModConf->sortFiles = GLOB_NOSORT;
 	loadModConf->stateFileDirectory = NULL;
+	loadModConf->bConsolidatedState = 0;
+	loadModConf->stateFlushInterval = DFLT_StateFlushInterval;
 	loadModConf->conf_tree = calloc(sizeof(fs_node_t), 1);
 	loadModConf->conf_tree->edges = NULL;
 	bLegacyCnfModGlobalsPermitted = 1;
@@ -2010,6 +2663,12 @@ CODESTARTsetModCnf
 			loadModConf->stateFileDirectory = (uchar*)es_str2cstr(pvals[i].val.d.estr, NULL);
 		} else if(!strcmp(modpblk.descr[i].name, "normalizepath")) {
 			loadModConf->normalizePath = (sbool) pvals[i].val.d.n;
+		} else if(!strcmp(modpblk.descr[i].name, "readerthreads")) {
+			loadModConf->nReaders = (int) pvals[i].val.d.n;
+		} else if(!strcmp(modpblk.descr[i].name, "statefile.consolidated")) {
+			loadModConf->bConsolidatedState = (sbool) pvals[i].val.d.n;
+		} else if(!strcmp(modpblk.descr[i].name, "statefile.flushinterval")) {
+			loadModConf->stateFlushInterval = (int) pvals[i].val.d.n;
 		} else if(!strcmp(modpblk.descr[i].name, "mode")) {
 			if(!es_strconstcmp(pvals[i].val.d.estr, "polling"))
 				loadModConf->opMode = OPMODE_POLLING;
@@ -2126,6 +2785,11 @@ CODESTARTactivateCnf
 		fs_node_print(runModConf->conf_tree, 0);
 	}
 
+	if(runModConf->bConsolidatedState && stateDbOpen() != RS_RET_OK) {
+		LogError(0, RS_RET_ERR, "imfile: could not set up consolidated state file, "
+			"using per-file state files instead");
+	}
+
 finalize_it:
 ENDactivateCnf
 
@@ -2134,6 +2798,10 @@ BEGINfreeCnf
 	instanceConf_t *inst, *del;
 CODESTARTfreeCnf
 	fs_node_destroy(pModConf->conf_tree);
+	nActSymlinkTargets = 0; /* all active objects are gone now */
+	if(pModConf == runModConf) {
+		stateDbClose(); /* after fs_node_destroy, which persists all file states */
+	}
 	for(inst = pModConf->root ; inst != NULL ; ) {
 		free(inst->pszBindRuleset);
 		free(inst->pszFileName);
@@ -2170,6 +2838,8 @@ static void
 do_initial_poll_run(void)
 {
 	fs_node_walk(runModConf->conf_tree, poll_tree);
+	/* readers must have opened (and possibly seeked) all files before we reset */
+	rdrWaitAllIdle();
 
 	/* fresh start done, so disable freshStartTail for files that now will be created */
 	for(instanceConf_t *inst = runModConf->root ; inst != NULL ; inst = inst->next) {
@@ -2189,6 +2859,8 @@ doPolling(void)
 		do {
 			runModConf->bHadFileData = 0;
 			fs_node_walk(runModConf->conf_tree, poll_tree);
+			rdrWaitAllIdle();
+			stateDbFlushIfDue();
 			DBGPRINTF("doPolling: end poll walk, hadData %d\n", runModConf->bHadFileData);
 		} while(runModConf->bHadFileData); /* warning: do...while()! */
 
@@ -2262,7 +2934,7 @@ in_handleFileEvent(struct inotify_event *ev, const wd_map_t *const etry)
 {
 	if(ev->mask & IN_MODIFY) {
 		DBGPRINTF("fs_node_notify_file_update: act->name '%s'\n", etry->act->name);
-		pollFile(etry->act);
+		pollFileAsync(etry->act);
 	} else {
 		DBGPRINTF("got non-expected inotify event:\n");
 		in_dbg_showEv(ev);
@@ -2270,6 +2942,87 @@ in_handleFileEvent(struct inotify_event *ev, const wd_map_t *const etry)
 }
 
 
+/* poll a directory which newly appeared for directory edge dir_edge. Only
+ * the new directory is globbed (recursively), not the complete tree.
+ */
+static void ATTR_NONNULL()
+poll_new_dir(fs_edge_t *const dir_edge, const char *const dirname)
+{
+	fs_edge_t *chld;
+	char pattern[MAXFNAME];
+	glob_t files;
+
+	DBGPRINTF("poll_new_dir: '%s'\n", dirname);
+	for(chld = dir_edge->node->edges ; chld != NULL ; chld = chld->next) {
+		if(gen_full_name(pattern, sizeof(pattern), dirname, (char*) chld->name) != 0) {
+			LogError(0, RS_RET_ERR, "imfile: path name too long for '%s' - ignored", dirname);
+			continue;
+		}
+		if(glob(pattern, runModConf->sortFiles|GLOB_BRACE, NULL, &files) == 0) {
+			for(unsigned i = 0 ; i < files.gl_pathc ; i++) {
+				if(glbl.GetGlobalInputTermState() != 0) {
+					break;
+				}
+				poll_tree_file(chld, files.gl_pathv[i]);
+				if(!chld->is_file) {
+					poll_new_dir(chld, files.gl_pathv[i]);
+				}
+			}
+		}
+		globfree(&files);
+	}
+}
+
+
+/* handle an event on a watched directory. Only the object named in the
+ * event is checked, so that the cost does not depend on the number of
+ * objects already monitored. Returns 0 if the event cannot be handled
+ * this way, in which case the caller must walk the tree.
+ */
+static int ATTR_NONNULL(1, 2)
+in_handleDirEvent(struct inotify_event *const ev, act_obj_t *const dirAct)
+{
+	fs_edge_t *chld;
+	char name[MAXFNAME];
+
+	if(ev->len == 0 || ev->name[0] == '\0' || nActSymlinkTargets != 0) {
+		return 0;
+	}
+	if((ev->mask & IN_ISDIR) && (ev->mask & (IN_DELETE | IN_MOVED_FROM))) {
+		return 0; /* complete subtree is gone, needs full walk */
+	}
+	if(!(ev->mask & (IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM))) {
+		return 0;
+	}
+	for(chld = dirAct->edge->node->edges ; chld != NULL ; chld = chld->next) {
+		if(strchr((char*) chld->name, '{') != NULL) {
+			return 0; /* GLOB_BRACE pattern, fnmatch() cannot handle it */
+		}
+	}
+	if(gen_full_name(name, sizeof(name), dirAct->name, ev->name) != 0) {
+		return 0;
+	}
+
+	DBGPRINTF("in_handleDirEvent: '%s'\n", name);
+	for(chld = dirAct->edge->node->edges ; chld != NULL ; chld = chld->next) {
+		if(fnmatch((char*) chld->name, ev->name, FNM_PERIOD) != 0) {
+			continue;
+		}
+		act_obj_t *const act = act_obj_find(chld, name);
+		if(act != NULL) {
+			act_obj_chk_gone(act);
+		}
+		if(ev->mask & (IN_CREATE | IN_MOVED_TO)) {
+			poll_tree_file(chld, name);
+			if(!chld->is_file && (ev->mask & IN_ISDIR)) {
+				poll_new_dir(chld, name);
+			}
+		}
+	}
+	return 1;
+}
+
+
 /* workaround for IN_MOVED: walk active list and prevent state file deletion of
  * IN_MOVED_IN active object
  * TODO: replace by a more generic solution.
@@ -2316,7 +3069,9 @@ in_processEvent(struct inotify_event *ev)
 	if((ev->mask & IN_MOVED_FROM)) {
 		flag_in_move(etry->act->edge->node->edges, ev->name);
 	}
-	if(ev->mask & (IN_MOVED_FROM | IN_MOVED_TO))  {
+	if(!etry->act->edge->is_file && in_handleDirEvent(ev, etry->act)) {
+		; /* all done */
+	} else if(ev->mask & (IN_MOVED_FROM | IN_MOVED_TO))  {
 		fs_node_walk(etry->act->edge->node, poll_tree);
 	} else if(etry->act->edge->is_file && !(etry->act->is_symlink)) {
 		in_handleFileEvent(ev, etry); // esentially poll_file()!
@@ -2352,17 +3107,21 @@ do_inotify(void)
 	do_initial_poll_run();
 
 	while(glbl.GetGlobalInputTermState() == 0) {
-		if(runModConf->haveReadTimeouts) {
+		if(runModConf->haveReadTimeouts || stateDb != NULL) {
 			int r;
 			struct pollfd pollfd;
 			pollfd.fd = ino_fd;
 			pollfd.events = POLLIN;
 			do {
-				r = poll(&pollfd, 1, runModConf->timeoutGranularity);
+				r = poll(&pollfd, 1, runModConf->haveReadTimeouts ?
+					runModConf->timeoutGranularity : runModConf->stateFlushInterval * 1000);
 			} while(r  == -1 && errno == EINTR);
 			if(r == 0) {
-				DBGPRINTF("readTimeouts are configured, checking if some apply\n");
-				fs_node_walk(runModConf->conf_tree, poll_timeouts);
+				if(runModConf->haveReadTimeouts) {
+					DBGPRINTF("readTimeouts are configured, checking if some apply\n");
+					fs_node_walk(runModConf->conf_tree, poll_timeouts);
+				}
+				stateDbFlushIfDue();
 				continue;
 			} else if (r == -1) {
 				LogError(errno, RS_RET_INTERNAL_ERROR,
@@ -2395,6 +3154,7 @@ do_inotify(void)
 			in_processEvent(ev);
 			currev += sizeof(struct inotify_event) + ev->len;
 		}
+		stateDbFlushIfDue();
 	}
 
 finalize_it:
@@ -2501,6 +3261,7 @@ do_fen(void)
 				fs_node_walk(act->edge->node, poll_tree);
 			}
 		}
+		stateDbFlushIfDue();
 	}
 
 	/* close port, will de-activate all file events watches associated
@@ -2536,11 +3297,19 @@ CODESTARTrunInput
 	DBGPRINTF("working in %s mode\n",
 		 (runModConf->opMode == OPMODE_POLLING) ? "polling" :
 			((runModConf->opMode == OPMODE_INOTIFY) ?"inotify" : "fen"));
-	if(runModConf->opMode == OPMODE_POLLING)
+	if(runModConf->opMode == OPMODE_POLLING) {
+		startReaders(runModConf->nReaders);
+		pthread_cleanup_push(rdrCancelCleanup, NULL);
 		iRet = doPolling();
-	else if(runModConf->opMode == OPMODE_INOTIFY)
+		stopReaders();
+		pthread_cleanup_pop(0);
+	} else if(runModConf->opMode == OPMODE_INOTIFY) {
+		startReaders(runModConf->nReaders);
+		pthread_cleanup_push(rdrCancelCleanup, NULL);
 		iRet = do_inotify();
-	else if(runModConf->opMode == OPMODE_FEN)
+		stopReaders();
+		pthread_cleanup_pop(0);
+	} else if(runModConf->opMode == OPMODE_FEN)
 		iRet = do_fen();
 	else {
 		LogError(0, RS_RET_NOT_IMPLEMENTED, "imfile: unknown mode %d set",
@@ -2613,7 +3382,11 @@ persistStrmState(act_obj_t *const act)
 
 	uchar *const statefn = getStateFileName(act, statefile, sizeof(statefile));
 	getFileID(act);
-	getFullStateFileName(statefn, act->file_id, statefname, sizeof(statefname));
+	if(stateDb != NULL) {
+		stateDbKey((char*) statefname, sizeof(statefname), statefn, act->file_id);
+	} else {
+		getFullStateFileName(statefn, act->file_id, statefname, sizeof(statefname));
+	}
 	DBGPRINTF("persisting state for '%s', state file '%s'\n", act->name, statefname);
 
 	struct json_object *jval = NULL;
@@ -2646,7 +3419,12 @@ persistStrmState(act_obj_t *const act)
 
 	const char *jstr =  json_object_to_json_string_ext(json, JSON_C_TO_STRING_SPACED);
 
-	CHKiRet(atomicWriteStateFile((const char*)statefname, jstr));
+	if(stateDb != NULL) {
+		/* written to disk on next flush of the consolidated state file */
+		stateDbPut((const char*)statefname, jstr);
+	} else {
+		CHKiRet(atomicWriteStateFile((const char*)statefname, jstr));
+	}
 	json_object_put(json);
 
 finalize_it:
@@ -2690,7 +3468,8 @@ CODESTARTmodExit
 	objRelease(ruleset, CORE_COMPONENT);
 
 	#ifdef HAVE_INOTIFY_INIT
-	free(wdmap);
+	if(wdmap != NULL)
+		hashtable_destroy(wdmap, 1);
 	#endif
 ENDmodExit
 
@@ -84,6 +84,8 @@ static struct configSettings_s {
 	int bWorkAroundJournalBug; /* deprecated, left for backwards compatibility only */
 	int bFsync;
 	int bRemote;
+	char **fields;	/* fields to include in $!, NULL means all */
+	int nFields;
 } cs;
 
 static rsRetVal facilityHdlr(uchar **pp, void *pVal);
@@ -102,7 +104,8 @@ static struct cnfparamdescr modpdescr[] = {
 	{ "usepid", eCmdHdlrString, 0 },
 	{ "workaroundjournalbug", eCmdHdlrBinary, 0 },
 	{ "fsync", eCmdHdlrBinary, 0 },
-	{ "remote", eCmdHdlrBinary, 0 }
+	{ "remote", eCmdHdlrBinary, 0 },
+	{ "fields", eCmdHdlrArray, 0 }
 };
 static struct cnfparamblk modpblk =
 	{ CNFPARAMBLK_VERSION,
@@ -139,10 +142,12 @@ struct journalContext_s { /* structure encapsulating all the journald_API-relate
 	sbool reloaded; /* we have reloaded journal after detecting rotation */
 	sbool atHead; /* true if we are at start of journal (no seek was done) */
 	char *cursor; /* should point to last valid journald entry we processed */
+	sbool cursorStale; /* entries were processed since cursor was last obtained */
 };
-static struct journalContext_s journalContext = {NULL, 0, 1, NULL};
+static struct journalContext_s journalContext = {NULL, 0, 1, NULL, 0};
 
 #define J_PROCESS_PERIOD 1024  /* Call sd_journal_process() every 1,024 records */
+#define J_USAGE_PERIOD 1024  /* update disk usage counter every 1,024 records */
 
 static rsRetVal persistJournalState(void);
 static rsRetVal loadJournalState(void);
@@ -261,6 +266,21 @@ readJSONfromJournalMsg(struct fjson_object **json)
 
 	CHKmalloc(*json = fjson_object_new_object());
 
+	if(cs.fields != NULL) {
+		/* only fetch the configured fields, all others are never copied */
+		for(int i = 0 ; i < cs.nFields ; ++i) {
+			char *data;
+			if(sd_journal_get_data(journalContext.j, cs.fields[i], &get, &l) < 0)
+				continue; /* not present in this entry */
+			prefixlen = strlen(cs.fields[i]) + 1; /* name + '=' */
+			CHKiRet(sanitizeValue(((const char *)get) + prefixlen, l - prefixlen, &data));
+			jval = fjson_object_new_string(data);
+			fjson_object_object_add(*json, cs.fields[i], jval);
+			free(data);
+		}
+		FINALIZE;
+	}
+
 	SD_JOURNAL_FOREACH_DATA(journalContext.j, get, l) {
 		char *data;
 		char *name;
@@ -319,6 +339,26 @@ finalize_it:
 }
 
 
+/* Obtain the cursor of the last processed entry, if not yet done. Getting
+ * the cursor is costly (the journal library formats and allocates it), so
+ * we only do it when it is actually needed: before state is persisted and
+ * before we wait for new entries, as a journal rotation may then require
+ * to seek back to it.
+ */
+static rsRetVal
+syncJournalCursor(void)
+{
+	DEFiRet;
+
+	if(journalContext.cursorStale && journalContext.j != NULL) {
+		CHKiRet(updateJournalCursor());
+		journalContext.cursorStale = 0;
+	}
+finalize_it:
+	RETiRet;
+}
+
+
 /* enqueue the the journal message into the message queue.
  * The provided msg string is not freed - thus must be done
  * by the caller.
@@ -487,7 +527,9 @@ readjournal(void)
 		ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
 	}
 
-	CHKiRet(readJSONfromJournalMsg(&json));
+	if(cs.fields == NULL || cs.nFields > 0) {
+		CHKiRet(readJSONfromJournalMsg(&json));
+	}
 
 	/* calculate timestamp */
 	if (sd_journal_get_realtime_usec(journalContext.j, &timestamp) >= 0) {
@@ -495,7 +537,8 @@ readjournal(void)
 		tv.tv_usec = timestamp % 1000000;
 	}
 
-	iRet = updateJournalCursor();
+	/* cursor is obtained lazily, see syncJournalCursor() */
+	journalContext.cursorStale = 1;
 
 	/* submit message */
 	enqMsg((uchar *)message, (uchar *) sys_iden_help, facility, severity, &tv, json, 0);
@@ -750,10 +793,27 @@ finalize_it:
 	RETiRet;
 }
 
+static void
+updateDiskUsage(void)
+{
+	const int e = sd_journal_get_usage(journalContext.j, (uint64_t *)&statsCounter.diskUsageBytes);
+	if (e < 0) {
+		LogError(-e, RS_RET_ERR, "imjournal: sd_get_usage() failed");
+	}
+}
+
+
 static void
 tryRecover(void) {
 	LogMsg(0, RS_RET_OK, LOG_INFO, "imjournal: trying to recover from journal error");
 	STATSCOUNTER_INC(statsCounter.ctrRecoveryAttempts, statsCounter.mutCtrRecoveryAttempts);
+	/* We must NOT sync the cursor here: after an error the journal may be
+	 * positioned on an entry that was not processed, and saving its cursor
+	 * would skip that entry after reopen. So we drop the stale state and
+	 * keep the last cursor obtained. This may lead to some duplicates, but
+	 * does not lose messages.
+	 */
+	journalContext.cursorStale = 0;
 	closeJournal();
 	srSleep(10, 0);	// do not hammer machine with too-frequent retries
 	openJournal();
@@ -819,6 +879,9 @@ CODESTARTrunInput
 				LogMsg(0, RS_RET_OK, LOG_WARNING, "imjournal: "
 						"Journal indicates no msgs when positioned at head.\n");
 			}
+			/* we are idle: good time to update what we only do per batch */
+			syncJournalCursor();
+			updateDiskUsage();
 			/* No new messages, wait for activity. */
 			if (pollJournal() != RS_RET_OK && !journalContext.reloaded) {
 				tryRecover();
@@ -827,11 +890,11 @@ CODESTARTrunInput
 		}
 
 		/*
-		 * update journal disk usage before reading the new message.
+		 * update journal disk usage, this is costly so we do it only
+		 * once per batch of messages.
 		 */
-		const int e = sd_journal_get_usage(journalContext.j, (uint64_t *)&statsCounter.diskUsageBytes);
-		if (e < 0) {
-			LogError(-e, RS_RET_ERR, "imjournal: sd_get_usage() failed");
+		if (count % J_USAGE_PERIOD == 0) {
+			updateDiskUsage();
 		}
 
 		if (readjournal() != RS_RET_OK) {
@@ -845,6 +908,7 @@ CODESTARTrunInput
 		if (cs.stateFile) { /* can't persist without a state file */
 			/* TODO: This could use some finer metric. */
 			if ((count % cs.iPersistStateInterval) == 0) {
+				syncJournalCursor();
 				persistJournalState();
 			}
 		}
@@ -870,6 +934,8 @@ CODESTARTbeginCnfLoad
 	cs.bWorkAroundJournalBug = 1;
 	cs.bFsync = 0;
 	cs.bRemote = 0;
+	cs.fields = NULL;
+	cs.nFields = 0;
 ENDbeginCnfLoad
 
 
@@ -937,6 +1003,9 @@ BEGINfreeCnf
 CODESTARTfreeCnf
 	free(cs.stateFile);
 	free(cs.usePid);
+	for(int i = 0 ; i < cs.nFields ; ++i)
+		free(cs.fields[i]);
+	free(cs.fields);
 	free(journalContext.cursor);
 	statsobj.Destruct(&(statsCounter.stats));
 ENDfreeCnf
@@ -951,6 +1020,7 @@ ENDwillRun
 BEGINafterRun
 CODESTARTafterRun
 	if (cs.stateFile) { /* can't persist without a state file */
+		syncJournalCursor();
 		persistJournalState();
 	}
 	closeJournal();
@@ -1027,6 +1097,12 @@ CODESTARTsetModCnf
 			cs.bFsync = (int) pvals[i].val.d.n;
 		} else if (!strcmp(modpblk.descr[i].name, "remote")) {
 			cs.bRemote = (int) pvals[i].val.d.n;
+		} else if (!strcmp(modpblk.descr[i].name, "fields")) {
+			cs.nFields = pvals[i].val.d.ar->nmemb;
+			CHKmalloc(cs.fields = calloc(cs.nFields + 1, sizeof(char*)));
+			for(int j = 0 ; j < cs.nFields ; ++j) {
+				cs.fields[j] = es_str2cstr(pvals[i].val.d.ar->arr[j], NULL);
+			}
 		} else {
 			dbgprintf("imjournal: program error, non-handled "
 				"param '%s' in beginCnfLoad\n", modpblk.descr[i].name);
@@ -71,6 +71,24 @@ struct kafka_params {
 	const char *val;
 };
 
+/* per-partition statistics. These are created on the fly when we see the
+ * first message from a partition, as partitions are assigned dynamically
+ * by the consumer group.
+ */
+struct partStats_s {
+	int32_t partition;
+	int64_t lastOffset;	/* offset of last message received, -1 if none */
+	statsobj_t *stats;
+	STATSCOUNTER_DEF(ctrRcvd, mutCtrRcvd)
+	intctr_t ctrLag;	/* gauge: high watermark - next offset to consume */
+};
+
+#define DFLT_BATCHSIZE 500
+/* max time we wait for a batch to fill. Note that this is also the max
+ * latency added for low-volume topics, so keep it short.
+ */
+#define KAFKA_BATCH_TIMEOUT_MS 100
+
 /* Module static data */
 static struct configSettings_s {
 	uchar *topic;
@@ -98,6 +116,12 @@ struct instanceConf_s {
 	int partition;
 	int bIsSubscribed;
 	int nMsgParsingFlags;
+	int batchSize;			/* max nbr of messages to consume in one batch */
+	sbool bBatchCommit;		/* commit offsets asynchronously after each batch */
+	rd_kafka_queue_t *rkqu;		/* consumer queue we consume batches from */
+	rd_kafka_message_t **rkmessages; /* batch buffer, batchSize entries */
+	struct partStats_s **partStats;	/* only accessed by the instance's worker */
+	int nPartStats;
 
 	struct instanceConf_s *next;
 };
@@ -148,6 +172,8 @@ static struct cnfparamdescr inppdescr[] = {
 	{ "consumergroup", eCmdHdlrString, 0},
 	{ "ruleset", eCmdHdlrString, 0 },
 	{ "parsehostname", eCmdHdlrBinary, 0 },
+	{ "batchsize", eCmdHdlrPositiveInt, 0 },
+	{ "batch.commit", eCmdHdlrBinary, 0 },
 };
 static struct cnfparamblk inppblk =
 	{ CNFPARAMBLK_VERSION,
@@ -173,11 +199,101 @@ kafkaLogger(const rd_kafka_t __attribute__((unused)) *rk, int level,
 }
 
 
+/* find the stats object for a partition, creating it if it does not
+ * yet exist. Returns NULL if we run out of memory - in that case, we
+ * simply do not maintain stats for that partition.
+ */
+static struct partStats_s *
+getPartStats(instanceConf_t *const inst, const int32_t partition)
+{
+	struct partStats_s *ps = NULL;
+	struct partStats_s **newArr;
+	uchar statname[256];
+	int i;
+	DEFiRet;
+
+	for(i = 0 ; i < inst->nPartStats ; ++i) {
+		if(inst->partStats[i]->partition == partition)
+			return inst->partStats[i];
+	}
+
+	CHKmalloc(newArr = realloc(inst->partStats, (inst->nPartStats + 1) * sizeof(struct partStats_s*)));
+	inst->partStats = newArr;
+	CHKmalloc(ps = calloc(1, sizeof(struct partStats_s)));
+	ps->partition = partition;
+	ps->lastOffset = -1;
+	snprintf((char*)statname, sizeof(statname), "imkafka(%s/%d)", inst->topic, (int) partition);
+	CHKiRet(statsobj.Construct(&ps->stats));
+	CHKiRet(statsobj.SetName(ps->stats, statname));
+	CHKiRet(statsobj.SetOrigin(ps->stats, UCHAR_CONSTANT("imkafka")));
+	STATSCOUNTER_INIT(ps->ctrRcvd, ps->mutCtrRcvd);
+	CHKiRet(statsobj.AddCounter(ps->stats, UCHAR_CONSTANT("received"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ps->ctrRcvd));
+	CHKiRet(statsobj.AddCounter(ps->stats, UCHAR_CONSTANT("lag"),
+		ctrType_IntCtr, CTR_FLAG_NONE, &ps->ctrLag));
+	CHKiRet(statsobj.ConstructFinalize(ps->stats));
+	inst->partStats[inst->nPartStats++] = ps;
+
+finalize_it:
+	if(iRet != RS_RET_OK) {
+		LogError(0, iRet, "imkafka: could not create statistics for %s/%d",
+			inst->topic, (int) partition);
+		if(ps != NULL) {
+			if(ps->stats != NULL)
+				statsobj.Destruct(&ps->stats);
+			free(ps);
+			ps = NULL;
+		}
+	}
+	return ps;
+}
+
+
+/* update the lag gauges of all partitions we have seen so far. We use
+ * the locally cached watermarks, so this does not involve a broker
+ * round-trip.
+ */
+static void
+updatePartLag(instanceConf_t *const inst)
+{
+	int64_t low, high;
+	int i;
+
+	for(i = 0 ; i < inst->nPartStats ; ++i) {
+		struct partStats_s *const ps = inst->partStats[i];
+		if(ps->lastOffset < 0)
+			continue;
+		if(rd_kafka_get_watermark_offsets(inst->rk, (const char*) inst->topic, ps->partition,
+			&low, &high) != RD_KAFKA_RESP_ERR_NO_ERROR || high < 0)
+			continue;
+		ps->ctrLag = (high > ps->lastOffset + 1) ? (intctr_t) (high - (ps->lastOffset + 1)) : 0;
+	}
+}
+
+
+static void
+freePartStats(instanceConf_t *const inst)
+{
+	int i;
+
+	for(i = 0 ; i < inst->nPartStats ; ++i) {
+		statsobj.Destruct(&inst->partStats[i]->stats);
+		free(inst->partStats[i]);
+	}
+	free(inst->partStats);
+	inst->partStats = NULL;
+	inst->nPartStats = 0;
+}
+
+
 /* enqueue the kafka message. The provided string is
  * not freed - thuis must be done by the caller.
+ * The message is added to the provided multi-submit batch, which must be
+ * flushed by the caller.
  */
 static rsRetVal enqMsg(instanceConf_t *const __restrict__ inst,
-			rd_kafka_message_t *const __restrict__ rkmessage)
+			rd_kafka_message_t *const __restrict__ rkmessage,
+			multi_submit_t *const __restrict__ pMultiSub)
 {
 	DEFiRet;
 	smsg_t *pMsg;
@@ -202,73 +318,134 @@ DBGPRINTF("imkafka: enqMsg: Msg: %.*s\n", (int)rkmessage->len, (char *)rkmessage
 	}
 	MsgSetMSGoffs(pMsg, 0);	/* we do not have a header... */
 
-	CHKiRet(submitMsg2(pMsg));
+	if(pMsg->iLenRawMsg > glblGetMaxLine()) {
+		/* oversize message needs special processing, which only
+		 * submitMsg2() does. We keep the previous batch as batch...
+		 */
+		CHKiRet(multiSubmitMsg2(pMultiSub));
+		CHKiRet(submitMsg2(pMsg));
+		FINALIZE;
+	}
+	pMultiSub->ppMsgs[pMultiSub->nElem++] = pMsg;
+	if(pMultiSub->nElem == pMultiSub->maxElem)
+		CHKiRet(multiSubmitMsg2(pMultiSub));
 
 finalize_it:
 	RETiRet;
 }
 
+/* process a single message of a batch. Errors are reported, but do not
+ * abort processing of the rest of the batch.
+ */
+static void
+processKafkaMsg(instanceConf_t *const inst, rd_kafka_message_t *const rkmessage,
+	multi_submit_t *const pMultiSub)
+{
+	struct partStats_s *ps;
+
+	if (rkmessage->err) {
+		if (rkmessage->err == RD_KAFKA_RESP_ERR__PARTITION_EOF) {
+			/* not an error, just a regular status! */
+			DBGPRINTF("imkafka: Consumer "
+				"reached end of topic \"%s\" [%"PRId32"]"
+				"message queue offset %"PRId64"\n",
+				rd_kafka_topic_name(rkmessage->rkt),
+				rkmessage->partition,
+				rkmessage->offset);
+			return;
+		}
+		if (rkmessage->rkt) {
+			LogError(0, RS_RET_KAFKA_ERROR,
+			"imkafka: Consumer error for topic \"%s\" [%"PRId32"]"
+			"message queue offset %"PRId64": %s\n",
+				rd_kafka_topic_name(rkmessage->rkt),
+				rkmessage->partition,
+				rkmessage->offset,
+				rd_kafka_message_errstr(rkmessage));
+		} else {
+			LogError(0, RS_RET_KAFKA_ERROR,
+				"imkafka: Consumer error for topic \"%s\": \"%s\"\n",
+				rd_kafka_err2str(rkmessage->err),
+				rd_kafka_message_errstr(rkmessage));
+		}
+		return;
+	}
+
+	DBGPRINTF("imkafka: msgConsume Loop on %s/%s/%s: [%"PRId32"], "
+				"offset %"PRId64", %zd bytes):\n",
+				rd_kafka_topic_name(rkmessage->rkt) /*inst->topic*/,
+				inst->consumergroup,
+				inst->brokers,
+				rkmessage->partition,
+				rkmessage->offset,
+				rkmessage->len);
+	if((ps = getPartStats(inst, rkmessage->partition)) != NULL) {
+		STATSCOUNTER_INC(ps->ctrRcvd, ps->mutCtrRcvd);
+		ps->lastOffset = rkmessage->offset;
+	}
+	enqMsg(inst, rkmessage, pMultiSub);
+}
+
 /**
- * Handle Kafka Consumer Loop until all msgs are processed
+ * Handle Kafka Consumer Loop until all msgs are processed.
+ * Messages are consumed in batches from the consumer queue (which all
+ * assigned partitions are forwarded to) and submitted to the ruleset
+ * queue as one multi-submit batch.
  */
 static void msgConsume (instanceConf_t *inst) {
-	rd_kafka_message_t *rkmessage = NULL;
-
-	do { /* Consume messages */
-		rkmessage = rd_kafka_consumer_poll(inst->rk, 1000); /* Block for 1000 ms max */
-		if(rkmessage == NULL) {
-			DBGPRINTF("imkafka: msgConsume EMPTY Loop on %s/%s/%s\n",
-				inst->topic, inst->consumergroup, inst->brokers);
-			goto done;
+	smsg_t *pMsgs[CONF_NUM_MULTISUB];
+	multi_submit_t multiSub;
+	rd_kafka_resp_err_t err;
+	ssize_t nMsgs;
+	ssize_t i;
+
+	if(inst->rkqu == NULL) {
+		if((inst->rkqu = rd_kafka_queue_get_consumer(inst->rk)) == NULL) {
+			DBGPRINTF("imkafka: msgConsume could not obtain consumer queue "
+				"on %s/%s/%s\n", inst->topic, inst->consumergroup, inst->brokers);
+			return;
 		}
+	}
 
-		if (rkmessage->err) {
-			if (rkmessage->err == RD_KAFKA_RESP_ERR__PARTITION_EOF) {
-				/* not an error, just a regular status! */
-				DBGPRINTF("imkafka: Consumer "
-					"reached end of topic \"%s\" [%"PRId32"]"
-					"message queue offset %"PRId64"\n",
-					rd_kafka_topic_name(rkmessage->rkt),
-					rkmessage->partition,
-					rkmessage->offset);
-				goto done;
-			}
-			if (rkmessage->rkt) {
-				LogError(0, RS_RET_KAFKA_ERROR,
-				"imkafka: Consumer error for topic \"%s\" [%"PRId32"]"
-				"message queue offset %"PRId64": %s\n",
-					rd_kafka_topic_name(rkmessage->rkt),
-					rkmessage->partition,
-					rkmessage->offset,
-					rd_kafka_message_errstr(rkmessage));
+	multiSub.ppMsgs = pMsgs;
+	multiSub.maxElem = CONF_NUM_MULTISUB;
+	multiSub.nElem = 0;
+	do { /* Consume messages */
+		nMsgs = rd_kafka_consume_batch_queue(inst->rkqu, KAFKA_BATCH_TIMEOUT_MS,
+			inst->rkmessages, inst->batchSize);
+		if(nMsgs <= 0) {
+			if(nMsgs < 0) {
+				DBGPRINTF("imkafka: msgConsume batch error on %s/%s/%s: %s\n",
+					inst->topic, inst->consumergroup, inst->brokers,
+					rd_kafka_err2str(rd_kafka_last_error()));
 			} else {
-				LogError(0, RS_RET_KAFKA_ERROR,
-					"imkafka: Consumer error for topic \"%s\": \"%s\"\n",
-					rd_kafka_err2str(rkmessage->err),
-					rd_kafka_message_errstr(rkmessage));
+				DBGPRINTF("imkafka: msgConsume EMPTY Loop on %s/%s/%s\n",
+					inst->topic, inst->consumergroup, inst->brokers);
 			}
-			goto done;
+			break;
 		}
 
-		DBGPRINTF("imkafka: msgConsume Loop on %s/%s/%s: [%"PRId32"], "
-					"offset %"PRId64", %zd bytes):\n",
-					rd_kafka_topic_name(rkmessage->rkt) /*inst->topic*/,
-					inst->consumergroup,
-					inst->brokers,
-					rkmessage->partition,
-					rkmessage->offset,
-					rkmessage->len);
-		enqMsg(inst, rkmessage);
-		/* Destroy message and continue */
-		rd_kafka_message_destroy(rkmessage);
-		rkmessage = NULL;
-	} while(1); /* loop broken inside */
-done:
-	/* Destroy message in case rkmessage->err was set */
-	if(rkmessage != NULL) {
-		rd_kafka_message_destroy(rkmessage);
-	}
-	return;
+		DBGPRINTF("imkafka: msgConsume got batch of %zd messages on %s/%s/%s\n",
+			nMsgs, inst->topic, inst->consumergroup, inst->brokers);
+		for(i = 0 ; i < nMsgs ; ++i) {
+			processKafkaMsg(inst, inst->rkmessages[i], &multiSub);
+			rd_kafka_message_destroy(inst->rkmessages[i]);
+		}
+		multiSubmitFlush(&multiSub);
+		updatePartLag(inst);
+
+		if(inst->bBatchCommit) {
+			/* the batch is now in the ruleset queue, so we can commit
+			 * the consumed offsets. NO_OFFSET just means nothing new.
+			 */
+			err = rd_kafka_commit(inst->rk, NULL, 1);
+			if(err != RD_KAFKA_RESP_ERR_NO_ERROR && err != RD_KAFKA_RESP_ERR__NO_OFFSET) {
+				DBGPRINTF("imkafka: async offset commit failed on %s/%s/%s: %s\n",
+					inst->topic, inst->consumergroup, inst->brokers,
+					rd_kafka_err2str(err));
+			}
+		}
+	} while(glbl.GetGlobalInputTermState() == 0); /* loop also broken inside */
 }
 
 
@@ -300,6 +477,12 @@ createInstance(instanceConf_t **pinst)
 	inst->rk = NULL;
 	inst->topic_conf = NULL;
 	inst->partition = RD_KAFKA_PARTITION_UA;
+	inst->batchSize = DFLT_BATCHSIZE;
+	inst->bBatchCommit = 0;
+	inst->rkqu = NULL;
+	inst->rkmessages = NULL;
+	inst->partStats = NULL;
+	inst->nPartStats = 0;
 
 	/* node created, let's add to config */
 	if(loadModConf->tail == NULL) {
@@ -323,6 +506,8 @@ checkInstance(instanceConf_t *const inst)
 	int nBrokers;
 	char kafkaErrMsg[1024];
 
+	CHKmalloc(inst->rkmessages = calloc(inst->batchSize, sizeof(rd_kafka_message_t*)));
+
 	/* main kafka conf */
 	inst->conf = rd_kafka_conf_new();
 	if(inst->conf == NULL) {
@@ -343,6 +528,19 @@ checkInstance(instanceConf_t *const inst)
 	}
 #	endif
 
+	if(inst->bBatchCommit) {
+		/* we commit after each batch, so periodic auto commits are not
+		 * needed. This is set before the custom parameters, so that
+		 * the user can still override it.
+		 */
+		if(rd_kafka_conf_set(inst->conf, "enable.auto.commit", "false",
+			kafkaErrMsg, sizeof(kafkaErrMsg)) != RD_KAFKA_CONF_OK) {
+			LogError(0, RS_RET_KAFKA_ERROR, "imkafka: error disabling kafka auto commit: %s\n",
+				kafkaErrMsg);
+			/* DO NOT ABORT IN THIS CASE! */
+		}
+	}
+
 	/* Set custom configuration parameters */
 	for(int i = 0 ; i < inst->nConfParams ; ++i) {
 		assert(inst->confParams+i != NULL); /* invariant: nConfParams MUST exist! */
@@ -580,6 +778,10 @@ CODESTARTnewInpInst
 			} else {
 				inst->nMsgParsingFlags = NEEDS_PARSING;
 			}
+		} else if(!strcmp(inppblk.descr[i].name, "batchsize")) {
+			inst->batchSize = (int) pvals[i].val.d.n;
+		} else if(!strcmp(inppblk.descr[i].name, "batch.commit")) {
+			inst->bBatchCommit = (sbool) pvals[i].val.d.n;
 		} else {
 			dbgprintf("imkafka: program error, non-handled "
 			  "param '%s'\n", inppblk.descr[i].name);
@@ -694,6 +896,8 @@ CODESTARTfreeCnf
 			free((void*)inst->confParams[i].val);
 		}
 		free((void*)inst->confParams);
+		free(inst->rkmessages);
+		freePartStats(inst);
 		del = inst;
 		inst = inst->next;
 		free(del);
@@ -722,7 +926,15 @@ shutdownKafkaWorkers(void)
 	for(inst = runModConf->root ; inst != NULL ; inst = inst->next) {
 		DBGPRINTF("imkafka: stop consuming %s/%s/%s\n",
 			inst->topic, inst->consumergroup, inst->brokers);
+		if(inst->bBatchCommit && inst->bIsSubscribed) {
+			/* auto commit is off, so do a final sync commit */
+			rd_kafka_commit(inst->rk, NULL, 0);
+		}
 		rd_kafka_consumer_close(inst->rk); /* Close the consumer, committing final offsets, etc. */
+		if(inst->rkqu != NULL) {
+			rd_kafka_queue_destroy(inst->rkqu);
+			inst->rkqu = NULL;
+		}
 		rd_kafka_destroy(inst->rk); /* Destroy handle object */
 		DBGPRINTF("imkafka: stopped consuming %s/%s/%s\n",
 			inst->topic, inst->consumergroup, inst->brokers);
@@ -59,6 +59,9 @@
 #if HAVE_FCNTL_H
 #include <fcntl.h>
 #endif
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
 #include "rsyslog.h"
 #include "cfsysline.h"
 #include "prop.h"
@@ -94,6 +97,7 @@ DEFobjCurrIf(statsobj)
 
 /* forward references */
 static void * wrkr(void *myself);
+static void * wrkrEPoll(void *myself);
 
 /* unfortunately, on some platforms EAGAIN == EWOULDBOLOCK and so checking against
  * both of them generates a gcc 8 warning for this reason. We do not want to disable
@@ -108,6 +112,9 @@ static void * wrkr(void *myself);
 #define DFLT_wrkrMax 2
 #define DFLT_inlineDispatchThreshold 1
 
+#define IO_ENGINE_EPOLL 0
+#define IO_ENGINE_URING 1
+
 #define COMPRESS_NEVER 0
 #define COMPRESS_SINGLE_MSG 1	/* old, single-message compression */
 /* all other settings are for stream-compression */
@@ -173,6 +180,8 @@ struct modConfData_s {
 	instanceConf_t *root, *tail;
 	int wrkrMax;
 	int bProcessOnPoller;
+	sbool bPerWorkerEpoll;	/* each worker has own epoll set and SO_REUSEPORT listeners */
+	int ioEngine;		/* IO_ENGINE_* */
 	sbool configSetViaV2Method;
 };
 
@@ -182,7 +191,9 @@ static modConfData_t *runModConf = NULL;/* modConf ptr to use for the current lo
 /* module-global parameters */
 static struct cnfparamdescr modpdescr[] = {
 	{ "threads", eCmdHdlrPositiveInt, 0 },
-	{ "processOnPoller", eCmdHdlrBinary, 0 }
+	{ "processOnPoller", eCmdHdlrBinary, 0 },
+	{ "perWorkerEpoll", eCmdHdlrBinary, 0 },
+	{ "io.engine", eCmdHdlrGetWord, 0 }
 };
 static struct cnfparamblk modpblk =
 	{ CNFPARAMBLK_VERSION,
@@ -319,6 +330,7 @@ struct ptcplstn_s {
 	ptcpsrv_t *pSrv;	/* our server */
 	ptcplstn_t *prev, *next;
 	int sock;
+	int epollfd;		/* epoll set of the listener and its sessions */
 	sbool bSuppOctetFram;
 	sbool bSPFramingFix;
 	epolld_t *epd;
@@ -338,6 +350,7 @@ struct ptcplstn_s {
  */
 static struct wrkrInfo_s {
 	pthread_t tid;	/* the worker's thread ID */
+	int epollfd;	/* worker's own epoll set (perWorkerEpoll mode only) */
 	long long unsigned numCalled;	/* how often was this called */
 } *wrkrInfo;
 static int wrkrRunning;
@@ -356,6 +369,7 @@ struct epolld_s {
 	epolld_type_t typ;
 	void *ptr;
 	int sock;
+	int epollfd;	/* epoll set this descriptor belongs to */
 	struct epoll_event ev;
 };
 
@@ -378,12 +392,32 @@ typedef struct io_q_s {
 pthread_attr_t wrkrThrdAttr;	/* Attribute for session threads; read only after startup */
 static ptcpsrv_t *pSrvRoot = NULL;
 static int epollfd = -1;			/* (sole) descriptor for epoll */
+static int *wrkrEpollfds = NULL;	/* per-worker epoll sets in perWorkerEpoll mode */
+static int shutdownPipe[2] = { -1, -1 };	/* wakes per-worker pollers on shutdown */
+
+#ifdef HAVE_LIBURING
+/* io_uring receive engine. If active, the input thread does all socket IO via
+ * multishot accept and multishot recv requests. Received data is placed into
+ * buffers from a provided-buffer ring, so no buffer is tied to idle sessions.
+ */
+#define URING_ENTRIES 1024		/* submission queue size */
+#define URING_BUF_COUNT 1024		/* number of receive buffers, must be power of 2 */
+#define URING_BUF_SIZE (16*1024)	/* size of each receive buffer */
+#define URING_BGID 0			/* our buffer group ID */
+static struct {
+	struct io_uring ring;
+	struct io_uring_buf_ring *bufRing;
+	char *bufs;
+	sbool bActive;		/* is the io_uring engine in use? */
+} uring;
+static rsRetVal uringAddSess(ptcpsess_t *pSess);
+#endif
 static int iMaxLine; /* maximum size of a single message */
 static io_q_t io_q;
 
 /* forward definitions */
 static rsRetVal resetConfigVariables(uchar __attribute__((unused)) *pp, void __attribute__((unused)) *pVal);
-static rsRetVal addLstn(ptcpsrv_t *pSrv, int sock, int isIPv6);
+static rsRetVal addLstn(ptcpsrv_t *pSrv, int sock, int isIPv6, int iWrkr);
 
 
 /* some simple constructors/destructors */
@@ -479,7 +513,7 @@ static rsRetVal startupUXSrv(ptcpsrv_t *pSrv) {
 		}
 	}
 
-	CHKiRet(addLstn(pSrv, sock, 0));
+	CHKiRet(addLstn(pSrv, sock, 0, 0));
 
 finalize_it:
 	if (iRet != RS_RET_OK) {
@@ -491,6 +525,50 @@ finalize_it:
 	RETiRet;
 }
 
+#ifdef SO_REUSEPORT
+/* create an additional listen socket for an address that is already bound by
+ * our first socket. Used in perWorkerEpoll mode, where each worker has its own
+ * listen socket. All of them use SO_REUSEPORT, so that the kernel distributes
+ * new connections across the workers.
+ */
+static rsRetVal
+createReusePortSock(ptcpsrv_t *const pSrv, struct addrinfo *const r, int *const pSock)
+{
+	DEFiRet;
+	int on = 1;
+	int sockflags;
+	int sock;
+
+	sock = socket(r->ai_family, r->ai_socktype, r->ai_protocol);
+	if(sock < 0)
+		ABORT_FINALIZE(RS_RET_COULD_NOT_BIND);
+#ifdef IPV6_V6ONLY
+	if(r->ai_family == AF_INET6
+	   && setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, (char *) &on, sizeof(on)) < 0)
+		ABORT_FINALIZE(RS_RET_COULD_NOT_BIND);
+#endif
+	if(setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (char *) &on, sizeof(on)) < 0
+	   || setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (char *) &on, sizeof(on)) < 0)
+		ABORT_FINALIZE(RS_RET_COULD_NOT_BIND);
+	if((sockflags = fcntl(sock, F_GETFL)) == -1
+	   || fcntl(sock, F_SETFL, sockflags | O_NONBLOCK) == -1)
+		ABORT_FINALIZE(RS_RET_COULD_NOT_BIND);
+	/* r->ai_addr contains the actually bound port, even if a dynamic one was requested */
+	if(bind(sock, r->ai_addr, r->ai_addrlen) < 0 || listen(sock, pSrv->socketBacklog) < 0)
+		ABORT_FINALIZE(RS_RET_COULD_NOT_BIND);
+	*pSock = sock;
+
+finalize_it:
+	if(iRet != RS_RET_OK) {
+		LogError(errno, iRet, "imptcp: could not create per-worker listen socket "
+			"for port %s", pSrv->port);
+		if(sock != -1)
+			close(sock);
+	}
+	RETiRet;
+}
+#endif
+
 /* Start up a server. That means all of its listeners are created.
  * Does NOT yet accept/process any incoming data (but binds ports). Hint: this
  * code is to be executed before dropping privileges.
@@ -509,6 +587,9 @@ startupSrv(ptcpsrv_t *pSrv)
 	uchar *lstnIP;
 	int isIPv6 = 0;
 	int port_override = 0; /* if dyn port (0): use this for actually bound port */
+#ifdef SO_REUSEPORT
+	int iWrkr;
+#endif
 
 	if (pSrv->bUnixSocket) {
 		return startupUXSrv(pSrv);
@@ -574,6 +655,15 @@ startupSrv(ptcpsrv_t *pSrv)
 			sock = -1;
 			continue;
 		}
+#ifdef SO_REUSEPORT
+		if(runModConf->bPerWorkerEpoll
+		   && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (char *) &on, sizeof(on)) < 0 ) {
+			LogError(errno, NO_ERRCODE, "imptcp: error setting SO_REUSEPORT on tcp socket");
+			close(sock);
+			sock = -1;
+			continue;
+		}
+#endif
 
 		/* We use non-blocking IO! */
 		if((sockflags = fcntl(sock, F_GETFL)) != -1) {
@@ -668,8 +758,19 @@ startupSrv(ptcpsrv_t *pSrv)
 		/* if we reach this point, we were able to obtain a valid socket, so we can
 		 * create our listener object. -- rgerhards, 2010-08-10
 		 */
-		CHKiRet(addLstn(pSrv, sock, isIPv6));
+		CHKiRet(addLstn(pSrv, sock, isIPv6, 0));
+		sock = -1; /* now owned by listener */
 		++numSocks;
+
+#ifdef SO_REUSEPORT
+		/* in perWorkerEpoll mode, each worker gets its own listen socket */
+		for(iWrkr = 1 ; runModConf->bPerWorkerEpoll && iWrkr < runModConf->wrkrMax ; ++iWrkr) {
+			if(createReusePortSock(pSrv, r, &sock) == RS_RET_OK) {
+				CHKiRet(addLstn(pSrv, sock, isIPv6, iWrkr));
+				sock = -1;
+			}
+		}
+#endif
 	}
 
 	if(numSocks != maxs) {
@@ -853,7 +954,8 @@ finalize_it:
  * rgerhards, 2008-04-22
  */
 static rsRetVal ATTR_NONNULL()
-AcceptConnReq(ptcplstn_t *const pLstn, int *const newSock, prop_t **peerName, prop_t **peerIP)
+AcceptConnReq(ptcplstn_t *const pLstn, const int acceptedSock, int *const newSock,
+	prop_t **peerName, prop_t **peerIP)
 {
 	int sockflags;
 	struct sockaddr_storage addr;
@@ -863,7 +965,14 @@ AcceptConnReq(ptcplstn_t *const pLstn, int *const newSock, prop_t **peerName, pr
 	DEFiRet;
 
 	*peerName = NULL; /* ensure we know if we don't have one! */
-	iNewSock = accept(pLstn->sock, (struct sockaddr*) &addr, &addrlen);
+	if(acceptedSock != -1) {
+		/* connection was already accepted by the io_uring engine */
+		iNewSock = acceptedSock;
+		if(getpeername(iNewSock, (struct sockaddr*) &addr, &addrlen) != 0)
+			addrlen = 0;
+	} else {
+		iNewSock = accept(pLstn->sock, (struct sockaddr*) &addr, &addrlen);
+	}
 	if(iNewSock < 0) {
 		if(CHK_EAGAIN_EWOULDBLOCK || errno == EMFILE)
 			ABORT_FINALIZE(RS_RET_NO_MORE_DATA);
@@ -937,13 +1046,14 @@ finalize_it:
  * EXTRACT from tcps_sess.c
  */
 static rsRetVal
-doSubmitMsg(ptcpsess_t *pThis, struct syslogTime *stTime, time_t ttGenTime, multi_submit_t *pMultiSub)
+doSubmitFrame(ptcpsess_t *pThis, const char *const frame, const int lenFrame,
+	struct syslogTime *stTime, time_t ttGenTime, multi_submit_t *pMultiSub)
 {
 	smsg_t *pMsg;
 	ptcpsrv_t *pSrv;
 	DEFiRet;
 
-	if(pThis->iMsg == 0) {
+	if(lenFrame == 0) {
 		DBGPRINTF("discarding zero-sized message\n");
 		FINALIZE;
 	}
@@ -951,7 +1061,7 @@ doSubmitMsg(ptcpsess_t *pThis, struct syslogTime *stTime, time_t ttGenTime, mult
 
 	/* we now create our own message object and submit it to the queue */
 	CHKiRet(msgConstructWithTime(&pMsg, stTime, ttGenTime));
-	MsgSetRawMsg(pMsg, (char*)pThis->pMsg, pThis->iMsg);
+	MsgSetRawMsg(pMsg, frame, lenFrame);
 	MsgSetInputName(pMsg, pSrv->pInputName);
 	MsgSetFlowControlType(pMsg, eFLOWCTL_LIGHT_DELAY);
 	if(pSrv->dfltTZ != NULL)
@@ -974,6 +1084,32 @@ finalize_it:
 	RETiRet;
 }
 
+/* submit the message collected in the session buffer */
+static rsRetVal
+doSubmitMsg(ptcpsess_t *pThis, struct syslogTime *stTime, time_t ttGenTime, multi_submit_t *pMultiSub)
+{
+	return doSubmitFrame(pThis, (char*)pThis->pMsg, pThis->iMsg, stTime, ttGenTime, pMultiSub);
+}
+
+
+/* get the length of the frame data up to the next delimiter (exclusive), but
+ * at most maxLen. memchr() is vectorized by all relevant libcs, so this is
+ * much faster than looking at each character individually.
+ */
+static int
+frameRunLen(const ptcpsrv_t *const pSrv, const char *const buf, const int lenBuf, const int maxLen)
+{
+	int len = (lenBuf < maxLen) ? lenBuf : maxLen;
+	const char *p;
+
+	if((p = memchr(buf, '\n', len)) != NULL)
+		len = p - buf;
+	if(pSrv->iAddtlFrameDelim != TCPSRV_NO_ADDTL_DELIMITER
+	   && (p = memchr(buf, pSrv->iAddtlFrameDelim, len)) != NULL)
+		len = p - buf;
+	return len;
+}
+
 
 /* process the data received, special case if the framing is specified via
  * a regex. For more info see processDataRcvd().
@@ -1174,9 +1310,34 @@ processDataRcvd(ptcpsess_t *const __restrict__ pThis,
 				 * framing modes! If we have a message that is larger than the max msg size,
 				 * we truncate it. This is the best we can do in light of what the engine supports.
 				 * -- rgerhards, 2008-03-14
+				 * We do not copy character by character, but everything up to the next
+				 * delimiter in one go. If the complete frame is inside the receive buffer,
+				 * we even submit it directly from there.
 				 */
-				if(pThis->iMsg < iMaxLine) {
-					*(pThis->pMsg + pThis->iMsg++) = c;
+				if(pThis->inputState != eInMsg) {
+					/* just truncated, keep the traditional semantics */
+					if(pThis->iMsg < iMaxLine) {
+						*(pThis->pMsg + pThis->iMsg++) = c;
+					}
+				} else if(pThis->iMsg < iMaxLine) {
+					const int maxRun = iMaxLine - pThis->iMsg;
+					const int lenRun = frameRunLen(pThis->pLstn->pSrv, *buff, buffLen, maxRun);
+					if(pThis->iMsg == 0 && lenRun < buffLen && lenRun < maxRun
+					   && !pThis->pLstn->pSrv->multiLine) {
+						/* (*buff)[lenRun] is the delimiter. We leave *buff on it,
+						 * so the caller's increment skips it - the frame is
+						 * already complete and the delimiter must not be
+						 * processed again.
+						 */
+						doSubmitFrame(pThis, *buff, lenRun, stTime, ttGenTime, pMultiSub);
+						++(*pnMsgs);
+						pThis->inputState = eAtStrtFram;
+						*buff += lenRun;
+					} else {
+						memcpy(pThis->pMsg + pThis->iMsg, *buff, lenRun);
+						pThis->iMsg += lenRun;
+						*buff += lenRun - 1;
+					}
 				}
 			}
 		} else {
@@ -1351,7 +1512,7 @@ initConfigSettings(void)
 /* add socket to the epoll set
  */
 static rsRetVal
-addEPollSock(epolld_type_t typ, void *ptr, int sock, epolld_t **pEpd)
+addEPollSock(epolld_type_t typ, void *ptr, int sock, int efd, epolld_t **pEpd)
 {
 	DEFiRet;
 	epolld_t *epd = NULL;
@@ -1360,16 +1521,17 @@ addEPollSock(epolld_type_t typ, void *ptr, int sock, epolld_t **pEpd)
 	epd->typ = typ;
 	epd->ptr = ptr;
 	epd->sock = sock;
+	epd->epollfd = efd;
 	*pEpd = epd;
 	epd->ev.events = EPOLLIN|EPOLLET|EPOLLONESHOT;
 	epd->ev.data.ptr = (void*) epd;
 
-	if(epoll_ctl(epollfd, EPOLL_CTL_ADD, sock, &(epd->ev)) != 0) {
+	if(epoll_ctl(efd, EPOLL_CTL_ADD, sock, &(epd->ev)) != 0) {
 		LogError(errno, RS_RET_EPOLL_CTL_FAILED, "os error during epoll ADD");
 		ABORT_FINALIZE(RS_RET_EPOLL_CTL_FAILED);
 	}
 
-	DBGPRINTF("imptcp: added socket %d to epoll[%d] set\n", sock, epollfd);
+	DBGPRINTF("imptcp: added socket %d to epoll[%d] set\n", sock, efd);
 
 finalize_it:
 	if(iRet != RS_RET_OK) {
@@ -1383,10 +1545,11 @@ finalize_it:
 }
 
 
-/* add a listener to the server
+/* add a listener to the server. In perWorkerEpoll mode, iWrkr is the worker
+ * which polls the listener and all sessions accepted by it.
  */
 static rsRetVal
-addLstn(ptcpsrv_t *pSrv, int sock, int isIPv6)
+addLstn(ptcpsrv_t *pSrv, int sock, int isIPv6, int iWrkr)
 {
 	DEFiRet;
 	ptcplstn_t *pLstn = NULL;
@@ -1397,6 +1560,7 @@ addLstn(ptcpsrv_t *pSrv, int sock, int isIPv6)
 	pLstn->bSuppOctetFram = pSrv->bSuppOctetFram;
 	pLstn->bSPFramingFix = pSrv->bSPFramingFix;
 	pLstn->sock = sock;
+	pLstn->epollfd = runModConf->bPerWorkerEpoll ? wrkrEpollfds[iWrkr] : epollfd;
 	/* support statistics gathering */
 	uchar *inputname;
 	if(pSrv->pszInputName == NULL) {
@@ -1405,9 +1569,15 @@ addLstn(ptcpsrv_t *pSrv, int sock, int isIPv6)
 		inputname = pSrv->pszInputName;
 	}
 	CHKiRet(statsobj.Construct(&(pLstn->stats)));
-	snprintf((char*)statname, sizeof(statname), "%s(%s/%s/%s)", inputname,
-		(pSrv->lstnIP == NULL) ? "*" : (char*)pSrv->lstnIP, pSrv->port,
-		isIPv6 ? "IPv6" : "IPv4");
+	if(runModConf->bPerWorkerEpoll && !pSrv->bUnixSocket) {
+		snprintf((char*)statname, sizeof(statname), "%s(%s/%s/%s/w%d)", inputname,
+			(pSrv->lstnIP == NULL) ? "*" : (char*)pSrv->lstnIP, pSrv->port,
+			isIPv6 ? "IPv6" : "IPv4", iWrkr);
+	} else {
+		snprintf((char*)statname, sizeof(statname), "%s(%s/%s/%s)", inputname,
+			(pSrv->lstnIP == NULL) ? "*" : (char*)pSrv->lstnIP, pSrv->port,
+			isIPv6 ? "IPv6" : "IPv4");
+	}
 	statname[sizeof(statname)-1] = '\0'; /* just to be on the save side... */
 	CHKiRet(statsobj.SetName(pLstn->stats, statname));
 	CHKiRet(statsobj.SetOrigin(pLstn->stats, (uchar*)"imptcp"));
@@ -1434,7 +1604,7 @@ addLstn(ptcpsrv_t *pSrv, int sock, int isIPv6)
 		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &(pLstn->rcvdDecompressed)));
 	CHKiRet(statsobj.ConstructFinalize(pLstn->stats));
 
-	CHKiRet(addEPollSock(epolld_lstn, pLstn, sock, &pLstn->epd));
+	CHKiRet(addEPollSock(epolld_lstn, pLstn, sock, pLstn->epollfd, &pLstn->epd));
 
 	/* add to start of server's listener list */
 	pLstn->prev = NULL;
@@ -1498,7 +1668,14 @@ addSess(ptcplstn_t *pLstn, int sock, prop_t *peerName, prop_t *peerIP)
 	pSrv->pSess = pSess;
 	pthread_mutex_unlock(&pSrv->mutSessLst);
 
-	CHKiRet(addEPollSock(epolld_sess, pSess, sock, &pSess->epd));
+#ifdef HAVE_LIBURING
+	if(uring.bActive) {
+		CHKiRet(uringAddSess(pSess));
+		FINALIZE;
+	}
+#endif
+	/* the session is polled by the same epoll set (and so worker) as its listener */
+	CHKiRet(addEPollSock(epolld_sess, pSess, sock, pLstn->epollfd, &pSess->epd));
 
 finalize_it:
 	if(iRet != RS_RET_OK) {
@@ -1785,6 +1962,7 @@ finalize_it:
 static void
 startWorkerPool(void)
 {
+	struct epoll_event shutdownEvt;
 	int i;
 	pthread_mutex_lock(&io_q.mut); /* locking to keep Coverity happy */
 	wrkrRunning = 0;
@@ -1795,6 +1973,23 @@ startWorkerPool(void)
 		LogError(errno, RS_RET_OUT_OF_MEMORY, "imptcp: worker-info array allocation failed.");
 		return;
 	}
+	if(runModConf->bPerWorkerEpoll) {
+		/* worker 0 is run on the input thread itself, see runInput */
+		for(i = 0 ; i < runModConf->wrkrMax ; ++i) {
+			wrkrInfo[i].numCalled = 0;
+			wrkrInfo[i].epollfd = wrkrEpollfds[i];
+			shutdownEvt.events = EPOLLIN;
+			shutdownEvt.data.ptr = NULL;
+			if(epoll_ctl(wrkrEpollfds[i], EPOLL_CTL_ADD, shutdownPipe[0], &shutdownEvt) != 0) {
+				LogError(errno, RS_RET_EPOLL_CTL_FAILED, "imptcp: could not add "
+					"shutdown pipe to epoll set of worker %d", i);
+			}
+			if(i > 0)
+				pthread_create(&wrkrInfo[i].tid, &wrkrThrdAttr, wrkrEPoll, &(wrkrInfo[i]));
+		}
+		return;
+	}
+
 	for(i = 0 ; i < runModConf->wrkrMax ; ++i) {
 		/* init worker info structure! */
 		wrkrInfo[i].numCalled = 0;
@@ -1810,6 +2005,25 @@ stopWorkerPool(void)
 {
 	int i;
 	DBGPRINTF("imptcp: stoping worker pool\n");
+	if(wrkrInfo == NULL)
+		return;
+	if(runModConf->bPerWorkerEpoll) {
+		/* the pipe is never read, so it wakes up all pollers for good */
+		if(write(shutdownPipe[1], "", 1) != 1) {
+			LogError(errno, RS_RET_IO_ERROR, "imptcp: could not notify workers "
+				"of shutdown");
+		}
+		for(i = 1 ; i < runModConf->wrkrMax ; ++i) {
+			pthread_join(wrkrInfo[i].tid, NULL);
+		}
+		for(i = 0 ; i < runModConf->wrkrMax ; ++i) {
+			DBGPRINTF("imptcp: info: worker %d was called %llu times\n", i,
+				wrkrInfo[i].numCalled);
+		}
+		free(wrkrInfo);
+		wrkrInfo = NULL;
+		return;
+	}
 	pthread_mutex_lock(&io_q.mut);
 	pthread_cond_broadcast(&io_q.wakeup_worker); /* awake wrkr if not running */
 	pthread_mutex_unlock(&io_q.mut);
@@ -1818,6 +2032,7 @@ stopWorkerPool(void)
 		DBGPRINTF("imptcp: info: worker %d was called %llu times\n", i, wrkrInfo[i].numCalled);
 	}
 	free(wrkrInfo);
+	wrkrInfo = NULL;
 }
 
 
@@ -1869,7 +2084,7 @@ lstnActivity(ptcplstn_t *const pLstn)
 
 	DBGPRINTF("imptcp: new connection on listen socket %d\n", pLstn->sock);
 	while(glbl.GetGlobalInputTermState() == 0) {
-		localRet = AcceptConnReq(pLstn, &newSock, &peerName, &peerIP);
+		localRet = AcceptConnReq(pLstn, -1, &newSock, &peerName, &peerIP);
 		DBGPRINTF("imptcp: AcceptConnReq on listen socket %d returned %d\n", pLstn->sock, localRet);
 		if(localRet == RS_RET_NO_MORE_DATA || glbl.GetGlobalInputTermState() == 1) {
 			break;
@@ -1942,6 +2157,240 @@ finalize_it:
 }
 
 
+#ifdef HAVE_LIBURING
+/* get a submission queue entry. If the queue is full, we submit what we have
+ * so far to make room. So requests are normally submitted in batches, but we
+ * never fail for lack of queue space.
+ */
+static struct io_uring_sqe *
+uringGetSqe(void)
+{
+	struct io_uring_sqe *sqe;
+
+	while((sqe = io_uring_get_sqe(&uring.ring)) == NULL) {
+		io_uring_submit(&uring.ring);
+	}
+	return sqe;
+}
+
+
+static void
+uringArmAccept(epolld_t *const epd)
+{
+	struct io_uring_sqe *const sqe = uringGetSqe();
+	io_uring_prep_multishot_accept(sqe, epd->sock, NULL, NULL, 0);
+	io_uring_sqe_set_data(sqe, epd);
+}
+
+
+static void
+uringArmRecv(epolld_t *const epd)
+{
+	struct io_uring_sqe *const sqe = uringGetSqe();
+	io_uring_prep_recv_multishot(sqe, epd->sock, NULL, 0, 0);
+	sqe->flags |= IOSQE_BUFFER_SELECT;
+	sqe->buf_group = URING_BGID;
+	io_uring_sqe_set_data(sqe, epd);
+}
+
+
+/* called by addSess() when the io_uring engine is active */
+static rsRetVal
+uringAddSess(ptcpsess_t *const pSess)
+{
+	DEFiRet;
+	epolld_t *epd;
+
+	CHKmalloc(epd = calloc(1, sizeof(epolld_t)));
+	epd->typ = epolld_sess;
+	epd->ptr = pSess;
+	epd->sock = pSess->sock;
+	epd->epollfd = -1;
+	pSess->epd = epd;
+	uringArmRecv(epd);
+
+finalize_it:
+	RETiRet;
+}
+
+
+/* process a connection accepted by io_uring. This is the equivalent of
+ * lstnActivity() for the epoll engine.
+ */
+static void
+uringAccept(ptcplstn_t *const pLstn, const int sock)
+{
+	int newSock = -1;
+	prop_t *peerName;
+	prop_t *peerIP;
+
+	if(AcceptConnReq(pLstn, sock, &newSock, &peerName, &peerIP) != RS_RET_OK)
+		return;
+	if(addSess(pLstn, newSock, peerName, peerIP) != RS_RET_OK) {
+		close(newSock);
+		prop.Destruct(&peerName);
+		prop.Destruct(&peerIP);
+	}
+}
+
+
+/* process data received by io_uring into a ring buffer. This is the
+ * equivalent of sessActivity() for the epoll engine.
+ */
+static void
+uringSessRcvd(ptcpsess_t *const pSess, struct io_uring_cqe *const cqe)
+{
+	const unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+	char *const buf = uring.bufs + (size_t) bid * URING_BUF_SIZE;
+
+	DBGPRINTF("imptcp: io_uring data(%d) on socket %d\n", cqe->res, pSess->sock);
+	DataRcvd(pSess, buf, cqe->res);
+	/* hand buffer back to kernel */
+	io_uring_buf_ring_add(uring.bufRing, buf, URING_BUF_SIZE, bid,
+		io_uring_buf_ring_mask(URING_BUF_COUNT), 0);
+	io_uring_buf_ring_advance(uring.bufRing, 1);
+}
+
+
+static void
+uringProcessCqe(struct io_uring_cqe *const cqe)
+{
+	epolld_t *const epd = (epolld_t*) io_uring_cqe_get_data(cqe);
+	const int bMore = (cqe->flags & IORING_CQE_F_MORE) != 0;
+	ptcpsess_t *pSess;
+
+	if(epd->typ == epolld_lstn) {
+		if(cqe->res >= 0) {
+			uringAccept((ptcplstn_t*) epd->ptr, cqe->res);
+		} else if(cqe->res != -EAGAIN && cqe->res != -EINTR) {
+			LogError(-cqe->res, RS_RET_ACCEPT_ERR, "imptcp: error accepting "
+				"connection on listen socket %d", epd->sock);
+		}
+		if(!bMore && glbl.GetGlobalInputTermState() == 0)
+			uringArmAccept(epd);
+		return;
+	}
+
+	pSess = (ptcpsess_t*) epd->ptr;
+	if(cqe->res > 0) {
+		uringSessRcvd(pSess, cqe);
+		if(!bMore)
+			uringArmRecv(epd);
+	} else if(cqe->res == -ENOBUFS) {
+		/* all buffers were in use; they are already recycled, so we just re-arm */
+		uringArmRecv(epd);
+	} else {
+		/* closed by peer (0) or error: the multishot recv is done in any case,
+		 * so nothing refers to the session any longer.
+		 */
+		if(cqe->res == 0 && pSess->pLstn->pSrv->bEmitMsgOnClose) {
+			LogError(0, RS_RET_PEER_CLOSED_CONN, "imptcp session %d closed by "
+				"remote peer %s.", pSess->sock, propGetSzStr(pSess->peerName));
+		} else if(cqe->res < 0) {
+			DBGPRINTF("imptcp: error %d on session socket %d - closed.\n",
+				-cqe->res, pSess->sock);
+		}
+		closeSess(pSess);
+	}
+}
+
+
+/* set up the io_uring engine. If this fails, e.g. because the kernel is too
+ * old or io_uring is disabled, the caller falls back to epoll. We request
+ * IORING_SETUP_DEFER_TASKRUN, which was introduced after multishot accept and
+ * recv, so if the ring can be created all features we need are available.
+ */
+static rsRetVal
+uringInit(void)
+{
+	struct io_uring_params params;
+	ptcpsrv_t *pSrv;
+	ptcplstn_t *pLstn;
+	int r;
+	int i;
+	DEFiRet;
+
+	memset(&params, 0, sizeof(params));
+	params.flags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+	if((r = io_uring_queue_init_params(URING_ENTRIES, &uring.ring, &params)) < 0) {
+		LogMsg(-r, RS_RET_NOT_IMPLEMENTED, LOG_WARNING, "imptcp: io_uring engine not "
+			"supported by kernel, falling back to epoll");
+		ABORT_FINALIZE(RS_RET_NOT_IMPLEMENTED);
+	}
+	if((uring.bufs = malloc((size_t) URING_BUF_COUNT * URING_BUF_SIZE)) == NULL) {
+		io_uring_queue_exit(&uring.ring);
+		ABORT_FINALIZE(RS_RET_OUT_OF_MEMORY);
+	}
+	uring.bufRing = io_uring_setup_buf_ring(&uring.ring, URING_BUF_COUNT, URING_BGID, 0, &r);
+	if(uring.bufRing == NULL) {
+		LogMsg(-r, RS_RET_NOT_IMPLEMENTED, LOG_WARNING, "imptcp: io_uring buffer ring "
+			"not supported by kernel, falling back to epoll");
+		io_uring_queue_exit(&uring.ring);
+		free(uring.bufs);
+		ABORT_FINALIZE(RS_RET_NOT_IMPLEMENTED);
+	}
+	for(i = 0 ; i < URING_BUF_COUNT ; ++i) {
+		io_uring_buf_ring_add(uring.bufRing, uring.bufs + (size_t) i * URING_BUF_SIZE,
+			URING_BUF_SIZE, i, io_uring_buf_ring_mask(URING_BUF_COUNT), i);
+	}
+	io_uring_buf_ring_advance(uring.bufRing, URING_BUF_COUNT);
+	uring.bActive = 1;
+
+	for(pSrv = pSrvRoot ; pSrv != NULL ; pSrv = pSrv->pNext) {
+		for(pLstn = pSrv->pLstn ; pLstn != NULL ; pLstn = pLstn->next) {
+			uringArmAccept(pLstn->epd);
+		}
+	}
+	DBGPRINTF("imptcp: io_uring engine initialized\n");
+
+finalize_it:
+	RETiRet;
+}
+
+
+/* the io_uring engine's main loop, run on the input thread. All requests
+ * armed while processing a batch of completions are submitted together with
+ * the next wait.
+ */
+static void
+uringRun(void)
+{
+	struct io_uring_cqe *cqe;
+	unsigned head;
+	unsigned nCqe;
+	int r;
+
+	while(glbl.GetGlobalInputTermState() == 0) {
+		r = io_uring_submit_and_wait(&uring.ring, 1);
+		if(r < 0 && r != -EINTR && r != -EAGAIN && r != -EBUSY) {
+			LogError(-r, RS_RET_IO_ERROR, "imptcp: io_uring_submit_and_wait() failed");
+			break;
+		}
+		nCqe = 0;
+		io_uring_for_each_cqe(&uring.ring, head, cqe) {
+			if(glbl.GetGlobalInputTermState() == 0)
+				uringProcessCqe(cqe);
+			++nCqe;
+		}
+		io_uring_cq_advance(&uring.ring, nCqe);
+	}
+}
+
+
+/* tear down the ring. This cancels all outstanding requests, so afterwards
+ * no one refers to our session and listener objects any longer.
+ */
+static void
+uringExit(void)
+{
+	io_uring_free_buf_ring(&uring.ring, uring.bufRing, URING_BUF_COUNT, URING_BGID);
+	io_uring_queue_exit(&uring.ring);
+	free(uring.bufs);
+	uring.bActive = 0;
+}
+#endif /* #ifdef HAVE_LIBURING */
+
+
 /* This function is called to process a single request. This may
  * be carried out by the main worker or a helper. It can be run
  * concurrently.
@@ -1965,7 +2414,7 @@ processWorkItem(epolld_t *epd)
 		break;
 	}
 	if (continue_polling == 1) {
-		epoll_ctl(epollfd, EPOLL_CTL_MOD, epd->sock, &(epd->ev));
+		epoll_ctl(epd->epollfd, EPOLL_CTL_MOD, epd->sock, &(epd->ev));
 	}
 }
 
@@ -2119,6 +2568,32 @@ wrkr(void *myself)
 }
 
 
+/* worker in perWorkerEpoll mode: polls its own epoll set and processes all
+ * events itself. As a session is always polled by the worker which accepted
+ * it, there is no handoff between threads.
+ */
+static void *
+wrkrEPoll(void *myself)
+{
+	struct wrkrInfo_s *me = (struct wrkrInfo_s*) myself;
+	struct epoll_event events[128];
+	int nEvents;
+	int iEvt;
+
+	while(glbl.GetGlobalInputTermState() == 0) {
+		nEvents = epoll_wait(me->epollfd, events, sizeof(events)/sizeof(struct epoll_event), -1);
+		DBGPRINTF("imptcp: worker epoll[%d] returned %d events\n", me->epollfd, nEvents);
+		for(iEvt = 0 ; (iEvt < nEvents) && (glbl.GetGlobalInputTermState() == 0) ; ++iEvt) {
+			if(events[iEvt].data.ptr == NULL)
+				continue; /* shutdown notification */
+			++me->numCalled;
+			processWorkItem((epolld_t*)events[iEvt].data.ptr);
+		}
+	}
+	return NULL;
+}
+
+
 BEGINnewInpInst
 	struct cnfparamvals *pvals;
 	instanceConf_t *inst;
@@ -2258,6 +2733,8 @@ CODESTARTbeginCnfLoad
 	/* init our settings */
 	loadModConf->wrkrMax = DFLT_wrkrMax;
 	loadModConf->bProcessOnPoller = 1;
+	loadModConf->bPerWorkerEpoll = 0;
+	loadModConf->ioEngine = IO_ENGINE_EPOLL;
 	loadModConf->configSetViaV2Method = 0;
 	bLegacyCnfModGlobalsPermitted = 1;
 	/* init legacy config vars */
@@ -2267,6 +2744,7 @@ ENDbeginCnfLoad
 
 BEGINsetModCnf
 	struct cnfparamvals *pvals = NULL;
+	char *cstr;
 	int i;
 CODESTARTsetModCnf
 	pvals = nvlstGetParams(lst, &modpblk, NULL);
@@ -2288,12 +2766,43 @@ CODESTARTsetModCnf
 			loadModConf->wrkrMax = (int) pvals[i].val.d.n;
 		} else if(!strcmp(modpblk.descr[i].name, "processOnPoller")) {
 			loadModConf->bProcessOnPoller = (int) pvals[i].val.d.n;
+		} else if(!strcmp(modpblk.descr[i].name, "io.engine")) {
+			cstr = es_str2cstr(pvals[i].val.d.estr, NULL);
+			if(!strcasecmp(cstr, "epoll")) {
+				loadModConf->ioEngine = IO_ENGINE_EPOLL;
+			} else if(!strcasecmp(cstr, "io_uring")) {
+#				ifdef HAVE_LIBURING
+				loadModConf->ioEngine = IO_ENGINE_URING;
+#				else
+				LogError(0, RS_RET_NOT_IMPLEMENTED, "imptcp: io.engine \"io_uring\" "
+					"requested, but rsyslog was built without liburing - using epoll");
+#				endif
+			} else {
+				LogError(0, RS_RET_PARAM_ERROR, "imptcp: invalid io.engine '%s', "
+					"must be \"epoll\" or \"io_uring\" - using epoll", cstr);
+			}
+			free(cstr);
+		} else if(!strcmp(modpblk.descr[i].name, "perWorkerEpoll")) {
+#			ifdef SO_REUSEPORT
+			loadModConf->bPerWorkerEpoll = (int) pvals[i].val.d.n;
+#			else
+			if(pvals[i].val.d.n) {
+				LogError(0, RS_RET_NOT_IMPLEMENTED, "imptcp: perWorkerEpoll requires "
+					"SO_REUSEPORT, which is not available on this platform - ignored");
+			}
+#			endif
 		} else {
 			dbgprintf("imptcp: program error, non-handled "
 			  "param '%s' in beginCnfLoad\n", modpblk.descr[i].name);
 		}
 	}
 
+	if(loadModConf->ioEngine == IO_ENGINE_URING && loadModConf->bPerWorkerEpoll) {
+		LogError(0, RS_RET_PARAM_ERROR, "imptcp: io.engine \"io_uring\" can not be "
+			"combined with perWorkerEpoll - using per-worker epoll");
+		loadModConf->ioEngine = IO_ENGINE_EPOLL;
+	}
+
 	/* remove all of our legacy handlers, as they can not used in addition
 	 * the the new-style config method.
 	 */
@@ -2339,8 +2848,32 @@ CODESTARTcheckCnf
 ENDcheckCnf
 
 
+/* create an epoll set, returns its descriptor or -1 on error */
+static int
+createEPollSet(void)
+{
+	int efd;
+
+#	if defined(EPOLL_CLOEXEC) && defined(HAVE_EPOLL_CREATE1)
+	DBGPRINTF("imptcp uses epoll_create1()\n");
+	efd = epoll_create1(EPOLL_CLOEXEC);
+	if(efd < 0 && errno == ENOSYS)
+#	endif
+	{
+		DBGPRINTF("imptcp uses epoll_create()\n");
+		/* reading the docs, the number of epoll events passed to
+		 * epoll_create() seems not to be used at all in kernels. So
+		 * we just provide "a" number, happens to be 10.
+		 */
+		efd = epoll_create(10);
+	}
+	return efd;
+}
+
+
 BEGINactivateCnfPrePrivDrop
 	instanceConf_t *inst;
+	int i;
 CODESTARTactivateCnfPrePrivDrop
 	iMaxLine = glbl.GetMaxLine(); /* get maximum size we currently support */
 	DBGPRINTF("imptcp: config params iMaxLine %d\n", iMaxLine);
@@ -2354,24 +2887,28 @@ CODESTARTactivateCnfPrePrivDrop
 		ABORT_FINALIZE(RS_RET_NO_RUN);
 	}
 
-#	if defined(EPOLL_CLOEXEC) && defined(HAVE_EPOLL_CREATE1)
-	DBGPRINTF("imptcp uses epoll_create1()\n");
-	epollfd = epoll_create1(EPOLL_CLOEXEC);
-	if(epollfd < 0 && errno == ENOSYS)
-#	endif
-	{
-		DBGPRINTF("imptcp uses epoll_create()\n");
-		/* reading the docs, the number of epoll events passed to
-		 * epoll_create() seems not to be used at all in kernels. So
-		 * we just provide "a" number, happens to be 10.
-		 */
-		epollfd = epoll_create(10);
-	}
-
+	epollfd = createEPollSet();
 	if(epollfd < 0) {
 		LogError(0, RS_RET_EPOLL_CR_FAILED, "error: epoll_create() failed");
 		ABORT_FINALIZE(RS_RET_NO_RUN);
 	}
+	if(runModConf->bPerWorkerEpoll) {
+		CHKmalloc(wrkrEpollfds = malloc(runModConf->wrkrMax * sizeof(int)));
+		for(i = 0 ; i < runModConf->wrkrMax ; ++i) {
+			if((wrkrEpollfds[i] = createEPollSet()) < 0) {
+				LogError(0, RS_RET_EPOLL_CR_FAILED, "error: epoll_create() failed");
+				while(--i >= 0)
+					close(wrkrEpollfds[i]);
+				free(wrkrEpollfds);
+				wrkrEpollfds = NULL;
+				ABORT_FINALIZE(RS_RET_NO_RUN);
+			}
+		}
+		if(pipe(shutdownPipe) != 0) {
+			LogError(errno, RS_RET_NO_RUN, "imptcp: could not create shutdown pipe");
+			ABORT_FINALIZE(RS_RET_NO_RUN);
+		}
+	}
 
 	/* start up servers, but do not yet read input data */
 	CHKiRet(startupServers());
@@ -2416,12 +2953,25 @@ CODESTARTrunInput
 	initIoQ();
 	startWorkerPool();
 	DBGPRINTF("imptcp: now beginning to process input data\n");
+	if(runModConf->bPerWorkerEpoll) {
+		if(wrkrInfo != NULL)
+			wrkrEPoll(&wrkrInfo[0]);
+		FINALIZE;
+	}
+#ifdef HAVE_LIBURING
+	if(runModConf->ioEngine == IO_ENGINE_URING && uringInit() == RS_RET_OK) {
+		uringRun();
+		uringExit();
+		FINALIZE;
+	}
+#endif
 	while(glbl.GetGlobalInputTermState() == 0) {
 		DBGPRINTF("imptcp going on epoll_wait\n");
 		nEvents = epoll_wait(epollfd, events, sizeof(events)/sizeof(struct epoll_event), -1);
 		DBGPRINTF("imptcp: epoll returned %d events\n", nEvents);
 		processWorkSet(nEvents, events);
 	}
+finalize_it:
 	DBGPRINTF("imptcp: successfully terminated\n");
 	/* we stop the worker pool in AfterRun, in case we get cancelled for some reason (old Interface) */
 ENDrunInput
@@ -2475,6 +3025,7 @@ shutdownSrv(ptcpsrv_t *pSrv)
 
 BEGINafterRun
 	ptcpsrv_t *pSrv, *srvDel;
+	int i;
 CODESTARTafterRun
 	stopWorkerPool();
 	destroyIoQ();
@@ -2489,6 +3040,15 @@ CODESTARTafterRun
 	}
 
 	close(epollfd);
+	if(wrkrEpollfds != NULL) {
+		for(i = 0 ; i < runModConf->wrkrMax ; ++i)
+			close(wrkrEpollfds[i]);
+		free(wrkrEpollfds);
+		wrkrEpollfds = NULL;
+		close(shutdownPipe[0]);
+		close(shutdownPipe[1]);
+		shutdownPipe[0] = shutdownPipe[1] = -1;
+	}
 ENDafterRun
 
 
@@ -41,6 +41,16 @@
 #ifdef HAVE_SCHED_H
 #	include <sched.h>
 #endif
+#if defined(__linux__) && defined(SO_ATTACH_REUSEPORT_CBPF)
+#	include <linux/filter.h>
+#	define HAVE_REUSEPORT_CBPF 1
+#endif
+#ifdef __linux__
+#	include <netinet/udp.h>
+#endif
+#if defined(HAVE_RECVMMSG) && defined(UDP_GRO)
+#	define HAVE_UDP_GRO 1
+#endif
 #include "rsyslog.h"
 #include "dirty.h"
 #include "net.h"
@@ -78,6 +88,8 @@ DEFobjCurrIf(statsobj)
 static struct lstn_s {
 	struct lstn_s *next;
 	int sock;		/* socket */
+	int *wrkrSocks;		/* per-worker sockets in reuseport mode, else NULL */
+	uint32_t *wrkrDrops;	/* last SO_RXQ_OVFL value seen per worker socket */
 	ruleset_t *pRuleset;	/* bound ruleset */
 	prop_t *pInputName;
 	statsobj_t *stats;	/* listener stats */
@@ -91,6 +103,8 @@ static struct lstn_s {
 static int bLegacyCnfModGlobalsPermitted;/* are legacy module-global config parameters permitted? */
 static int bDoACLCheck;			/* are ACL checks neeed? Cached once immediately before listener startup */
 static int iMaxLine;			/* maximum UDP message size supported */
+static int iRcvSlotSize;		/* size of a single receive buffer slot (larger with GRO) */
+#define GRO_RCV_SLOT_SIZE 65536		/* max size of a GRO-coalesced receive (max UDP payload) */
 #define BATCH_SIZE_DFLT 32		/* do not overdo, has heavy toll on memory, especially with large msgs */
 #define TIME_REQUERY_DFLT 2
 #define SCHED_PRIO_UNSET -12345678	/* a value that indicates that the scheduling priority has not been set */
@@ -134,7 +148,12 @@ static struct wrkrInfo_s {
 	STATSCOUNTER_DEF(ctrCall_recvmmsg, mutCtrCall_recvmmsg)
 	STATSCOUNTER_DEF(ctrCall_recvmsg, mutCtrCall_recvmsg)
 	STATSCOUNTER_DEF(ctrMsgsRcvd, mutCtrMsgsRcvd)
+	STATSCOUNTER_DEF(ctrRcvDrops, mutCtrRcvDrops)
 	uchar *pRcvBuf;		/* receive buffer (for a single packet) */
+	uchar *pCtlBuf;		/* ancillary data buffer (reuseport and GRO mode only) */
+	struct sockaddr_storage frominetProps;	/* sender the cached props below belong to */
+	prop_t *propFromHost;	/* cached fromhost of last sender, NULL if none */
+	prop_t *propFromHostIP;	/* cached fromhost-ip of last sender */
 #	ifdef HAVE_RECVMMSG
 	struct sockaddr_storage *frominet;
 	struct mmsghdr *recvmsg_mmh;
@@ -142,6 +161,11 @@ static struct wrkrInfo_s {
 #	endif
 } wrkrInfo[MAX_WRKR_THREADS];
 
+/* size of ancillary data we need per packet - SO_RXQ_OVFL counter and GRO segment size */
+#define CTLBUF_SIZE_PER_PKT 64
+#define REUSEPORT_STEER_KERNEL 0
+#define REUSEPORT_STEER_SOURCE 1
+
 struct modConfData_s {
 	rsconf_t *pConf;		/* our overall config object */
 	instanceConf_t *root, *tail;
@@ -151,6 +175,9 @@ struct modConfData_s {
 	int iTimeRequery;		/* how often is time to be queried inside tight recv loop? 0=always */
 	int batchSize;			/* max nbr of input batch --> also recvmmsg() max count */
 	int8_t wrkrMax;			/* max nbr of worker threads */
+	sbool bReusePort;		/* one SO_REUSEPORT socket per worker and listener? */
+	int reusePortSteering;		/* REUSEPORT_STEER_* */
+	sbool bGRO;			/* receive GRO-coalesced datagrams (UDP_GRO)? */
 	sbool configSetViaV2Method;
 	sbool bPreserveCase;	/* preserves the case of fromhost; "off" by default */
 };
@@ -164,7 +191,10 @@ static struct cnfparamdescr modpdescr[] = {
 	{ "batchsize", eCmdHdlrInt, 0 },
 	{ "threads", eCmdHdlrPositiveInt, 0 },
 	{ "timerequery", eCmdHdlrInt, 0 },
-	{ "preservecase", eCmdHdlrBinary, 0 }
+	{ "preservecase", eCmdHdlrBinary, 0 },
+	{ "reuseport", eCmdHdlrBinary, 0 },
+	{ "reuseport.steering", eCmdHdlrGetWord, 0 },
+	{ "gro", eCmdHdlrBinary, 0 }
 };
 static struct cnfparamblk modpblk =
 	{ CNFPARAMBLK_VERSION,
@@ -269,6 +299,118 @@ finalize_it:
 }
 
 
+/* in reuseport mode, open the additional sockets for workers 1..n-1 (worker 0
+ * uses the initial set). They are returned as array of socket arrays, in the
+ * format provided by create_udp_socket(). If we can not get the exact same set
+ * of sockets for each worker, NULL is returned and the workers share the
+ * initial set, just like without reuseport.
+ */
+static int **
+createWrkrSocks(instanceConf_t *const inst, uchar *const bindAddr, uchar *const port, int *const newSocks)
+{
+	int **wrkrSocks;
+	int w;
+
+	if((wrkrSocks = calloc(runModConf->wrkrMax, sizeof(int*))) == NULL)
+		return NULL;
+	wrkrSocks[0] = newSocks;
+	for(w = 1 ; w < runModConf->wrkrMax ; ++w) {
+		wrkrSocks[w] = net.create_udp_socket(bindAddr, port, 1, inst->rcvbuf, 0, inst->ipfreebind,
+			inst->pszBindDevice, 1);
+		if(wrkrSocks[w] == NULL || wrkrSocks[w][0] != newSocks[0]) {
+			LogError(0, RS_RET_ERR, "imudp: could not create reuseport sockets for all "
+				"workers on port %s - workers share their sockets instead", port);
+			for( ; w > 0 ; --w) {
+				if(wrkrSocks[w] != NULL)
+					net.closeUDPListenSockets(wrkrSocks[w]);
+			}
+			free(wrkrSocks);
+			return NULL;
+		}
+	}
+	return wrkrSocks;
+}
+
+
+#ifdef HAVE_REUSEPORT_CBPF
+/* attach a classic BPF program to the reuseport group of the socket which
+ * selects the worker socket based on the sender's address. So a sender
+ * always lands on the same worker, even if it changes source ports.
+ */
+static void
+attachSourceSteering(const int sock)
+{
+	struct sockaddr_storage addr;
+	socklen_t len = sizeof(addr);
+	uint32_t offs;
+
+	if(getsockname(sock, (struct sockaddr*) &addr, &len) != 0) {
+		LogError(errno, RS_RET_ERR, "imudp: getsockname() failed, can not set up "
+			"reuseport steering for socket %d", sock);
+		return;
+	}
+	/* use the last 32 bits of the source address, relative to the IP header */
+	offs = (addr.ss_family == AF_INET6) ? 20 : 12;
+	struct sock_filter code[] = {
+		{ BPF_LD  | BPF_W | BPF_ABS, 0, 0, (uint32_t) SKF_NET_OFF + offs },
+		{ BPF_ALU | BPF_MOD | BPF_K, 0, 0, (uint32_t) runModConf->wrkrMax },
+		{ BPF_RET | BPF_A, 0, 0, 0 }
+	};
+	struct sock_fprog prog = { .len = sizeof(code) / sizeof(code[0]), .filter = code };
+	if(setsockopt(sock, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog)) != 0) {
+		LogError(errno, RS_RET_ERR, "imudp: could not attach reuseport steering "
+			"program to socket %d, using kernel default distribution", sock);
+	}
+}
+#endif
+
+
+/* set up the per-worker sockets of a listener in reuseport mode */
+static void
+setupReusePortLstn(struct lstn_s *const lstn)
+{
+#	ifdef SO_RXQ_OVFL
+	const int on = 1;
+	int w;
+
+	/* request the socket drop counter, so that we can report per-worker drops */
+	for(w = 0 ; w < runModConf->wrkrMax ; ++w) {
+		if(setsockopt(lstn->wrkrSocks[w], SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) != 0) {
+			DBGPRINTF("imudp: could not set SO_RXQ_OVFL on socket %d, errno %d\n",
+				lstn->wrkrSocks[w], errno);
+		}
+	}
+#	endif
+#	ifdef HAVE_REUSEPORT_CBPF
+	if(runModConf->reusePortSteering == REUSEPORT_STEER_SOURCE)
+		attachSourceSteering(lstn->wrkrSocks[0]);
+#	endif
+}
+
+
+#ifdef HAVE_UDP_GRO
+/* enable UDP_GRO on all sockets of a listener. If that fails (older kernel),
+ * the socket still works, we just receive datagrams one by one.
+ */
+static void
+setupGRO(struct lstn_s *const lstn)
+{
+	const int on = 1;
+	const int nSocks = (lstn->wrkrSocks == NULL) ? 1 : runModConf->wrkrMax;
+	int sock;
+	int i;
+
+	for(i = 0 ; i < nSocks ; ++i) {
+		sock = (lstn->wrkrSocks == NULL) ? lstn->sock : lstn->wrkrSocks[i];
+		if(setsockopt(sock, SOL_UDP, UDP_GRO, &on, sizeof(on)) != 0) {
+			LogError(errno, RS_RET_ERR, "imudp: could not enable UDP_GRO on "
+				"socket %d, receiving datagrams one by one", sock);
+		}
+	}
+}
+#endif
+
+
 /* This function is called when a new listener shall be added. It takes
  * the instance config description, tries to bind the socket and, if that
  * succeeds, adds it to the list of existing listen sockets.
@@ -279,7 +421,9 @@ addListner(instanceConf_t *inst)
 	DEFiRet;
 	uchar *bindAddr;
 	int *newSocks;
+	int **wrkrSocks = NULL;
 	int iSrc;
+	int w;
 	struct lstn_s *newlcnfinfo;
 	uchar *bindName;
 	uchar *port;
@@ -300,7 +444,11 @@ addListner(instanceConf_t *inst)
 
 	DBGPRINTF("Trying to open syslog UDP ports at %s:%s.\n", bindName, inst->pszBindPort);
 
-	newSocks = net.create_udp_socket(bindAddr, port, 1, inst->rcvbuf, 0, inst->ipfreebind, inst->pszBindDevice);
+	newSocks = net.create_udp_socket(bindAddr, port, 1, inst->rcvbuf, 0, inst->ipfreebind,
+		inst->pszBindDevice, runModConf->bReusePort);
+	if(newSocks != NULL && runModConf->bReusePort) {
+		wrkrSocks = createWrkrSocks(inst, bindAddr, port, newSocks);
+	}
 	if(newSocks != NULL) {
 		/* we now need to add the new sockets to the existing set */
 		/* ready to copy */
@@ -308,6 +456,17 @@ addListner(instanceConf_t *inst)
 			CHKmalloc(newlcnfinfo = (struct lstn_s*) calloc(1, sizeof(struct lstn_s)));
 			newlcnfinfo->next = NULL;
 			newlcnfinfo->sock = newSocks[iSrc];
+			if(wrkrSocks != NULL) {
+				CHKmalloc(newlcnfinfo->wrkrSocks = malloc(runModConf->wrkrMax * sizeof(int)));
+				CHKmalloc(newlcnfinfo->wrkrDrops = calloc(runModConf->wrkrMax, sizeof(uint32_t)));
+				for(w = 0 ; w < runModConf->wrkrMax ; ++w)
+					newlcnfinfo->wrkrSocks[w] = wrkrSocks[w][iSrc];
+				setupReusePortLstn(newlcnfinfo);
+			}
+#			ifdef HAVE_UDP_GRO
+			if(runModConf->bGRO)
+				setupGRO(newlcnfinfo);
+#			endif
 			newlcnfinfo->pRuleset = inst->pBindRuleset;
 			newlcnfinfo->dfltTZ = inst->dfltTZ;
 			if(inst->inputname == NULL) {
@@ -369,15 +528,24 @@ finalize_it:
 				prop.Destruct(&newlcnfinfo->pInputName);
 			if(newlcnfinfo->stats != NULL)
 				statsobj.Destruct(&newlcnfinfo->stats);
+			free(newlcnfinfo->wrkrSocks);
+			free(newlcnfinfo->wrkrDrops);
 			free(newlcnfinfo);
 		}
 		/* close the rest of the open sockets as there's
 		   nowhere to put them */
 		for(; iSrc <= newSocks[0]; iSrc++) {
 			close(newSocks[iSrc]);
+			for(w = 1 ; wrkrSocks != NULL && w < runModConf->wrkrMax ; ++w)
+				close(wrkrSocks[w][iSrc]);
 		}
 	}
 
+	if(wrkrSocks != NULL) {
+		for(w = 1 ; w < runModConf->wrkrMax ; ++w)
+			free(wrkrSocks[w]);
+		free(wrkrSocks);
+	}
 	free(newSocks);
 	RETiRet;
 }
@@ -393,11 +561,55 @@ std_checkRuleset_genErrMsg(__attribute__((unused)) modConfData_t *modConf, insta
 }
 
 
+/* drop the sender props cached by the worker */
+static void
+freeSenderProps(struct wrkrInfo_s *const pWrkr)
+{
+	if(pWrkr->propFromHost != NULL) {
+		prop.Destruct(&pWrkr->propFromHost);
+		prop.Destruct(&pWrkr->propFromHostIP);
+	}
+}
+
+
+/* obtain fromhost and fromhost-ip props for a sender. Within a receive burst,
+ * most messages usually come from the same sender, so we keep the props of
+ * the last one and just add a reference for each message. This is only done
+ * when DNS resolution is disabled: otherwise the lookup may block and is
+ * deferred to the main queue worker, as always.
+ */
+static rsRetVal
+getSenderProps(struct wrkrInfo_s *const pWrkr, struct sockaddr_storage *const frominet)
+{
+	DEFiRet;
+
+	if(pWrkr->propFromHost != NULL
+	   && net.CmpHost(frominet, &pWrkr->frominetProps, sizeof(struct sockaddr_storage)) == 0)
+		FINALIZE;
+
+	freeSenderProps(pWrkr);
+	if(runModConf->bPreserveCase) {
+		iRet = net.cvthname(frominet, NULL, &pWrkr->propFromHost, &pWrkr->propFromHostIP);
+	} else {
+		iRet = net.cvthname(frominet, &pWrkr->propFromHost, NULL, &pWrkr->propFromHostIP);
+	}
+	if(iRet != RS_RET_OK) {
+		freeSenderProps(pWrkr); /* cvthname() provides error props; do not cache them */
+		FINALIZE;
+	}
+	memcpy(&pWrkr->frominetProps, frominet, sizeof(struct sockaddr_storage));
+
+finalize_it:
+	RETiRet;
+}
+
+
 /* This function processes received data. It provides unified handling
  * in cases where recvmmsg() is available and not.
  */
 static rsRetVal
-processPacket(struct lstn_s *lstn, struct sockaddr_storage *frominetPrev, int *pbIsPermitted,
+processPacket(struct wrkrInfo_s *const pWrkr, struct lstn_s *lstn, struct sockaddr_storage *frominetPrev,
+	int *pbIsPermitted,
 	uchar *rcvBuf, ssize_t lenRcvBuf, struct syslogTime *stTime, time_t ttGenTime,
 	struct sockaddr_storage *frominet, socklen_t socklen, multi_submit_t *multiSub)
 {
@@ -448,14 +660,21 @@ processPacket(struct lstn_s *lstn, struct sockaddr_storage *frominetPrev, int *p
 		MsgSetFlowControlType(pMsg, eFLOWCTL_NO_DELAY);
 		if(lstn->dfltTZ != NULL)
 			MsgSetDfltTZ(pMsg, (char*) lstn->dfltTZ);
-		pMsg->msgFlags  = NEEDS_PARSING | PARSE_HOSTNAME | NEEDS_DNSRESOL;
-		if(*pbIsPermitted == 2) {
-			pMsg->msgFlags |= NEEDS_ACLCHK_U; /* request ACL check after resolution */
-		}
-		if(runModConf->bPreserveCase) {
-			pMsg->msgFlags |= PRESERVE_CASE; /* preserve case of fromhost */
+		if(*pbIsPermitted == 1 && glbl.GetDisableDNS()
+		   && getSenderProps(pWrkr, frominet) == RS_RET_OK) {
+			pMsg->msgFlags  = NEEDS_PARSING | PARSE_HOSTNAME;
+			MsgSetRcvFrom(pMsg, pWrkr->propFromHost);
+			CHKiRet(MsgSetRcvFromIP(pMsg, pWrkr->propFromHostIP));
+		} else {
+			pMsg->msgFlags  = NEEDS_PARSING | PARSE_HOSTNAME | NEEDS_DNSRESOL;
+			if(*pbIsPermitted == 2) {
+				pMsg->msgFlags |= NEEDS_ACLCHK_U; /* request ACL check after resolution */
+			}
+			if(runModConf->bPreserveCase) {
+				pMsg->msgFlags |= PRESERVE_CASE; /* preserve case of fromhost */
+			}
+			CHKiRet(msgSetFromSockinfo(pMsg, frominet));
 		}
-		CHKiRet(msgSetFromSockinfo(pMsg, frominet));
 		CHKiRet(ratelimitAddMsg(lstn->ratelimiter, multiSub, pMsg));
 		STATSCOUNTER_INC(lstn->ctrSubmit, lstn->mutCtrSubmit);
 	}
@@ -473,6 +692,57 @@ finalize_it:
 
 
 
+/* get the socket a worker must use for a listener */
+static inline int
+lstnSock(const struct lstn_s *const lstn, const struct wrkrInfo_s *const pWrkr)
+{
+	return (lstn->wrkrSocks == NULL) ? lstn->sock : lstn->wrkrSocks[pWrkr->id];
+}
+
+
+#ifdef SO_RXQ_OVFL
+/* update the worker's drop counter from the SO_RXQ_OVFL ancillary data. The
+ * kernel reports the socket's total drop count, so we need to compute the
+ * delta to what we saw last.
+ */
+static void
+updateRcvDrops(struct wrkrInfo_s *const pWrkr, struct lstn_s *const lstn, struct msghdr *const mh)
+{
+	struct cmsghdr *cmsg;
+	uint32_t drops;
+
+	for(cmsg = CMSG_FIRSTHDR(mh) ; cmsg != NULL ; cmsg = CMSG_NXTHDR(mh, cmsg)) {
+		if(cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+			memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+			pWrkr->ctrRcvDrops += (uint32_t) (drops - lstn->wrkrDrops[pWrkr->id]);
+			lstn->wrkrDrops[pWrkr->id] = drops;
+		}
+	}
+}
+#endif
+
+
+#ifdef HAVE_UDP_GRO
+/* obtain the GRO segment size of a receive. Returns 0 if the receive holds
+ * only a single datagram.
+ */
+static int
+getGROSegSize(struct msghdr *const mh)
+{
+	struct cmsghdr *cmsg;
+	int segSize = 0;
+
+	for(cmsg = CMSG_FIRSTHDR(mh) ; cmsg != NULL ; cmsg = CMSG_NXTHDR(mh, cmsg)) {
+		if(cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+			memcpy(&segSize, CMSG_DATA(cmsg), sizeof(segSize));
+			break;
+		}
+	}
+	return segSize;
+}
+#endif
+
+
 /* The following "two" functions are helpers to runInput. Actually, it is
  * just one function. Depending on whether or not we have recvmmsg(),
  * an appropriate version is compiled (as such we need to maintain both!).
@@ -491,6 +761,12 @@ int *pbIsPermitted)
 	char errStr[1024];
 	smsg_t *pMsgs[CONF_NUM_MULTISUB];
 	multi_submit_t multiSub;
+	const int sock = lstnSock(lstn, pWrkr);
+	uchar *rcvBuf;
+	int lenRcv;
+	int segSize;
+	int lenSeg;
+	int offs;
 	int nelem;
 	int i;
 
@@ -504,20 +780,24 @@ int *pbIsPermitted)
 		memset(pWrkr->recvmsg_iov, 0, runModConf->batchSize * sizeof(struct iovec));
 		memset(pWrkr->recvmsg_mmh, 0, runModConf->batchSize * sizeof(struct mmsghdr));
 		for(i = 0 ; i < runModConf->batchSize ; ++i) {
-			pWrkr->recvmsg_iov[i].iov_base = pWrkr->pRcvBuf+(i*(iMaxLine+1));
-			pWrkr->recvmsg_iov[i].iov_len = iMaxLine;
+			pWrkr->recvmsg_iov[i].iov_base = pWrkr->pRcvBuf+(i*iRcvSlotSize);
+			pWrkr->recvmsg_iov[i].iov_len = iRcvSlotSize - 1;
 			pWrkr->recvmsg_mmh[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
 			pWrkr->recvmsg_mmh[i].msg_hdr.msg_name = &(pWrkr->frominet[i]);
 			pWrkr->recvmsg_mmh[i].msg_hdr.msg_iov = &(pWrkr->recvmsg_iov[i]);
 			pWrkr->recvmsg_mmh[i].msg_hdr.msg_iovlen = 1;
+			if(pWrkr->pCtlBuf != NULL) {
+				pWrkr->recvmsg_mmh[i].msg_hdr.msg_control = pWrkr->pCtlBuf + i * CTLBUF_SIZE_PER_PKT;
+				pWrkr->recvmsg_mmh[i].msg_hdr.msg_controllen = CTLBUF_SIZE_PER_PKT;
+			}
 		}
-		nelem = recvmmsg(lstn->sock, pWrkr->recvmsg_mmh, runModConf->batchSize, 0, NULL);
+		nelem = recvmmsg(sock, pWrkr->recvmsg_mmh, runModConf->batchSize, 0, NULL);
 		STATSCOUNTER_INC(pWrkr->ctrCall_recvmmsg, pWrkr->mutCtrCall_recvmmsg);
 		DBGPRINTF("imudp: recvmmsg returned %d\n", nelem);
 		if(nelem < 0 && errno == ENOSYS) {
 			/* be careful: some versions of valgrind do not support recvmmsg()! */
 			DBGPRINTF("imudp: error ENOSYS on call to recvmmsg() - fall back to recvmsg\n");
-			nelem = recvmsg(lstn->sock, &(pWrkr->recvmsg_mmh[0].msg_hdr), 0);
+			nelem = recvmsg(sock, &(pWrkr->recvmsg_mmh[0].msg_hdr), 0);
 			STATSCOUNTER_INC(pWrkr->ctrCall_recvmsg, pWrkr->mutCtrCall_recvmsg);
 			if(nelem >= 0) {
 				pWrkr->recvmsg_mmh[0].msg_len = nelem;
@@ -539,16 +819,46 @@ int *pbIsPermitted)
 		}
 
 		pWrkr->ctrMsgsRcvd += nelem;
+#		ifdef SO_RXQ_OVFL
+		if(lstn->wrkrDrops != NULL && nelem > 0)
+			updateRcvDrops(pWrkr, lstn, &(pWrkr->recvmsg_mmh[nelem-1].msg_hdr));
+#		endif
 		for(i = 0 ; i < nelem ; ++i) {
-			processPacket(lstn, frominetPrev, pbIsPermitted,
-				pWrkr->recvmsg_mmh[i].msg_hdr.msg_iov->iov_base,
-				pWrkr->recvmsg_mmh[i].msg_len, &stTime, ttGenTime, &(pWrkr->frominet[i]),
-				pWrkr->recvmsg_mmh[i].msg_hdr.msg_namelen, &multiSub);
+			rcvBuf = pWrkr->recvmsg_mmh[i].msg_hdr.msg_iov->iov_base;
+			lenRcv = pWrkr->recvmsg_mmh[i].msg_len;
+			segSize = 0;
+#			ifdef HAVE_UDP_GRO
+			if(runModConf->bGRO)
+				segSize = getGROSegSize(&(pWrkr->recvmsg_mmh[i].msg_hdr));
+#			endif
+			if(segSize <= 0 || segSize >= lenRcv) {
+				if(lenRcv > iMaxLine)
+					lenRcv = iMaxLine; /* GRO slots are larger than iMaxLine */
+				processPacket(pWrkr, lstn, frominetPrev, pbIsPermitted, rcvBuf, lenRcv,
+					&stTime, ttGenTime, &(pWrkr->frominet[i]),
+					pWrkr->recvmsg_mmh[i].msg_hdr.msg_namelen, &multiSub);
+				continue;
+			}
+			/* GRO-coalesced receive: all segments have segSize, except the last one,
+			 * which may be shorter. Each segment is one datagram of the sender.
+			 */
+			for(offs = 0 ; offs < lenRcv ; offs += segSize) {
+				if(offs > 0)
+					++pWrkr->ctrMsgsRcvd;
+				lenSeg = (lenRcv - offs < segSize) ? lenRcv - offs : segSize;
+				if(lenSeg > iMaxLine)
+					lenSeg = iMaxLine;
+				processPacket(pWrkr, lstn, frominetPrev, pbIsPermitted, rcvBuf + offs,
+					lenSeg, &stTime, ttGenTime,
+					&(pWrkr->frominet[i]), pWrkr->recvmsg_mmh[i].msg_hdr.msg_namelen,
+					&multiSub);
+			}
 		}
 	}
 
 finalize_it:
 	multiSubmitFlush(&multiSub);
+	freeSenderProps(pWrkr);
 	RETiRet;
 }
 #else /* we do not have recvmmsg() */
@@ -580,6 +890,7 @@ int *pbIsPermitted)
 	char errStr[1024];
 	struct msghdr mh;
 	struct iovec iov[1];
+	const int sock = lstnSock(lstn, pWrkr);
 	DEFiRet;
 
 	multiSub.ppMsgs = pMsgs;
@@ -597,7 +908,11 @@ int *pbIsPermitted)
 		mh.msg_namelen = sizeof(struct sockaddr_storage);
 		mh.msg_iov = iov;
 		mh.msg_iovlen = 1;
-		lenRcvBuf = recvmsg(lstn->sock, &mh, 0);
+		if(lstn->wrkrDrops != NULL) {
+			mh.msg_control = pWrkr->pCtlBuf;
+			mh.msg_controllen = CTLBUF_SIZE_PER_PKT;
+		}
+		lenRcvBuf = recvmsg(sock, &mh, 0);
 		STATSCOUNTER_INC(pWrkr->ctrCall_recvmsg, pWrkr->mutCtrCall_recvmsg);
 		if(lenRcvBuf < 0) {
 			if(errno != EINTR && errno != EAGAIN) {
@@ -610,17 +925,22 @@ int *pbIsPermitted)
 		}
 
 		++pWrkr->ctrMsgsRcvd;
+#		ifdef SO_RXQ_OVFL
+		if(lstn->wrkrDrops != NULL)
+			updateRcvDrops(pWrkr, lstn, &mh);
+#		endif
 		if((runModConf->iTimeRequery == 0) || (iNbrTimeUsed++ % runModConf->iTimeRequery) == 0) {
 			datetime.getCurrTime(&stTime, &ttGenTime, TIME_IN_LOCALTIME);
 		}
 
-		CHKiRet(processPacket(lstn, frominetPrev, pbIsPermitted, pWrkr->pRcvBuf, lenRcvBuf, &stTime,
-			ttGenTime, &frominet, mh.msg_namelen, &multiSub));
+		CHKiRet(processPacket(pWrkr, lstn, frominetPrev, pbIsPermitted, pWrkr->pRcvBuf, lenRcvBuf,
+			&stTime, ttGenTime, &frominet, mh.msg_namelen, &multiSub));
 	}
 
 
 finalize_it:
 	multiSubmitFlush(&multiSub);
+	freeSenderProps(pWrkr);
 	RETiRet;
 }
 #endif /* #ifdef HAVE_RECVMMSG */
@@ -810,10 +1130,10 @@ rcvMainLoop(struct wrkrInfo_s *const __restrict__ pWrkr)
 		if(lstn->sock != -1) {
 			udpEPollEvt[i].events = EPOLLIN | EPOLLET;
 			udpEPollEvt[i].data.ptr = lstn;
-			if(epoll_ctl(efd, EPOLL_CTL_ADD,  lstn->sock, &(udpEPollEvt[i])) < 0) {
+			if(epoll_ctl(efd, EPOLL_CTL_ADD,  lstnSock(lstn, pWrkr), &(udpEPollEvt[i])) < 0) {
 				rs_strerror_r(errno, errStr, sizeof(errStr));
 				LogError(errno, NO_ERRCODE, "epoll_ctrl failed on fd %d with %s\n",
-					lstn->sock, errStr);
+					lstnSock(lstn, pWrkr), errStr);
 			}
 		}
 		i++;
@@ -874,7 +1194,7 @@ rcvMainLoop(struct wrkrInfo_s *const __restrict__ pWrkr)
 	for(lstn = lcnfRoot ; lstn != NULL ; lstn = lstn->next) {
 		assert(i < nfd);
 		if (lstn->sock != -1) {
-			pollfds[i].fd = lstn->sock;
+			pollfds[i].fd = lstnSock(lstn, pWrkr);
 			pollfds[i].events = POLLIN;
 			++i;
 		}
@@ -1039,6 +1359,9 @@ CODESTARTbeginCnfLoad
 	loadModConf->iSchedPrio = SCHED_PRIO_UNSET;
 	loadModConf->pszSchedPolicy = NULL;
 	loadModConf->bPreserveCase = 0; /* off */
+	loadModConf->bReusePort = 0;
+	loadModConf->reusePortSteering = REUSEPORT_STEER_KERNEL;
+	loadModConf->bGRO = 0;
 	bLegacyCnfModGlobalsPermitted = 1;
 	/* init legacy config vars */
 	cs.pszBindRuleset = NULL;
@@ -1054,6 +1377,7 @@ BEGINsetModCnf
 	struct cnfparamvals *pvals = NULL;
 	int i;
 	int wrkrMax;
+	char *cstr;
 CODESTARTsetModCnf
 	pvals = nvlstGetParams(lst, &modpblk, NULL);
 	if(pvals == NULL) {
@@ -1090,6 +1414,42 @@ CODESTARTsetModCnf
 			}
 		} else if(!strcmp(modpblk.descr[i].name, "preservecase")) {
 			loadModConf->bPreserveCase = (int) pvals[i].val.d.n;
+		} else if(!strcmp(modpblk.descr[i].name, "reuseport")) {
+#			if defined(SO_REUSEPORT)
+			loadModConf->bReusePort = (int) pvals[i].val.d.n;
+#			else
+			if(pvals[i].val.d.n) {
+				LogError(0, RS_RET_NOT_IMPLEMENTED, "imudp: parameter \"reuseport\" is "
+					"not supported on this platform (no SO_REUSEPORT) - ignored");
+			}
+#			endif
+		} else if(!strcmp(modpblk.descr[i].name, "reuseport.steering")) {
+			cstr = es_str2cstr(pvals[i].val.d.estr, NULL);
+			if(!strcasecmp(cstr, "kernel")) {
+				loadModConf->reusePortSteering = REUSEPORT_STEER_KERNEL;
+			} else if(!strcasecmp(cstr, "source")) {
+#				ifdef HAVE_REUSEPORT_CBPF
+				loadModConf->reusePortSteering = REUSEPORT_STEER_SOURCE;
+#				else
+				LogError(0, RS_RET_NOT_IMPLEMENTED, "imudp: reuseport.steering "
+					"\"source\" is not supported on this platform - using "
+					"kernel default distribution");
+#				endif
+			} else {
+				LogError(0, RS_RET_PARAM_ERROR, "imudp: invalid value '%s' for "
+					"reuseport.steering, must be \"kernel\" or \"source\" - "
+					"using \"kernel\"", cstr);
+			}
+			free(cstr);
+		} else if(!strcmp(modpblk.descr[i].name, "gro")) {
+#			ifdef HAVE_UDP_GRO
+			loadModConf->bGRO = (int) pvals[i].val.d.n;
+#			else
+			if(pvals[i].val.d.n) {
+				LogError(0, RS_RET_NOT_IMPLEMENTED, "imudp: parameter \"gro\" is "
+					"not supported on this platform - ignored");
+			}
+#			endif
 		} else {
 			dbgprintf("imudp: program error, non-handled "
 			  "param '%s' in beginCnfLoad\n", modpblk.descr[i].name);
@@ -1164,13 +1524,20 @@ ENDactivateCnfPrePrivDrop
 BEGINactivateCnf
 	int i;
 	int lenRcvBuf;
+	int nSlots = 1;
 CODESTARTactivateCnf
 	/* caching various settings */
 	iMaxLine = glbl.GetMaxLine();
-	lenRcvBuf = iMaxLine + 1;
+	iRcvSlotSize = iMaxLine + 1;
+#	ifdef HAVE_UDP_GRO
+	/* a GRO receive may hold many datagrams, up to the max UDP payload */
+	if(runModConf->bGRO && iRcvSlotSize < GRO_RCV_SLOT_SIZE)
+		iRcvSlotSize = GRO_RCV_SLOT_SIZE;
+#	endif
 #	ifdef HAVE_RECVMMSG
-	lenRcvBuf *= runModConf->batchSize;
+	nSlots = runModConf->batchSize;
 #	endif
+	lenRcvBuf = iRcvSlotSize * nSlots;
 	DBGPRINTF("imudp: config params iMaxLine %d, lenRcvBuf %d\n", iMaxLine, lenRcvBuf);
 	for(i = 0 ; i < runModConf->wrkrMax ; ++i) {
 #		ifdef HAVE_RECVMMSG
@@ -1178,6 +1545,10 @@ CODESTARTactivateCnf
 		CHKmalloc(wrkrInfo[i].recvmsg_mmh = malloc(runModConf->batchSize * sizeof(struct mmsghdr)));
 		CHKmalloc(wrkrInfo[i].frominet = malloc(runModConf->batchSize * sizeof(struct sockaddr_storage)));
 #		endif
+		if(runModConf->bReusePort || runModConf->bGRO) {
+			/* ancillary data buffers for SO_RXQ_OVFL and UDP_GRO */
+			CHKmalloc(wrkrInfo[i].pCtlBuf = malloc(nSlots * CTLBUF_SIZE_PER_PKT));
+		}
 		CHKmalloc(wrkrInfo[i].pRcvBuf = malloc(lenRcvBuf));
 		wrkrInfo[i].id = i;
 	}
@@ -1242,6 +1613,11 @@ wrkr(void *myself)
 	STATSCOUNTER_INIT(pWrkr->ctrMsgsRcvd, pWrkr->mutCtrMsgsRcvd);
 	statsobj.AddCounter(pWrkr->stats, UCHAR_CONSTANT("msgs.received"),
 		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &(pWrkr->ctrMsgsRcvd));
+	if(runModConf->bReusePort) {
+		STATSCOUNTER_INIT(pWrkr->ctrRcvDrops, pWrkr->mutCtrRcvDrops);
+		statsobj.AddCounter(pWrkr->stats, UCHAR_CONSTANT("rcvbuf.dropped"),
+			ctrType_IntCtr, CTR_FLAG_RESETTABLE, &(pWrkr->ctrRcvDrops));
+	}
 	statsobj.ConstructFinalize(pWrkr->stats);
 
 	rcvMainLoop(pWrkr);
@@ -1298,6 +1674,13 @@ CODESTARTafterRun
 		statsobj.Destruct(&(lstn->stats));
 		ratelimitDestruct(lstn->ratelimiter);
 		close(lstn->sock);
+		if(lstn->wrkrSocks != NULL) {
+			/* wrkrSocks[0] is lstn->sock, already closed */
+			for(i = 1 ; i < runModConf->wrkrMax ; ++i)
+				close(lstn->wrkrSocks[i]);
+			free(lstn->wrkrSocks);
+			free(lstn->wrkrDrops);
+		}
 		prop.Destruct(&lstn->pInputName);
 		lstnDel = lstn;
 		lstn = lstn->next;
@@ -1311,6 +1694,8 @@ CODESTARTafterRun
 		free(wrkrInfo[i].frominet);
 #		endif
 		free(wrkrInfo[i].pRcvBuf);
+		free(wrkrInfo[i].pCtlBuf);
+		wrkrInfo[i].pCtlBuf = NULL;
 	}
 ENDafterRun
 
@@ -119,6 +119,11 @@ statsobj_t *modStats;
 STATSCOUNTER_DEF(ctrSubmit, mutCtrSubmit)
 STATSCOUNTER_DEF(ctrLostRatelimit, mutCtrLostRatelimit)
 STATSCOUNTER_DEF(ctrNumRatelimiters, mutCtrNumRatelimiters)
+STATSCOUNTER_DEF(ctrTPCacheHits, mutCtrTPCacheHits)
+STATSCOUNTER_DEF(ctrTPCacheMisses, mutCtrTPCacheMisses)
+STATSCOUNTER_DEF(ctrCallRecvmmsg, mutCtrCallRecvmmsg)
+STATSCOUNTER_DEF(ctrMsgsRcvd, mutCtrMsgsRcvd)
+STATSCOUNTER_DEF(ctrBatchFull, mutCtrBatchFull)
 
 
 /* a very simple "hash function" for process IDs - we simply use the
@@ -176,6 +181,67 @@ static int nfd = 1; /* number of active unix sockets  (socket 0 is always reserv
 			socket, even if it is not enabled. */
 static int sd_fds = 0;			/* number of systemd activated sockets */
 
+/* ancillary data we need per datagram: credentials and timestamp. This is
+ * a union rather than a plain char array in order to force
+ * alignment with cmsghdr.
+ */
+#define CTLBUF_SIZE_PER_PKT 128
+typedef union {
+	char buf[CTLBUF_SIZE_PER_PKT];
+	struct cmsghdr cm;
+} ctlbuf_t;
+
+#ifdef HAVE_RECVMMSG
+/* batch receive buffers. All listeners are served by the single input
+ * thread, so one set of buffers is sufficient. Allocated in willRun().
+ */
+static struct {
+	struct mmsghdr *mmh;
+	struct iovec *iov;
+	ctlbuf_t *ctl;
+	uchar *pRcvBuf;		/* batchSize slots of iRcvSlotSize bytes */
+	int iRcvSlotSize;
+	sbool bNoRecvmmsg;	/* recvmmsg() not supported, use recvmsg() */
+} rcvBatch;
+#endif
+
+/* cache for trusted properties. Reading comm, exe and cmdline from /proc
+ * costs several syscalls per message, which is a lot for chatty local
+ * daemons. So we keep the properties per pid in a bounded LRU cache. As
+ * pids are recycled, an entry is only valid as long as the process start
+ * time (from /proc/<pid>/stat) matches and its TTL has not yet expired.
+ * A process may also change its properties without a new pid, so we also
+ * revalidate comm (also from /proc/<pid>/stat, so it comes for free) and
+ * the inode of /proc/<pid>/exe. This catches execve() and
+ * prctl(PR_SET_NAME). A process that rewrites its argv or execs the same
+ * binary under the same name is not detected: _CMDLINE may then be stale
+ * for up to annotate.cacheTTL seconds.
+ * The cache is only accessed from the (single) input thread, so no locking
+ * is required.
+ */
+#define TPCACHE_COMM_LEN 64	/* kernel limit is 16 (TASK_COMM_LEN) */
+typedef struct tpcache_etry_s tpcache_etry_t;
+struct tpcache_etry_s {
+	pid_t pid;
+	unsigned long long starttime;	/* process start time, in clock ticks since boot */
+	char statComm[TPCACHE_COMM_LEN];	/* raw comm from /proc/<pid>/stat */
+	dev_t exeDev;			/* identity of the executable, 0/0 if unknown */
+	ino_t exeIno;
+	time_t tExpire;			/* entry must be refreshed after this time */
+	uchar *comm;			/* NULL if property could not be obtained */
+	uchar *exe;
+	uchar *cmdline;
+	int lenComm;
+	int lenExe;
+	int lenCmdline;
+	tpcache_etry_t *prev, *next;	/* LRU list, most recently used first */
+};
+static struct {
+	struct hashtable *ht;		/* pid -> tpcache_etry_t */
+	tpcache_etry_t *head, *tail;
+	int nEntries;
+} tpcache;
+
 #if (defined(__FreeBSD__) && (__FreeBSD_version >= 1200061))
 	#define DFLT_bUseSpecialParser 0
 #else
@@ -185,6 +251,11 @@ static int sd_fds = 0;			/* number of systemd activated sockets */
 #define DFLT_ratelimitInterval 0
 #define DFLT_ratelimitBurst 200
 #define DFLT_ratelimitSeverity 1			/* do not rate-limit emergency messages */
+#define DFLT_tpCacheSize 1024		/* max nbr of pids in trusted property cache, 0 = off */
+#define DFLT_tpCacheTTL 10		/* seconds a cached trusted property entry is valid. This
+					 * bounds how long an argv rewrite may go unnoticed, see
+					 * the comment at tpcache_etry_s. */
+#define DFLT_batchSize 32		/* max nbr of datagrams read by one recvmmsg() call */
 /* config vars for the legacy config system */
 static struct configSettings_s {
 	int bOmitLocalLogging;
@@ -244,6 +315,9 @@ struct modConfData_s {
 	int bParseTrusted;
 	int bUseSpecialParser;
 	int bParseHost;
+	int tpCacheSize;		/* max entries in trusted property cache, 0 = disabled */
+	int tpCacheTTL;			/* max age of trusted property cache entries (seconds) */
+	int batchSize;			/* max nbr of datagrams per recvmmsg() call */
 	sbool bIgnoreTimestamp;		/* ignore timestamps present in the incoming message? */
 	sbool bUseFlowCtl;		/* use flow control or not (if yes, only LIGHT is used! */
 	sbool bOmitLocalLogging;
@@ -272,7 +346,10 @@ static struct cnfparamdescr modpdescr[] = {
 	{ "syssock.usepidfromsystem", eCmdHdlrBinary, 0 },
 	{ "syssock.ratelimit.interval", eCmdHdlrInt, 0 },
 	{ "syssock.ratelimit.burst", eCmdHdlrInt, 0 },
-	{ "syssock.ratelimit.severity", eCmdHdlrInt, 0 }
+	{ "syssock.ratelimit.severity", eCmdHdlrInt, 0 },
+	{ "annotate.cachesize", eCmdHdlrNonNegInt, 0 },
+	{ "annotate.cachettl", eCmdHdlrNonNegInt, 0 },
+	{ "batchsize", eCmdHdlrPositiveInt, 0 }
 };
 static struct cnfparamblk modpblk =
 	{ CNFPARAMBLK_VERSION,
@@ -789,6 +866,273 @@ finalize_it:
 }
 
 
+/* obtain the start time of a process (field 22 of /proc/<pid>/stat). Together
+ * with the pid, this uniquely identifies a process, even if pids are reused.
+ * We also return comm (field 2), which is used to detect that a process changed
+ * its name. Note that comm may contain spaces and parenthesis, so we start
+ * counting fields after the last ')'.
+ */
+static rsRetVal
+getProcStat(const pid_t pid, unsigned long long *const starttime, char *const comm)
+{
+	char *pComm;
+	size_t lenComm;
+	int fd;
+	int lenRead;
+	int field;
+	char *p;
+	char namebuf[64];
+	char buf[1024];
+	DEFiRet;
+
+	snprintf(namebuf, sizeof(namebuf), "/proc/%lu/stat", (long unsigned) pid);
+	if((fd = open(namebuf, O_RDONLY)) == -1) {
+		DBGPRINTF("error reading '%s'\n", namebuf);
+		ABORT_FINALIZE(RS_RET_ERR);
+	}
+	lenRead = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if(lenRead <= 0) {
+		DBGPRINTF("error reading file data for '%s'\n", namebuf);
+		ABORT_FINALIZE(RS_RET_ERR);
+	}
+	buf[lenRead] = '\0';
+
+	if((pComm = strchr(buf, '(')) == NULL || (p = strrchr(buf, ')')) == NULL || p < pComm)
+		ABORT_FINALIZE(RS_RET_ERR);
+	++pComm;
+	lenComm = p - pComm;
+	if(lenComm >= TPCACHE_COMM_LEN)
+		lenComm = TPCACHE_COMM_LEN - 1;
+	memcpy(comm, pComm, lenComm);
+	comm[lenComm] = '\0';
+	++p; /* now at the space before field 3 (state) */
+	for(field = 2 ; field < 22 && *p != '\0' ; ++p) {
+		if(*p == ' ')
+			++field;
+	}
+	if(field != 22 || !isdigit(*p))
+		ABORT_FINALIZE(RS_RET_ERR);
+	*starttime = strtoull(p, NULL, 10);
+
+finalize_it:
+	RETiRet;
+}
+
+
+/* obtain device and inode of the executable of a process. They change on
+ * execve() of a different binary. If they can not be obtained, 0/0 is
+ * returned, which then also is the value we compare against.
+ */
+static void
+getExeIdentity(const pid_t pid, dev_t *const dev, ino_t *const ino)
+{
+	char namebuf[64];
+	struct stat st;
+
+	snprintf(namebuf, sizeof(namebuf), "/proc/%lu/exe", (long unsigned) pid);
+	if(stat(namebuf, &st) == 0) {
+		*dev = st.st_dev;
+		*ino = st.st_ino;
+	} else {
+		*dev = 0;
+		*ino = 0;
+	}
+}
+
+
+/* (re-)read all trusted properties for a process into a cache entry. Properties
+ * that can not be obtained are set to NULL.
+ */
+static rsRetVal
+tpcacheReadProps(struct ucred *cred, tpcache_etry_t *const etry)
+{
+	uchar propBuf[1024];
+	int lenProp;
+	DEFiRet;
+
+	free(etry->comm);
+	free(etry->exe);
+	free(etry->cmdline);
+	etry->comm = etry->exe = etry->cmdline = NULL;
+	etry->lenComm = etry->lenExe = etry->lenCmdline = 0;
+
+	if(getTrustedProp(cred, "comm", propBuf, sizeof(propBuf), &lenProp) == RS_RET_OK) {
+		CHKmalloc(etry->comm = (uchar*) strdup((char*) propBuf));
+		etry->lenComm = lenProp;
+	}
+	if(getTrustedExe(cred, propBuf, sizeof(propBuf), &lenProp) == RS_RET_OK) {
+		CHKmalloc(etry->exe = (uchar*) strdup((char*) propBuf));
+		etry->lenExe = lenProp;
+	}
+	getExeIdentity(cred->pid, &etry->exeDev, &etry->exeIno);
+	if(getTrustedProp(cred, "cmdline", propBuf, sizeof(propBuf), &lenProp) == RS_RET_OK) {
+		/* cmdline is NUL-separated, getTrustedProp replaced the NULs by spaces,
+		 * so strdup() is safe here.
+		 */
+		CHKmalloc(etry->cmdline = (uchar*) strdup((char*) propBuf));
+		etry->lenCmdline = lenProp;
+	}
+
+finalize_it:
+	RETiRet;
+}
+
+
+static void
+tpcacheUnlinkEtry(tpcache_etry_t *const etry)
+{
+	if(etry->prev == NULL)
+		tpcache.head = etry->next;
+	else
+		etry->prev->next = etry->next;
+	if(etry->next == NULL)
+		tpcache.tail = etry->prev;
+	else
+		etry->next->prev = etry->prev;
+	etry->prev = etry->next = NULL;
+}
+
+
+static void
+tpcachePushFront(tpcache_etry_t *const etry)
+{
+	etry->prev = NULL;
+	etry->next = tpcache.head;
+	if(tpcache.head != NULL)
+		tpcache.head->prev = etry;
+	tpcache.head = etry;
+	if(tpcache.tail == NULL)
+		tpcache.tail = etry;
+}
+
+
+static void
+tpcacheFreeEtry(tpcache_etry_t *const etry)
+{
+	free(etry->comm);
+	free(etry->exe);
+	free(etry->cmdline);
+	free(etry);
+}
+
+
+static void
+tpcacheDestruct(void)
+{
+	tpcache_etry_t *etry, *del;
+
+	if(tpcache.ht == NULL)
+		return;
+	for(etry = tpcache.head ; etry != NULL ; ) {
+		del = etry;
+		etry = etry->next;
+		tpcacheFreeEtry(del);
+	}
+	hashtable_destroy(tpcache.ht, 0); /* values already freed above */
+	tpcache.ht = NULL;
+	tpcache.head = tpcache.tail = NULL;
+	tpcache.nEntries = 0;
+}
+
+
+static rsRetVal
+tpcacheConstruct(void)
+{
+	DEFiRet;
+	tpcache.head = tpcache.tail = NULL;
+	tpcache.nEntries = 0;
+	if(runModConf->tpCacheSize == 0) {
+		tpcache.ht = NULL;
+		FINALIZE;
+	}
+	CHKmalloc(tpcache.ht = create_hashtable(runModConf->tpCacheSize, hash_from_key_fn,
+		key_equals_fn, NULL));
+finalize_it:
+	RETiRet;
+}
+
+
+/* obtain the trusted properties for the sender described by cred. If possible,
+ * they are taken from the cache, else they are read from /proc and the cache
+ * is updated. If the cache is disabled or the process start time can not
+ * be obtained, the properties are read into a static scratch entry which is
+ * only valid until the next call.
+ * Returns NULL only if we ran out of memory.
+ */
+static tpcache_etry_t *
+getTrustedProps(struct ucred *cred, const time_t tt)
+{
+	static tpcache_etry_t scratch;
+	tpcache_etry_t *etry = NULL;
+	unsigned long long starttime;
+	char statComm[TPCACHE_COMM_LEN];
+	dev_t exeDev;
+	ino_t exeIno;
+	pid_t *keybuf;
+
+	if(tpcache.ht == NULL || getProcStat(cred->pid, &starttime, statComm) != RS_RET_OK) {
+		STATSCOUNTER_INC(ctrTPCacheMisses, mutCtrTPCacheMisses);
+		if(tpcacheReadProps(cred, &scratch) != RS_RET_OK)
+			return NULL;
+		return &scratch;
+	}
+
+	etry = hashtable_search(tpcache.ht, &cred->pid);
+	if(etry != NULL) {
+		tpcacheUnlinkEtry(etry);
+		tpcachePushFront(etry);
+		if(etry->starttime == starttime && etry->tExpire > tt
+		   && !strcmp(etry->statComm, statComm)) {
+			getExeIdentity(cred->pid, &exeDev, &exeIno);
+			if(etry->exeDev == exeDev && etry->exeIno == exeIno) {
+				STATSCOUNTER_INC(ctrTPCacheHits, mutCtrTPCacheHits);
+				return etry;
+			}
+		}
+		/* process gone (pid reused), changed (exec, new name) or entry
+		 * too old - refresh it
+		 */
+		DBGPRINTF("imuxsock: refreshing trusted properties for pid %lu\n",
+			(long unsigned) cred->pid);
+	} else {
+		if(tpcache.nEntries >= runModConf->tpCacheSize) {
+			/* evict least recently used entry and reuse its memory */
+			etry = tpcache.tail;
+			tpcacheUnlinkEtry(etry);
+			hashtable_remove(tpcache.ht, &etry->pid);
+			--tpcache.nEntries;
+		} else if((etry = calloc(1, sizeof(tpcache_etry_t))) == NULL) {
+			return NULL;
+		}
+		if((keybuf = malloc(sizeof(pid_t))) == NULL) {
+			tpcacheFreeEtry(etry);
+			return NULL;
+		}
+		*keybuf = cred->pid;
+		if(hashtable_insert(tpcache.ht, keybuf, etry) == 0) {
+			free(keybuf);
+			tpcacheFreeEtry(etry);
+			return NULL;
+		}
+		etry->pid = cred->pid;
+		tpcachePushFront(etry);
+		++tpcache.nEntries;
+	}
+
+	STATSCOUNTER_INC(ctrTPCacheMisses, mutCtrTPCacheMisses);
+	etry->starttime = starttime;
+	memcpy(etry->statComm, statComm, sizeof(statComm));
+	etry->tExpire = tt + runModConf->tpCacheTTL;
+	if(tpcacheReadProps(cred, etry) != RS_RET_OK) {
+		/* keep the entry, but make sure it is refreshed on next use */
+		etry->tExpire = 0;
+		return NULL;
+	}
+	return etry;
+}
+
+
 /* copy a trusted property in escaped mode. That is, the property can contain
  * any character and so it must be properly quoted AND escaped.
  * It is assumed the output buffer is large enough. Returns the number of
@@ -816,7 +1160,8 @@ copyescaped(uchar *dstbuf, uchar *inbuf, int inlen)
  * can also mangle it if necessary.
  */
 static rsRetVal
-SubmitMsg(uchar *pRcv, int lenRcv, lstn_t *pLstn, struct ucred *cred, struct timeval *ts)
+SubmitMsg(uchar *pRcv, int lenRcv, lstn_t *pLstn, struct ucred *cred, struct timeval *ts,
+	multi_submit_t *const pMultiSub)
 {
 	smsg_t *pMsg = NULL;
 	int lenMsg;
@@ -875,7 +1220,9 @@ SubmitMsg(uchar *pRcv, int lenRcv, lstn_t *pLstn, struct ucred *cred, struct tim
 	if(cred != NULL && pLstn->bAnnotate) {
 		uchar propBuf[1024];
 		int lenProp;
+		tpcache_etry_t *tprops;
 
+		CHKmalloc(tprops = getTrustedProps(cred, tt));
 		if (pLstn->bParseTrusted) {
 			struct json_object *json, *jval;
 
@@ -893,16 +1240,16 @@ SubmitMsg(uchar *pRcv, int lenRcv, lstn_t *pLstn, struct ucred *cred, struct tim
 			json_object_object_add(json, "uid", jval);
 			CHKjson(jval = json_object_new_int(cred->gid), json);
 			json_object_object_add(json, "gid", jval);
-			if(getTrustedProp(cred, "comm", propBuf, sizeof(propBuf), &lenProp) == RS_RET_OK) {
-				CHKjson(jval = json_object_new_string((char*)propBuf), json);
+			if(tprops->comm != NULL) {
+				CHKjson(jval = json_object_new_string((char*)tprops->comm), json);
 				json_object_object_add(json, "appname", jval);
 			}
-			if(getTrustedExe(cred, propBuf, sizeof(propBuf), &lenProp) == RS_RET_OK) {
-				CHKjson(jval = json_object_new_string((char*)propBuf), json);
+			if(tprops->exe != NULL) {
+				CHKjson(jval = json_object_new_string((char*)tprops->exe), json);
 				json_object_object_add(json, "exe", jval);
 			}
-			if(getTrustedProp(cred, "cmdline", propBuf, sizeof(propBuf), &lenProp) == RS_RET_OK) {
-				CHKjson(jval = json_object_new_string((char*)propBuf), json);
+			if(tprops->cmdline != NULL) {
+				CHKjson(jval = json_object_new_string((char*)tprops->cmdline), json);
 				json_object_object_add(json, "cmd", jval);
 			}
 #undef CHKjson
@@ -931,20 +1278,20 @@ SubmitMsg(uchar *pRcv, int lenRcv, lstn_t *pLstn, struct ucred *cred, struct tim
 			memcpy(pmsgbuf+toffs, propBuf, lenProp);
 			toffs = toffs + lenProp;
 	
-			if(getTrustedProp(cred, "comm", propBuf, sizeof(propBuf), &lenProp) == RS_RET_OK) {
+			if(tprops->comm != NULL) {
 				memcpy(pmsgbuf+toffs, " _COMM=", 7);
-				memcpy(pmsgbuf+toffs+7, propBuf, lenProp);
-				toffs = toffs + 7 + lenProp;
+				memcpy(pmsgbuf+toffs+7, tprops->comm, tprops->lenComm);
+				toffs = toffs + 7 + tprops->lenComm;
 			}
-			if(getTrustedExe(cred, propBuf, sizeof(propBuf), &lenProp) == RS_RET_OK) {
+			if(tprops->exe != NULL) {
 				memcpy(pmsgbuf+toffs, " _EXE=", 6);
-				memcpy(pmsgbuf+toffs+6, propBuf, lenProp);
-				toffs = toffs + 6 + lenProp;
+				memcpy(pmsgbuf+toffs+6, tprops->exe, tprops->lenExe);
+				toffs = toffs + 6 + tprops->lenExe;
 			}
-			if(getTrustedProp(cred, "cmdline", propBuf, sizeof(propBuf), &lenProp) == RS_RET_OK) {
+			if(tprops->cmdline != NULL) {
 				memcpy(pmsgbuf+toffs, " _CMDLINE=", 10);
 				toffs = toffs + 10 +
-					copyescaped(pmsgbuf+toffs+10, propBuf, lenProp);
+					copyescaped(pmsgbuf+toffs+10, tprops->cmdline, tprops->lenCmdline);
 			}
 
 			/* finalize string */
@@ -1030,7 +1377,7 @@ SubmitMsg(uchar *pRcv, int lenRcv, lstn_t *pLstn, struct ucred *cred, struct tim
 	MsgSetRcvFrom(pMsg, pLstn->hostName == NULL ? glbl.GetLocalHostNameProp() : pLstn->hostName);
 	CHKiRet(MsgSetRcvFromIP(pMsg, pLocalHostIP));
 	MsgSetRuleset(pMsg, pLstn->pRuleset);
-	ratelimitAddMsg(ratelimiter, NULL, pMsg);
+	ratelimitAddMsg(ratelimiter, pMultiSub, pMsg);
 	STATSCOUNTER_INC(ctrSubmit, mutCtrSubmit);
 finalize_it:
 	if(iRet != RS_RET_OK) {
@@ -1041,6 +1388,39 @@ finalize_it:
 }
 
 
+/* extract the ancillary data (credentials, timestamp)
+ * of a received datagram.
+ */
+static void
+processCmsgs(lstn_t *const pLstn, struct msghdr *const msgh,
+	struct ucred *const cred, int *const cred_set,
+	struct timeval *const ts, int *const ts_set)
+{
+	struct cmsghdr *cm;
+
+	if(msgh->msg_control == NULL)
+		return;
+	for(cm = CMSG_FIRSTHDR(msgh); cm; cm = CMSG_NXTHDR(msgh, cm)) {
+#		ifdef HAVE_SCM_CREDENTIALS
+		if(   pLstn->bUseCreds
+		   && cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_CREDENTIALS) {
+			memcpy(cred, CMSG_DATA(cm), sizeof(*cred));
+			*cred_set = 1;
+		}
+#		endif /* HAVE_SCM_CREDENTIALS */
+#		if HAVE_SO_TIMESTAMP
+		if(   pLstn->bUseCreds && pLstn->bUseSysTimeStamp
+		   && cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SO_TIMESTAMP) {
+			memcpy(ts, CMSG_DATA(cm), sizeof(*ts));
+			*ts_set = 1;
+		}
+#		endif /* HAVE_SO_TIMESTAMP */
+	}
+	/* silence "unused" warnings on platforms that support none of the above */
+	(void) cred; (void) cred_set; (void) ts; (void) ts_set;
+}
+
+
 /* This function receives data from a socket indicated to be ready
  * to receive and submits the message received for processing.
  * rgerhards, 2007-12-20
@@ -1061,13 +1441,7 @@ static rsRetVal readSocket(lstn_t *pLstn)
 	int ts_set = 0;
 	uchar bufRcv[4096+1];
 	uchar *pRcv = NULL; /* receive buffer */
-#	ifdef HAVE_SCM_CREDENTIALS
-	/* aux is a union rather than a direct char array to force alignment with cmsghdr */
-	union {
-		char buf[128];
-		struct cmsghdr cm;
-	} aux;
-#	endif
+	ctlbuf_t aux;
 
 	assert(pLstn->fd >= 0);
 
@@ -1087,13 +1461,9 @@ static rsRetVal readSocket(lstn_t *pLstn)
 
 	memset(&msgh, 0, sizeof(msgh));
 	memset(&msgiov, 0, sizeof(msgiov));
-#	ifdef HAVE_SCM_CREDENTIALS
-	if(pLstn->bUseCreds) {
-		memset(&aux, 0, sizeof(aux));
-		msgh.msg_control = &aux;
-		msgh.msg_controllen = sizeof(aux);
-	}
-#	endif
+	memset(&aux, 0, sizeof(aux));
+	msgh.msg_control = &aux;
+	msgh.msg_controllen = sizeof(aux);
 	msgiov.iov_base = (char*)pRcv;
 	msgiov.iov_len = iMaxLine;
 	msgh.msg_iov = &msgiov;
@@ -1106,28 +1476,8 @@ static rsRetVal readSocket(lstn_t *pLstn)
 
 	DBGPRINTF("Message from UNIX socket: #%d, size %d\n", pLstn->fd, (int) iRcvd);
 	if(iRcvd > 0) {
-#		if defined(HAVE_SCM_CREDENTIALS) || defined(HAVE_SO_TIMESTAMP)
-		if(pLstn->bUseCreds) {
-			struct cmsghdr *cm;
-			for(cm = CMSG_FIRSTHDR(&msgh); cm; cm = CMSG_NXTHDR(&msgh, cm)) {
-#				ifdef HAVE_SCM_CREDENTIALS
-				if(   pLstn->bUseCreds
-				   && cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_CREDENTIALS) {
-					memcpy(&cred, CMSG_DATA(cm), sizeof(cred));
-					cred_set = 1;
-				}
-#				endif /* HAVE_SCM_CREDENTIALS */
-#				if HAVE_SO_TIMESTAMP
-				if(   pLstn->bUseSysTimeStamp
-				   && cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SO_TIMESTAMP) {
-					memcpy(&ts, CMSG_DATA(cm), sizeof(ts));
-					ts_set = 1;
-				}
-#				endif /* HAVE_SO_TIMESTAMP */
-			}
-		}
-#		endif /* defined(HAVE_SCM_CREDENTIALS) || defined(HAVE_SO_TIMESTAMP) */
-		CHKiRet(SubmitMsg(pRcv, iRcvd, pLstn, (cred_set ? &cred : NULL), (ts_set ? &ts : NULL)));
+		processCmsgs(pLstn, &msgh, &cred, &cred_set, &ts, &ts_set);
+		CHKiRet(SubmitMsg(pRcv, iRcvd, pLstn, (cred_set ? &cred : NULL), (ts_set ? &ts : NULL), NULL));
 	} else if(iRcvd < 0 && errno != EINTR && errno != EAGAIN) {
 		char errStr[1024];
 		rs_strerror_r(errno, errStr, sizeof(errStr));
@@ -1143,6 +1493,116 @@ finalize_it:
 }
 
 
+#ifdef HAVE_RECVMMSG
+static void
+freeRcvBatch(void)
+{
+	free(rcvBatch.mmh);
+	free(rcvBatch.iov);
+	free(rcvBatch.ctl);
+	free(rcvBatch.pRcvBuf);
+	rcvBatch.mmh = NULL;
+	rcvBatch.iov = NULL;
+	rcvBatch.ctl = NULL;
+	rcvBatch.pRcvBuf = NULL;
+}
+
+
+static rsRetVal
+allocRcvBatch(void)
+{
+	const int batchSize = runModConf->batchSize;
+	DEFiRet;
+
+	rcvBatch.bNoRecvmmsg = 0;
+	rcvBatch.iRcvSlotSize = glbl.GetMaxLine() + 1;
+	CHKmalloc(rcvBatch.mmh = calloc(batchSize, sizeof(struct mmsghdr)));
+	CHKmalloc(rcvBatch.iov = calloc(batchSize, sizeof(struct iovec)));
+	CHKmalloc(rcvBatch.ctl = calloc(batchSize, sizeof(ctlbuf_t)));
+	CHKmalloc(rcvBatch.pRcvBuf = malloc((size_t) batchSize * rcvBatch.iRcvSlotSize));
+	DBGPRINTF("imuxsock: using recvmmsg() with batch size %d\n", batchSize);
+
+finalize_it:
+	if(iRet != RS_RET_OK)
+		freeRcvBatch();
+	RETiRet;
+}
+
+
+/* batch version of readSocket(): receive up to batchSize datagrams with a
+ * single recvmmsg() call and submit them as one multi-submit batch, so that
+ * the main queue is locked once per batch rather than once per message.
+ * Ordering is preserved, as all messages of a socket are still submitted
+ * in sequence by the input thread.
+ */
+static rsRetVal
+readSocketBatch(lstn_t *pLstn)
+{
+	smsg_t *pMsgs[CONF_NUM_MULTISUB];
+	multi_submit_t multiSub;
+	struct ucred cred;
+	struct timeval ts;
+	int cred_set;
+	int ts_set;
+	int nelem;
+	int i;
+	DEFiRet;
+
+	assert(pLstn->fd >= 0);
+
+	for(i = 0 ; i < runModConf->batchSize ; ++i) {
+		rcvBatch.iov[i].iov_base = rcvBatch.pRcvBuf + (size_t) i * rcvBatch.iRcvSlotSize;
+		rcvBatch.iov[i].iov_len = rcvBatch.iRcvSlotSize - 1;
+		memset(&rcvBatch.mmh[i], 0, sizeof(struct mmsghdr));
+		rcvBatch.mmh[i].msg_hdr.msg_iov = &rcvBatch.iov[i];
+		rcvBatch.mmh[i].msg_hdr.msg_iovlen = 1;
+		rcvBatch.mmh[i].msg_hdr.msg_control = &rcvBatch.ctl[i];
+		rcvBatch.mmh[i].msg_hdr.msg_controllen = sizeof(ctlbuf_t);
+	}
+
+	nelem = recvmmsg(pLstn->fd, rcvBatch.mmh, runModConf->batchSize, MSG_DONTWAIT, NULL);
+	STATSCOUNTER_INC(ctrCallRecvmmsg, mutCtrCallRecvmmsg);
+	DBGPRINTF("imuxsock: recvmmsg on socket #%d returned %d\n", pLstn->fd, nelem);
+	if(nelem < 0) {
+		if(errno == ENOSYS) {
+			/* be careful: some versions of valgrind do not support recvmmsg()! */
+			DBGPRINTF("imuxsock: error ENOSYS on call to recvmmsg() - fall back to recvmsg\n");
+			rcvBatch.bNoRecvmmsg = 1;
+			iRet = readSocket(pLstn);
+		} else if(errno != EINTR && errno != EAGAIN) {
+			char errStr[1024];
+			rs_strerror_r(errno, errStr, sizeof(errStr));
+			DBGPRINTF("UNIX socket error: %d = %s.\n", errno, errStr);
+			LogError(errno, NO_ERRCODE, "imuxsock: recvmmsg UNIX");
+		}
+		FINALIZE;
+	}
+
+	STATSCOUNTER_ADD(ctrMsgsRcvd, mutCtrMsgsRcvd, nelem);
+	if(nelem == runModConf->batchSize)
+		STATSCOUNTER_INC(ctrBatchFull, mutCtrBatchFull);
+
+	multiSub.ppMsgs = pMsgs;
+	multiSub.maxElem = CONF_NUM_MULTISUB;
+	multiSub.nElem = 0;
+	for(i = 0 ; i < nelem ; ++i) {
+		if(rcvBatch.mmh[i].msg_len == 0)
+			continue;
+		cred_set = 0;
+		ts_set = 0;
+		processCmsgs(pLstn, &rcvBatch.mmh[i].msg_hdr, &cred, &cred_set, &ts, &ts_set);
+		/* errors are per message, so we continue with the rest of the batch */
+		SubmitMsg(rcvBatch.iov[i].iov_base, rcvBatch.mmh[i].msg_len, pLstn,
+			(cred_set ? &cred : NULL), (ts_set ? &ts : NULL), &multiSub);
+	}
+	multiSubmitFlush(&multiSub);
+
+finalize_it:
+	RETiRet;
+}
+#endif /* #ifdef HAVE_RECVMMSG */
+
+
 /* activate current listeners */
 static rsRetVal
 activateListeners(void)
@@ -1257,6 +1717,9 @@ CODESTARTbeginCnfLoad
 	pModConf->ratelimitIntervalSysSock = DFLT_ratelimitInterval;
 	pModConf->ratelimitBurstSysSock = DFLT_ratelimitBurst;
 	pModConf->ratelimitSeveritySysSock = DFLT_ratelimitSeverity;
+	pModConf->tpCacheSize = DFLT_tpCacheSize;
+	pModConf->tpCacheTTL = DFLT_tpCacheTTL;
+	pModConf->batchSize = DFLT_batchSize;
 	bLegacyCnfModGlobalsPermitted = 1;
 	/* reset legacy config vars */
 	resetConfigVariables(NULL, NULL);
@@ -1312,6 +1775,12 @@ CODESTARTsetModCnf
 			loadModConf->ratelimitBurstSysSock = (int) pvals[i].val.d.n;
 		} else if(!strcmp(modpblk.descr[i].name, "syssock.ratelimit.severity")) {
 			loadModConf->ratelimitSeveritySysSock = (int) pvals[i].val.d.n;
+		} else if(!strcmp(modpblk.descr[i].name, "annotate.cachesize")) {
+			loadModConf->tpCacheSize = (int) pvals[i].val.d.n;
+		} else if(!strcmp(modpblk.descr[i].name, "annotate.cachettl")) {
+			loadModConf->tpCacheTTL = (int) pvals[i].val.d.n;
+		} else if(!strcmp(modpblk.descr[i].name, "batchsize")) {
+			loadModConf->batchSize = (int) pvals[i].val.d.n;
 		} else {
 			dbgprintf("imuxsock: program error, non-handled "
 			  "param '%s' in beginCnfLoad\n", modpblk.descr[i].name);
@@ -1545,7 +2014,14 @@ CODESTARTrunInput
 			if(glbl.GetGlobalInputTermState() == 1)
 				ABORT_FINALIZE(RS_RET_FORCE_TERM); /* terminate input! */
 			if(pollfds[i].revents & POLLIN) {
+#				ifdef HAVE_RECVMMSG
+				if(rcvBatch.bNoRecvmmsg)
+					readSocket(&(listeners[i]));
+				else
+					readSocketBatch(&(listeners[i]));
+#				else
 				readSocket(&(listeners[i]));
+#				endif
 				--nfds; /* indicate we have processed one */
 			}
 		}
@@ -1558,6 +2034,11 @@ ENDrunInput
 
 BEGINwillRun
 CODESTARTwillRun
+	CHKiRet(tpcacheConstruct());
+#	ifdef HAVE_RECVMMSG
+	CHKiRet(allocRcvBatch());
+#	endif
+finalize_it:
 ENDwillRun
 
 
@@ -1598,6 +2079,10 @@ CODESTARTafterRun
 
 	discardLogSockets();
 	nfd = 1;
+	tpcacheDestruct();
+#	ifdef HAVE_RECVMMSG
+	freeRcvBatch();
+#	endif
 ENDafterRun
 
 
@@ -1762,6 +2247,21 @@ CODEmodInit_QueryRegCFSLineHdlr
 	STATSCOUNTER_INIT(ctrNumRatelimiters, mutCtrNumRatelimiters);
 	CHKiRet(statsobj.AddCounter(modStats, UCHAR_CONSTANT("ratelimit.numratelimiters"),
 		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ctrNumRatelimiters));
+	STATSCOUNTER_INIT(ctrTPCacheHits, mutCtrTPCacheHits);
+	CHKiRet(statsobj.AddCounter(modStats, UCHAR_CONSTANT("trustedprops.cache.hits"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ctrTPCacheHits));
+	STATSCOUNTER_INIT(ctrTPCacheMisses, mutCtrTPCacheMisses);
+	CHKiRet(statsobj.AddCounter(modStats, UCHAR_CONSTANT("trustedprops.cache.misses"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ctrTPCacheMisses));
+	STATSCOUNTER_INIT(ctrCallRecvmmsg, mutCtrCallRecvmmsg);
+	CHKiRet(statsobj.AddCounter(modStats, UCHAR_CONSTANT("called.recvmmsg"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ctrCallRecvmmsg));
+	STATSCOUNTER_INIT(ctrMsgsRcvd, mutCtrMsgsRcvd);
+	CHKiRet(statsobj.AddCounter(modStats, UCHAR_CONSTANT("recvmmsg.msgs"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ctrMsgsRcvd));
+	STATSCOUNTER_INIT(ctrBatchFull, mutCtrBatchFull);
+	CHKiRet(statsobj.AddCounter(modStats, UCHAR_CONSTANT("recvmmsg.batchfull"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ctrBatchFull));
 	CHKiRet(statsobj.ConstructFinalize(modStats));
 
 ENDmodInit
@@ -812,6 +812,222 @@ applyDfltTZ(struct syslogTime *pTime, char *tz)
  * END CODE-LIBLOGGING                                             *
  *******************************************************************/
 
+/* Fast paths for the timestamp parsers above. They handle only the
+ * fixed-width layouts that virtually all senders emit. Instead of a
+ * per-character helper call and compare, all fixed-position digits,
+ * separators and value ranges are validated into a single flag word,
+ * which is checked with one branch. If the fast path bails out, it has
+ * not modified any of its output parameters and the caller falls back
+ * to the generic code, which also handles the more exotic variants.
+ * For any input the fast path accepts, the result is exactly what the
+ * generic parser would have produced.
+ */
+
+/* convert two decimal digits; non-digits are flagged in *pBad */
+static inline int
+fastParse2Digits(const uchar *const p, unsigned *const pBad)
+{
+	const unsigned d0 = (unsigned) p[0] - '0';
+	const unsigned d1 = (unsigned) p[1] - '0';
+	*pBad |= (d0 > 9) | (d1 > 9);
+	return (int) (d0 * 10 + d1);
+}
+
+
+/* fast path for "YYYY-MM-DDThh:mm:ss[.frac](Z|+hh:mm|-hh:mm)" */
+static rsRetVal
+fastParseTIMESTAMP3339(struct syslogTime *const pTime, uchar **const ppszTS, int *const pLenStr)
+{
+	uchar *pszTS = *ppszTS;
+	int lenStr = *pLenStr;
+	unsigned bad = 0;
+	int year, month, day, hour, minute, second;
+	int secfrac = 0;
+	int secfracPrecision = 0;
+	char OffsetMode;
+	int OffsetHour = 0;
+	int OffsetMinute = 0;
+	DEFiRet;
+
+	if(lenStr < 20) /* shortest form is "YYYY-MM-DDThh:mm:ssZ" */
+		ABORT_FINALIZE(RS_RET_INVLD_TIME);
+
+	year = fastParse2Digits(pszTS, &bad) * 100 + fastParse2Digits(pszTS + 2, &bad);
+	month = fastParse2Digits(pszTS + 5, &bad);
+	day = fastParse2Digits(pszTS + 8, &bad);
+	hour = fastParse2Digits(pszTS + 11, &bad);
+	minute = fastParse2Digits(pszTS + 14, &bad);
+	second = fastParse2Digits(pszTS + 17, &bad);
+	bad |= (pszTS[4] != '-') | (pszTS[7] != '-') | (pszTS[10] != 'T')
+	     | (pszTS[13] != ':') | (pszTS[16] != ':');
+	bad |= (year >= 2100) | ((unsigned) (month - 1) > 11) | ((unsigned) (day - 1) > 30)
+	     | (hour > 23) | (minute > 59) | (second > 60);
+	if(bad)
+		ABORT_FINALIZE(RS_RET_INVLD_TIME);
+	pszTS += 19;
+	lenStr -= 19;
+
+	if(*pszTS == '.') {
+		--lenStr;
+		uchar *const pszStart = ++pszTS;
+		secfrac = srSLMGParseInt32(&pszTS, &lenStr);
+		secfracPrecision = (int) (pszTS - pszStart);
+	}
+
+	if(lenStr == 0)
+		ABORT_FINALIZE(RS_RET_INVLD_TIME);
+	if(*pszTS == 'Z') {
+		OffsetMode = 'Z';
+		++pszTS;
+		--lenStr;
+	} else if((*pszTS == '+' || *pszTS == '-') && lenStr >= 6) {
+		OffsetMode = *pszTS;
+		OffsetHour = fastParse2Digits(pszTS + 1, &bad);
+		OffsetMinute = fastParse2Digits(pszTS + 4, &bad);
+		bad |= (pszTS[3] != ':') | (OffsetHour > 23) | (OffsetMinute > 59);
+		if(bad)
+			ABORT_FINALIZE(RS_RET_INVLD_TIME);
+		pszTS += 6;
+		lenStr -= 6;
+	} else {
+		ABORT_FINALIZE(RS_RET_INVLD_TIME);
+	}
+
+	if(lenStr > 0) {
+		if(*pszTS != ' ')
+			ABORT_FINALIZE(RS_RET_INVLD_TIME);
+		++pszTS;
+		--lenStr;
+	}
+
+	*ppszTS = pszTS;
+	pTime->timeType = 2;
+	pTime->year = year;
+	pTime->month = month;
+	pTime->day = day;
+	pTime->hour = hour;
+	pTime->minute = minute;
+	pTime->second = second;
+	pTime->secfrac = secfrac;
+	pTime->secfracPrecision = secfracPrecision;
+	pTime->OffsetMode = OffsetMode;
+	pTime->OffsetHour = OffsetHour;
+	pTime->OffsetMinute = OffsetMinute;
+	*pLenStr = lenStr;
+
+finalize_it:
+	RETiRet;
+}
+
+
+/* month names packed into an int, lower case; see fastParseTIMESTAMP3164() */
+#define MONTH_KEY(a, b, c) (((unsigned) (a) << 16) | ((unsigned) (b) << 8) | (unsigned) (c))
+static const unsigned monthKeys[12] = {
+	MONTH_KEY('j', 'a', 'n'), MONTH_KEY('f', 'e', 'b'), MONTH_KEY('m', 'a', 'r'),
+	MONTH_KEY('a', 'p', 'r'), MONTH_KEY('m', 'a', 'y'), MONTH_KEY('j', 'u', 'n'),
+	MONTH_KEY('j', 'u', 'l'), MONTH_KEY('a', 'u', 'g'), MONTH_KEY('s', 'e', 'p'),
+	MONTH_KEY('o', 'c', 't'), MONTH_KEY('n', 'o', 'v'), MONTH_KEY('d', 'e', 'c')
+};
+
+/* fast path for "Mmm dd hh:mm:ss[.frac][:]", with dd possibly " d". The
+ * prepended year, year-as-hour (Cisco), TZ string and year-after-time
+ * variants are all left to the generic parser.
+ */
+static rsRetVal
+fastParseTIMESTAMP3164(struct syslogTime *const pTime, uchar **const ppszTS, int *const pLenStr)
+{
+	uchar *pszTS = *ppszTS;
+	int lenStr = *pLenStr;
+	unsigned bad = 0;
+	unsigned key;
+	unsigned dayHigh;
+	int month, day, hour, minute, second;
+	int secfrac = 0;
+	int secfracPrecision = 0;
+	int i;
+	DEFiRet;
+
+	if(lenStr < 15)
+		ABORT_FINALIZE(RS_RET_INVLD_TIME);
+
+	/* setting bit 0x20 lower-cases letters; a non-letter can never
+	 * map to one of the (all-letter) keys, so this is an exact
+	 * case-insensitive compare.
+	 */
+	key = MONTH_KEY(pszTS[0] | 0x20, pszTS[1] | 0x20, pszTS[2] | 0x20);
+	month = 0;
+	for(i = 0 ; i < 12 ; ++i)
+		month |= (key == monthKeys[i]) * (i + 1);
+
+	dayHigh = (pszTS[4] == ' ') ? 0 : (unsigned) pszTS[4] - '0';
+	day = (int) (dayHigh * 10 + ((unsigned) pszTS[5] - '0'));
+	bad |= (dayHigh > 9) | (((unsigned) pszTS[5] - '0') > 9);
+	hour = fastParse2Digits(pszTS + 7, &bad);
+	minute = fastParse2Digits(pszTS + 10, &bad);
+	second = fastParse2Digits(pszTS + 13, &bad);
+	bad |= (pszTS[3] != ' ') | (pszTS[6] != ' ') | (pszTS[9] != ':') | (pszTS[12] != ':');
+	bad |= (month == 0) | ((unsigned) (day - 1) > 30) | (hour > 23) | (minute > 59) | (second > 60);
+	if(bad)
+		ABORT_FINALIZE(RS_RET_INVLD_TIME);
+	pszTS += 15;
+	lenStr -= 15;
+
+	if(lenStr > 0 && *pszTS == '.') {
+		--lenStr;
+		uchar *const pszStart = ++pszTS;
+		secfrac = srSLMGParseInt32(&pszTS, &lenStr);
+		secfracPrecision = (int) (pszTS - pszStart);
+	}
+	if(lenStr > 0 && *pszTS == ':') {
+		++pszTS;
+		--lenStr;
+	}
+	if(lenStr > 0) {
+		if(*pszTS != ' ')
+			ABORT_FINALIZE(RS_RET_INVLD_TIME);
+		++pszTS;
+		--lenStr;
+	}
+
+	*ppszTS = pszTS;
+	pTime->timeType = 1;
+	pTime->month = month;
+	pTime->day = day;
+	pTime->hour = hour;
+	pTime->minute = minute;
+	pTime->second = second;
+	pTime->secfrac = secfrac;
+	pTime->secfracPrecision = secfracPrecision;
+	*pLenStr = lenStr;
+
+finalize_it:
+	RETiRet;
+}
+#undef MONTH_KEY
+
+
+/* These are the actual interface entry points: try the fast path
+ * first, then the generic parser.
+ */
+static rsRetVal
+tryParseTIMESTAMP3339(struct syslogTime *pTime, uchar** ppszTS, int *pLenStr)
+{
+	if(fastParseTIMESTAMP3339(pTime, ppszTS, pLenStr) == RS_RET_OK)
+		return RS_RET_OK;
+	return ParseTIMESTAMP3339(pTime, ppszTS, pLenStr);
+}
+
+static rsRetVal
+tryParseTIMESTAMP3164(struct syslogTime *pTime, uchar** ppszTS, int *pLenStr,
+	const int bParseTZ,
+	const int bDetectYearAfterTime)
+{
+	if(!bParseTZ && !bDetectYearAfterTime
+	   && fastParseTIMESTAMP3164(pTime, ppszTS, pLenStr) == RS_RET_OK)
+		return RS_RET_OK;
+	return ParseTIMESTAMP3164(pTime, ppszTS, pLenStr, bParseTZ, bDetectYearAfterTime);
+}
+
 /**
  * Format a syslogTimestamp into format required by MySQL.
  * We are using the 14 digits format. For example 20041111122600
@@ -1336,8 +1552,8 @@ CODESTARTobjQueryInterface(datetime)
 	pIf->getCurrTime = getCurrTime;
 	pIf->GetTime = getTime;
 	pIf->timeval2syslogTime = timeval2syslogTime;
-	pIf->ParseTIMESTAMP3339 = ParseTIMESTAMP3339;
-	pIf->ParseTIMESTAMP3164 = ParseTIMESTAMP3164;
+	pIf->ParseTIMESTAMP3339 = tryParseTIMESTAMP3339;
+	pIf->ParseTIMESTAMP3164 = tryParseTIMESTAMP3164;
 	pIf->formatTimestampToMySQL = formatTimestampToMySQL;
 	pIf->formatTimestampToPgSQL = formatTimestampToPgSQL;
 	pIf->formatTimestampSecFrac = formatTimestampSecFrac;
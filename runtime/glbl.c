@@ -137,13 +137,17 @@ int glblSenderStatsTimeout = 12 * 60 * 60; /* 12 hr timeout for senders */
 int glblSenderKeepTrack = 0;  /* keep track of known senders? */
 int glblUnloadModules = 1;
 int bPermitSlashInProgramname = 0;
+int bParserDispatchCache = 0; /* try the parser that last succeeded for a sender first? */
 int glblIntMsgRateLimitItv = 5;
 int glblIntMsgRateLimitBurst = 500;
 char** glblDbgFiles = NULL;
 size_t glblDbgFilesNum = 0;
 int glblDbgWhitelist = 1;
 int glblPermitCtlC = 0;
+int glblRulesetProfiling = 0; /* collect per-statement execution stats? */
 int glblInputTimeoutShutdown = 1000; /* input shutdown timeout in ms */
+int glblTlsSessLifetime = 300; /* TLS session resumption: max session age in seconds, 0 - off */
+int glblTlsTicketKeyRotation = 3600; /* TLS session ticket key rotation interval in seconds, 0 - never */
 static const uchar * operatingStateFile = NULL;
 
 uint64_t glblDevOptions = 0; /* to be used by developers only */
@@ -175,6 +179,8 @@ static struct cnfparamdescr cnfparamdescr[] = {
 	{ "defaultnetstreamdriverkeyfile", eCmdHdlrString, 0 },
 	{ "defaultnetstreamdrivercertfile", eCmdHdlrString, 0 },
 	{ "defaultnetstreamdriver", eCmdHdlrString, 0 },
+	{ "tls.session.lifetime", eCmdHdlrNonNegInt, 0 },
+	{ "tls.session.ticketkeyrotation", eCmdHdlrNonNegInt, 0 },
 	{ "maxmessagesize", eCmdHdlrSize, 0 },
 	{ "oversizemsg.errorfile", eCmdHdlrGetWord, 0 },
 	{ "oversizemsg.report", eCmdHdlrBinary, 0 },
@@ -191,6 +197,7 @@ static struct cnfparamdescr cnfparamdescr[] = {
 	{ "parser.escapecontrolcharacterscstyle", eCmdHdlrBinary, 0 },
 	{ "parser.parsehostnameandtag", eCmdHdlrBinary, 0 },
 	{ "parser.permitslashinprogramname", eCmdHdlrBinary, 0 },
+	{ "parser.dispatchcache", eCmdHdlrBinary, 0 },
 	{ "stdlog.channelspec", eCmdHdlrString, 0 },
 	{ "janitor.interval", eCmdHdlrPositiveInt, 0 },
 	{ "senders.reportnew", eCmdHdlrBinary, 0 },
@@ -215,6 +222,7 @@ static struct cnfparamdescr cnfparamdescr[] = {
 	{ "internalmsg.severity", eCmdHdlrSeverity, 0 },
 	{ "errormessagestostderr.maxnumber", eCmdHdlrPositiveInt, 0 },
 	{ "shutdown.enable.ctlc", eCmdHdlrBinary, 0 },
+	{ "ruleset.profiling", eCmdHdlrBinary, 0 },
 	{ "default.action.queue.timeoutshutdown", eCmdHdlrInt, 0 },
 	{ "default.action.queue.timeoutactioncompletion", eCmdHdlrInt, 0 },
 	{ "default.action.queue.timeoutenqueue", eCmdHdlrInt, 0 },
@@ -1399,6 +1407,8 @@ glblDoneLoadCnf(void)
 			bParseHOSTNAMEandTAG = (int) cnfparamvals[i].val.d.n;
 		} else if(!strcmp(paramblk.descr[i].name, "parser.permitslashinprogramname")) {
 			bPermitSlashInProgramname = (int) cnfparamvals[i].val.d.n;
+		} else if(!strcmp(paramblk.descr[i].name, "parser.dispatchcache")) {
+			bParserDispatchCache = (int) cnfparamvals[i].val.d.n;
 		} else if(!strcmp(paramblk.descr[i].name, "debug.logfile")) {
 			if(pszAltDbgFileName == NULL) {
 				pszAltDbgFileName = es_str2cstr(cnfparamvals[i].val.d.estr, NULL);
@@ -1482,6 +1492,12 @@ glblDoneLoadCnf(void)
 			loadConf->globals.umask = (int) cnfparamvals[i].val.d.n;
 		} else if(!strcmp(paramblk.descr[i].name, "shutdown.enable.ctlc")) {
 			glblPermitCtlC = (int) cnfparamvals[i].val.d.n;
+		} else if(!strcmp(paramblk.descr[i].name, "ruleset.profiling")) {
+			glblRulesetProfiling = (int) cnfparamvals[i].val.d.n;
+		} else if(!strcmp(paramblk.descr[i].name, "tls.session.lifetime")) {
+			glblTlsSessLifetime = (int) cnfparamvals[i].val.d.n;
+		} else if(!strcmp(paramblk.descr[i].name, "tls.session.ticketkeyrotation")) {
+			glblTlsTicketKeyRotation = (int) cnfparamvals[i].val.d.n;
 		} else if(!strcmp(paramblk.descr[i].name, "default.action.queue.timeoutshutdown")) {
 			actq_dflt_toQShutdown = cnfparamvals[i].val.d.n;
 		} else if(!strcmp(paramblk.descr[i].name, "default.action.queue.timeoutactioncompletion")) {
@@ -45,6 +45,7 @@
 extern pid_t glbl_ourpid;
 extern int bProcessInternalMessages;
 extern int bPermitSlashInProgramname;
+extern int bParserDispatchCache;
 #ifdef ENABLE_LIBLOGGING_STDLOG
 extern stdlog_channel_t stdlog_hdl;
 #endif
@@ -125,7 +126,10 @@ extern char** glblDbgFiles;
 extern size_t glblDbgFilesNum;
 extern int glblDbgWhitelist;
 extern int glblPermitCtlC;
+extern int glblRulesetProfiling;
 extern int glblInputTimeoutShutdown;
+extern int glblTlsSessLifetime;
+extern int glblTlsTicketKeyRotation;
 extern int glblIntMsgsSeverityFilter;
 extern int bTerminateInputs;
 #ifndef HAVE_ATOMIC_BUILTINS
@@ -261,6 +261,43 @@ static rsRetVal commitTransaction(wrkrInstanceData_t __attribute__((unused)) *co
 	RETiRet;\
 }
 
+/* submitAsync()
+ * Optional asynchronous variant of commitTransaction(). The module starts
+ * processing the batch and returns RS_RET_OK if it accepted it. The
+ * parameters remain valid until the module reported completion via
+ * pollCompletions(). Any other return code makes the core commit the batch
+ * synchronously via commitTransaction().
+ */
+#define BEGINsubmitAsync \
+static rsRetVal submitAsync(wrkrInstanceData_t __attribute__((unused)) *const pWrkrData, \
+	actWrkrIParams_t *const pParams, const unsigned nParams, void *const pCookie)\
+{\
+	DEFiRet;
+
+#define CODESTARTsubmitAsync /* currently empty, but may be extended */
+
+#define ENDsubmitAsync \
+	RETiRet;\
+}
+
+/* pollCompletions()
+ * Waits up to timeoutMs milliseconds (0: do not wait) for submissions to
+ * complete and calls onComplete(pCookie, status) for each completed one.
+ * A status other than RS_RET_OK makes the core retry the batch via
+ * commitTransaction(), with the usual suspension and errorfile handling.
+ */
+#define BEGINpollCompletions \
+static rsRetVal pollCompletions(wrkrInstanceData_t __attribute__((unused)) *const pWrkrData, \
+	const int timeoutMs, void (*onComplete)(void*, rsRetVal))\
+{\
+	DEFiRet;
+
+#define CODESTARTpollCompletions /* currently empty, but may be extended */
+
+#define ENDpollCompletions \
+	RETiRet;\
+}
+
 /* endTransaction()
  * introduced in v4.3.3 -- rgerhards, 2009-04-27
  */
@@ -617,6 +654,17 @@ static rsRetVal queryEtryPt(uchar *name, rsRetVal (**pEtryPoint)())\
 	}
 
 
+/* the following definition is queryEtryPt block that must be added
+ * if an output module supports the asynchronous transaction interface.
+ */
+#define CODEqueryEtryPt_ASYNC_OMOD_QUERIES \
+	  else if(!strcmp((char*) name, "submitAsync")) {\
+		*pEtryPoint = submitAsync;\
+	} else if(!strcmp((char*) name, "pollCompletions")) {\
+		*pEtryPoint = pollCompletions;\
+	}
+
+
 /* the following definition is a queryEtryPt block that must be added
  * if a non-output module supports "isCompatibleWithFeature".
  * rgerhards, 2009-07-20
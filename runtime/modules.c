@@ -738,6 +738,34 @@ doModInit(pModInit_t modInit, uchar *name, void *pModHdlr, modInfo_t **pNewModul
 			}
 
 
+			/* the async interface is optional and requires commitTransaction(),
+			 * which is used for retries and whenever the module does not accept
+			 * an async submission.
+			 */
+			localRet = (*pNew->modQueryEtryPt)((uchar*)"submitAsync",
+				   &pNew->mod.om.submitAsync);
+			if(localRet == RS_RET_MODULE_ENTRY_POINT_NOT_FOUND) {
+				pNew->mod.om.submitAsync = NULL;
+			} else if(localRet != RS_RET_OK) {
+				ABORT_FINALIZE(localRet);
+			}
+			localRet = (*pNew->modQueryEtryPt)((uchar*)"pollCompletions",
+				   &pNew->mod.om.pollCompletions);
+			if(localRet == RS_RET_MODULE_ENTRY_POINT_NOT_FOUND) {
+				pNew->mod.om.pollCompletions = NULL;
+			} else if(localRet != RS_RET_OK) {
+				ABORT_FINALIZE(localRet);
+			}
+			if((pNew->mod.om.submitAsync == NULL) != (pNew->mod.om.pollCompletions == NULL)
+			   || (pNew->mod.om.submitAsync != NULL && pNew->mod.om.commitTransaction == NULL)) {
+				LogError(0, RS_RET_INVLD_OMOD,
+					"module %s provides an incomplete async interface (needs "
+					"submitAsync(), pollCompletions() and commitTransaction()) - "
+					"async processing disabled", name);
+				pNew->mod.om.submitAsync = NULL;
+				pNew->mod.om.pollCompletions = NULL;
+			}
+
 			localRet = (*pNew->modQueryEtryPt)((uchar*)"endTransaction",
 				   &pNew->mod.om.endTransaction);
 			if(localRet == RS_RET_MODULE_ENTRY_POINT_NOT_FOUND) {
@@ -913,6 +941,7 @@ static void modPrintList(void)
 						dummyBeginTransaction) ? NULL :  pMod->mod.om.beginTransaction));
 			dbgprintf("\tEndTransaction:     %p\n", ((pMod->mod.om.endTransaction ==
 						dummyEndTransaction) ? NULL :  pMod->mod.om.endTransaction));
+			dbgprintf("\tSubmitAsync:        %p\n", pMod->mod.om.submitAsync);
 			break;
 		case eMOD_IN:
 			dbgprintf("Input Module Entry Points\n");
@@ -145,6 +145,9 @@ struct modInfo_s {
 			rsRetVal (*SetShutdownImmdtPtr)(void *pData, void *pPtr);
 			rsRetVal (*createWrkrInstance)(void*ppWrkrData, void*pData);
 			rsRetVal (*freeWrkrInstance)(void*pWrkrData);
+			/* optional asynchronous transaction interface */
+			rsRetVal (*submitAsync)(void *const, actWrkrIParams_t *const, const unsigned, void *const);
+			rsRetVal (*pollCompletions)(void *const, const int, void (*)(void*, rsRetVal));
 			sbool supportsTX;	/* set if the module supports transactions */
 		} om;
 		struct { /* data for library modules */
@@ -241,6 +241,16 @@ SetDrvrPrioritizeSAN(netstrm_t *pThis, int prioritizeSan)
 	RETiRet;
 }
 
+/* request kernel TLS offload, if the driver and system support it */
+static rsRetVal
+SetDrvrKTLS(netstrm_t *pThis, int bKTLS)
+{
+	DEFiRet;
+	ISOBJ_TYPE_assert(pThis, netstrm);
+	iRet = pThis->Drvr.SetKTLS(pThis->pDrvrData, bKTLS);
+	RETiRet;
+}
+
 
 /* End of methods to shuffle autentication settings to the driver.
  * -------------------------------------------------------------------------- */
@@ -427,6 +437,7 @@ CODESTARTobjQueryInterface(netstrm)
 	pIf->SetGnutlsPriorityString = SetGnutlsPriorityString;
 	pIf->SetDrvrCheckExtendedKeyUsage = SetDrvrCheckExtendedKeyUsage;
 	pIf->SetDrvrPrioritizeSAN = SetDrvrPrioritizeSAN;
+	pIf->SetDrvrKTLS = SetDrvrKTLS;
 finalize_it:
 ENDobjQueryInterface(netstrm)
 
@@ -322,6 +322,26 @@ GetDrvrPrioritizeSAN(netstrms_t *pThis)
 	return pThis->DrvrPrioritizeSan;
 }
 
+
+/* set whether kernel TLS offload shall be tried */
+static rsRetVal
+SetDrvrKTLS(netstrms_t *pThis, int bKTLS)
+{
+	DEFiRet;
+	ISOBJ_TYPE_assert(pThis, netstrms);
+	pThis->DrvrKTLS = bKTLS;
+	RETiRet;
+}
+
+
+/* return whether kernel TLS offload shall be tried */
+static int
+GetDrvrKTLS(netstrms_t *pThis)
+{
+	ISOBJ_TYPE_assert(pThis, netstrms);
+	return pThis->DrvrKTLS;
+}
+
 /* create an instance of a netstrm object. It is initialized with default
  * values. The current driver is used. The caller may set netstrm properties
  * and must call ConstructFinalize().
@@ -384,6 +404,8 @@ CODESTARTobjQueryInterface(netstrms)
 	pIf->GetDrvrCheckExtendedKeyUsage = GetDrvrCheckExtendedKeyUsage;
 	pIf->SetDrvrPrioritizeSAN = SetDrvrPrioritizeSAN;
 	pIf->GetDrvrPrioritizeSAN = GetDrvrPrioritizeSAN;
+	pIf->SetDrvrKTLS = SetDrvrKTLS;
+	pIf->GetDrvrKTLS = GetDrvrKTLS;
 finalize_it:
 ENDobjQueryInterface(netstrms)
 
@@ -35,6 +35,7 @@ struct netstrms_s {
 	uchar *pszDrvrAuthMode;	/**< current driver authentication mode */
 	int DrvrChkExtendedKeyUsage;		/**< if true, verify extended key usage in certs */
 	int DrvrPrioritizeSan;		/**< if true, perform stricter checking of names in certs */
+	int DrvrKTLS;			/**< if true, try to offload TLS records to the kernel */
 	uchar *pszDrvrPermitExpiredCerts;/**< current driver setting for handlign expired certs */
 	uchar *gnutlsPriorityString; /**< priorityString for connection */
 	permittedPeers_t *pPermPeers;/**< current driver's permitted peers */
@@ -64,8 +65,11 @@ BEGINinterface(netstrms) /* name must also be changed in ENDinterface macro! */
 	int      (*GetDrvrCheckExtendedKeyUsage)(netstrms_t *pThis);
 	rsRetVal (*SetDrvrPrioritizeSAN)(netstrms_t *pThis, int prioritizeSan);
 	int      (*GetDrvrPrioritizeSAN)(netstrms_t *pThis);
+	/* v2 -- kernel TLS offload */
+	rsRetVal (*SetDrvrKTLS)(netstrms_t *pThis, int bKTLS);
+	int      (*GetDrvrKTLS)(netstrms_t *pThis);
 ENDinterface(netstrms)
-#define netstrmsCURR_IF_VERSION 1 /* increment whenever you change the interface structure! */
+#define netstrmsCURR_IF_VERSION 2 /* increment whenever you change the interface structure! */
 
 /* prototypes */
 PROTOTYPEObj(netstrms);
@@ -29,6 +29,9 @@
 #include <string.h>
 #include <gnutls/gnutls.h>
 #include <gnutls/x509.h>
+#ifdef HAVE_GNUTLS_TRANSPORT_IS_KTLS_ENABLED
+#	include <gnutls/socket.h>
+#endif
 #if GNUTLS_VERSION_NUMBER <= 0x020b00
 #	include <gcrypt.h>
 #endif
@@ -37,6 +40,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <time.h>
 
 #include "rsyslog.h"
 #include "syslogd-types.h"
@@ -50,6 +54,8 @@
 #include "nsd_ptcp.h"
 #include "nsdsel_gtls.h"
 #include "nsd_gtls.h"
+#include "glbl.h"
+#include "statsobj.h"
 #include "unicode-helper.h"
 
 /* things to move to some better place/functionality - TODO */
@@ -68,6 +74,7 @@ DEFobjCurrIf(glbl)
 DEFobjCurrIf(net)
 DEFobjCurrIf(datetime)
 DEFobjCurrIf(nsd_ptcp)
+DEFobjCurrIf(statsobj)
 
 /* Static Helper variables for certless communication */
 static int bGlblSrvrInitDone = 0;	/**< 0 - server global init not yet done, 1 - already done */
@@ -81,6 +88,29 @@ static pthread_mutex_t mutGtlsStrerror;
 
 static gnutls_dh_params_t dh_params; /**< server DH parameters for anon mode */
 
+/* handshake statistics */
+static statsobj_t *gtlsStats;
+STATSCOUNTER_DEF(ctrHandshakeFull, mutCtrHandshakeFull)
+STATSCOUNTER_DEF(ctrHandshakeResumed, mutCtrHandshakeResumed)
+
+/* session ticket master key (server side) and the time it was generated */
+static gnutls_datum_t sessTicketKey = { NULL, 0 };
+static time_t tSessTicketKey;
+static pthread_mutex_t mutSessTicketKey = PTHREAD_MUTEX_INITIALIZER;
+
+/* Client side session cache, so that reconnects (e.g. by omfwd after a
+ * server restart) can resume the previous session. Sessions are keyed by
+ * "host:port" of the server. A client usually talks to only a few servers,
+ * so the cache is small and full entries are replaced round-robin.
+ */
+#define GTLS_CLNT_SESS_CACHE_SIZE 32
+static struct {
+	char *pszKey;
+	gnutls_datum_t data;
+} clntSessCache[GTLS_CLNT_SESS_CACHE_SIZE];
+static int clntSessCacheNext = 0;
+static pthread_mutex_t mutClntSessCache = PTHREAD_MUTEX_INITIALIZER;
+
 /* a macro to abort if GnuTLS error is not acceptable. We split this off from
  * CHKgnutls() to avoid some Coverity report in cases where we know GnuTLS
  * failed. Note: gnuRet must already be set accordingly!
@@ -112,6 +142,8 @@ static short bHaveKey;
 /* ------------------------------ GnuTLS specifics ------------------------------ */
 static gnutls_certificate_credentials_t xcred;
 
+static void gtlsEnableSessTickets(nsd_gtls_t *const pThis);
+
 /* This defines a log function to be provided to GnuTLS. It hopefully
  * helps us track down hard to find problems.
  * rgerhards, 2008-06-20
@@ -769,6 +801,7 @@ gtlsInitSession(nsd_gtls_t *pThis)
 	pThis->bHaveSess = 1;
 	pThis->bIsInitiator = 0;
 	pThis->sess = session;
+	gtlsEnableSessTickets(pThis);
 
 	/* Moved CertKey Loading to top */
 #	if HAVE_GNUTLS_CERTIFICATE_SET_RETRIEVE_FUNCTION
@@ -1371,6 +1404,7 @@ CODESTARTobjDestruct(nsd_gtls)
 	if(pThis->pszConnectHost != NULL) {
 		free(pThis->pszConnectHost);
 	}
+	free(pThis->pszSessKey);
 
 	if(pThis->pszRcvBuf == NULL) {
 		free(pThis->pszRcvBuf);
@@ -1571,6 +1605,205 @@ finalize_it:
 	RETiRet;
 }
 
+/* Set whether kernel TLS (kTLS) offload is requested
+ * 0 - records are always en-/decrypted by GnuTLS in userspace
+ * 1 - use kTLS if possible, otherwise silently fall back to userspace
+ * Note that GnuTLS does not provide a per-session switch: it moves the
+ * session keys to the kernel after the handshake whenever kTLS is enabled
+ * in the system-wide GnuTLS configuration (ktls = true). So all we can do
+ * here is to make sure GnuTLS has direct access to the socket (we always
+ * do) and report whether offload actually happened.
+ */
+static rsRetVal
+SetKTLS(nsd_t *pNsd, int bKTLS)
+{
+	DEFiRet;
+	nsd_gtls_t *pThis = (nsd_gtls_t*) pNsd;
+
+	ISOBJ_TYPE_assert((pThis), nsd_gtls);
+	if(bKTLS != 0 && bKTLS != 1) {
+		LogError(0, RS_RET_VALUE_NOT_SUPPORTED, "error: driver ktls %d "
+				"not supported by gtls netstream driver", bKTLS);
+		ABORT_FINALIZE(RS_RET_VALUE_NOT_SUPPORTED);
+	}
+#	ifndef HAVE_GNUTLS_TRANSPORT_IS_KTLS_ENABLED
+	if(bKTLS) {
+		static int bWarned = 0;
+		if(!bWarned) {
+			bWarned = 1;
+			LogMsg(0, RS_RET_VALUE_NOT_SUPPORTED, LOG_WARNING, "nsd_gtls: kernel TLS offload "
+				"requested, but GnuTLS version does not support it - using userspace TLS");
+		}
+	}
+#	endif
+
+	pThis->bKTLS = bKTLS;
+
+finalize_it:
+	RETiRet;
+}
+
+/* Check if the kernel took over record processing after the handshake.
+ * This is purely informational, GnuTLS transparently uses kTLS when active.
+ */
+static void
+gtlsChkKTLS(nsd_gtls_t *pThis)
+{
+#ifdef HAVE_GNUTLS_TRANSPORT_IS_KTLS_ENABLED
+	static int bReported = 0;
+	gnutls_transport_ktls_enable_flags_t ktls;
+
+	if(!pThis->bKTLS)
+		return;
+	ktls = gnutls_transport_is_ktls_enabled(pThis->sess);
+	dbgprintf("nsd_gtls %p: kTLS recv %s, send %s\n", pThis,
+		(ktls & GNUTLS_KTLS_RECV) ? "on" : "off", (ktls & GNUTLS_KTLS_SEND) ? "on" : "off");
+	if(ktls != GNUTLS_KTLS_DUPLEX && !bReported) {
+		bReported = 1;
+		LogMsg(0, NO_ERRCODE, LOG_INFO, "nsd_gtls: kernel TLS offload requested, but not "
+			"active for this session - using userspace TLS. Check that the tls kernel "
+			"module is loaded, the cipher is supported by it and ktls is enabled in the "
+			"GnuTLS system configuration. This message is only emitted once.");
+	}
+#else
+	(void) pThis;
+#endif
+}
+
+
+/* ---------------------------- session resumption ---------------------------- */
+
+/* enable session tickets for a server session. The ticket master key is
+ * replaced after the configured rotation interval. GnuTLS (3.6.13+) on top
+ * of that rotates the actual ticket encryption keys derived from it.
+ */
+static void
+gtlsEnableSessTickets(nsd_gtls_t *const pThis)
+{
+	int gnuRet;
+
+	if(glblTlsSessLifetime == 0)
+		return;
+
+	pthread_mutex_lock(&mutSessTicketKey);
+	if(sessTicketKey.data == NULL || (glblTlsTicketKeyRotation > 0
+	   && time(NULL) - tSessTicketKey >= glblTlsTicketKeyRotation)) {
+		if(sessTicketKey.data != NULL) {
+			memset(sessTicketKey.data, 0, sessTicketKey.size);
+			gnutls_free(sessTicketKey.data);
+			sessTicketKey.data = NULL;
+		}
+		if((gnuRet = gnutls_session_ticket_key_generate(&sessTicketKey)) != 0) {
+			LogError(0, RS_RET_GNUTLS_ERR, "nsd_gtls: could not generate session ticket "
+				"key, sessions can not be resumed (error %d)", gnuRet);
+			sessTicketKey.data = NULL;
+			goto done;
+		}
+		tSessTicketKey = time(NULL);
+		DBGPRINTF("nsd_gtls: new session ticket key generated\n");
+	}
+	if((gnuRet = gnutls_session_ticket_enable_server(pThis->sess, &sessTicketKey)) != 0) {
+		DBGPRINTF("nsd_gtls: could not enable session tickets, error %d\n", gnuRet);
+		goto done;
+	}
+	gnutls_db_set_cache_expiration(pThis->sess, glblTlsSessLifetime);
+done:
+	pthread_mutex_unlock(&mutSessTicketKey);
+}
+
+/* offer a cached session (if we have one) for the next client handshake.
+ * If the session has expired or is otherwise unusable, GnuTLS simply does
+ * a full handshake.
+ */
+static void
+gtlsSetClntSess(nsd_gtls_t *const pThis)
+{
+	pthread_mutex_lock(&mutClntSessCache);
+	for(int i = 0 ; i < GTLS_CLNT_SESS_CACHE_SIZE ; ++i) {
+		if(   clntSessCache[i].pszKey != NULL
+		   && !strcmp(clntSessCache[i].pszKey, (char*) pThis->pszSessKey)) {
+			if(gnutls_session_set_data(pThis->sess, clntSessCache[i].data.data,
+			   clntSessCache[i].data.size) == 0) {
+				DBGPRINTF("nsd_gtls: trying to resume session for %s\n", pThis->pszSessKey);
+			}
+			break;
+		}
+	}
+	pthread_mutex_unlock(&mutClntSessCache);
+}
+
+/* store the session of a client after the handshake. With TLS 1.3, the
+ * session ticket arrives after the handshake; GnuTLS waits a short moment
+ * for it inside gnutls_session_get_data2().
+ */
+static void
+gtlsStoreClntSess(nsd_gtls_t *const pThis)
+{
+	gnutls_datum_t data;
+	int i;
+
+	if(gnutls_session_get_data2(pThis->sess, &data) != 0)
+		return;
+
+	pthread_mutex_lock(&mutClntSessCache);
+	for(i = 0 ; i < GTLS_CLNT_SESS_CACHE_SIZE ; ++i) {
+		if(   clntSessCache[i].pszKey != NULL
+		   && !strcmp(clntSessCache[i].pszKey, (char*) pThis->pszSessKey))
+			break;
+	}
+	if(i == GTLS_CLNT_SESS_CACHE_SIZE) {
+		char *const pszKey = strdup((char*) pThis->pszSessKey);
+		if(pszKey == NULL) {
+			pthread_mutex_unlock(&mutClntSessCache);
+			gnutls_free(data.data);
+			return;
+		}
+		i = clntSessCacheNext;
+		clntSessCacheNext = (clntSessCacheNext + 1) % GTLS_CLNT_SESS_CACHE_SIZE;
+		free(clntSessCache[i].pszKey);
+		clntSessCache[i].pszKey = pszKey;
+	}
+	gnutls_free(clntSessCache[i].data.data);
+	clntSessCache[i].data = data;
+	pthread_mutex_unlock(&mutClntSessCache);
+	DBGPRINTF("nsd_gtls: stored session for %s\n", pThis->pszSessKey);
+}
+
+static void
+gtlsSessCacheExit(void)
+{
+	for(int i = 0 ; i < GTLS_CLNT_SESS_CACHE_SIZE ; ++i) {
+		free(clntSessCache[i].pszKey);
+		clntSessCache[i].pszKey = NULL;
+		gnutls_free(clntSessCache[i].data.data);
+		clntSessCache[i].data.data = NULL;
+	}
+	if(sessTicketKey.data != NULL) {
+		memset(sessTicketKey.data, 0, sessTicketKey.size);
+		gnutls_free(sessTicketKey.data);
+		sessTicketKey.data = NULL;
+	}
+}
+
+/* ---------------------------- end session resumption ---------------------------- */
+
+
+/* things to do once a handshake has successfully completed (but before
+ * the peer is authorized)
+ */
+void
+gtlsPostHandshake(nsd_gtls_t *pThis)
+{
+	if(gnutls_session_is_resumed(pThis->sess)) {
+		STATSCOUNTER_INC(ctrHandshakeResumed, mutCtrHandshakeResumed);
+	} else {
+		STATSCOUNTER_INC(ctrHandshakeFull, mutCtrHandshakeFull);
+	}
+	if(pThis->pszSessKey != NULL)
+		gtlsStoreClntSess(pThis);
+	gtlsChkKTLS(pThis);
+}
+
 /* Provide access to the underlying OS socket. This is primarily
  * useful for other drivers (like nsd_gtls) who utilize ourselfs
  * for some of their functionality. -- rgerhards, 2008-04-18
@@ -1764,6 +1997,7 @@ AcceptConnReq(nsd_t *pNsd, nsd_t **ppNew)
 	pNew->permitExpiredCerts = pThis->permitExpiredCerts;
 	pNew->pPermPeers = pThis->pPermPeers;
 	pNew->gnutlsPriorityString = pThis->gnutlsPriorityString;
+	pNew->bKTLS = pThis->bKTLS;
 
 	/* if we reach this point, we are in TLS mode */
 	iRet = gtlsInitSession(pNew);
@@ -1819,6 +2053,7 @@ AcceptConnReq(nsd_t *pNsd, nsd_t **ppNew)
 		dbgprintf("GnuTLS handshake does not complete immediately - "
 			"setting to retry (this is OK and normal)\n");
 	} else if(gnuRet == 0) {
+		gtlsPostHandshake(pNew);
 		/* we got a handshake, now check authorization */
 		CHKiRet(gtlsChkPeerAuth(pNew));
 	} else {
@@ -2138,9 +2373,18 @@ Connect(nsd_t *pNsd, int family, uchar *port, uchar *host, char *device)
 	 */
 	CHKmalloc(pThis->pszConnectHost = (uchar*)strdup((char*)host));
 
+	/* try to resume a previous session with this server */
+	if(glblTlsSessLifetime > 0) {
+		free(pThis->pszSessKey);
+		CHKmalloc(pThis->pszSessKey = malloc(strlen((char*)host) + strlen((char*)port) + 2));
+		sprintf((char*)pThis->pszSessKey, "%s:%s", host, port);
+		gtlsSetClntSess(pThis);
+	}
+
 	/* and perform the handshake */
 	CHKgnutls(gnutls_handshake(pThis->sess));
 	dbgprintf("GnuTLS handshake succeeded\n");
+	gtlsPostHandshake(pThis);
 
 	/* now check if the remote peer is permitted to talk to us - ideally, we
 	 * should do this during the handshake, but GnuTLS does not yet provide
@@ -2197,6 +2441,7 @@ CODESTARTobjQueryInterface(nsd_gtls)
 	pIf->SetGnutlsPriorityString = SetGnutlsPriorityString;
 	pIf->SetCheckExtendedKeyUsage = SetCheckExtendedKeyUsage;
 	pIf->SetPrioritizeSAN = SetPrioritizeSAN;
+	pIf->SetKTLS = SetKTLS;
 finalize_it:
 ENDobjQueryInterface(nsd_gtls)
 
@@ -2205,9 +2450,12 @@ ENDobjQueryInterface(nsd_gtls)
  */
 BEGINObjClassExit(nsd_gtls, OBJ_IS_LOADABLE_MODULE) /* CHANGE class also in END MACRO! */
 CODESTARTObjClassExit(nsd_gtls)
+	gtlsSessCacheExit();
 	gtlsGlblExit();	/* shut down GnuTLS */
+	statsobj.Destruct(&gtlsStats);
 
 	/* release objects we no longer need */
+	objRelease(statsobj, CORE_COMPONENT);
 	objRelease(nsd_ptcp, LM_NSD_PTCP_FILENAME);
 	objRelease(net, LM_NET_FILENAME);
 	objRelease(glbl, CORE_COMPONENT);
@@ -2225,6 +2473,19 @@ BEGINObjClassInit(nsd_gtls, 1, OBJ_IS_LOADABLE_MODULE) /* class, version */
 	CHKiRet(objUse(glbl, CORE_COMPONENT));
 	CHKiRet(objUse(net, LM_NET_FILENAME));
 	CHKiRet(objUse(nsd_ptcp, LM_NSD_PTCP_FILENAME));
+	CHKiRet(objUse(statsobj, CORE_COMPONENT));
+
+	/* handshake statistics */
+	CHKiRet(statsobj.Construct(&gtlsStats));
+	CHKiRet(statsobj.SetName(gtlsStats, (uchar *)"nsd_gtls"));
+	CHKiRet(statsobj.SetOrigin(gtlsStats, (uchar *)"nsd_gtls"));
+	STATSCOUNTER_INIT(ctrHandshakeFull, mutCtrHandshakeFull);
+	CHKiRet(statsobj.AddCounter(gtlsStats, (uchar *)"handshakes.full",
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ctrHandshakeFull));
+	STATSCOUNTER_INIT(ctrHandshakeResumed, mutCtrHandshakeResumed);
+	CHKiRet(statsobj.AddCounter(gtlsStats, (uchar *)"handshakes.resumed",
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ctrHandshakeResumed));
+	CHKiRet(statsobj.ConstructFinalize(gtlsStats));
 
 	/* now do global TLS init stuff */
 	CHKiRet(gtlsGlblInit());
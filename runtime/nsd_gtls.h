@@ -59,6 +59,8 @@ struct nsd_gtls_s {
 		GTLS_PURPOSE = 1
 	} dataTypeCheck;
 	int bSANpriority; /* if true, we do stricter checking (if any SAN present we do not cehck CN) */
+	int bKTLS;	/* if true, kernel TLS offload is requested */
+	uchar *pszSessKey;	/* client only: "host:port" key for the session cache */
 	gtlsRtryCall_t rtryCall;/**< what must we retry? */
 	int bIsInitiator;	/**< 0 if socket is the server end (listener), 1 if it is the initiator */
 	gnutls_session_t sess;
@@ -91,6 +93,7 @@ PROTOTYPEObj(nsd_gtls);
 /* some prototypes for things used by our nsdsel_gtls helper class */
 uchar *gtlsStrerror(int error);
 rsRetVal gtlsChkPeerAuth(nsd_gtls_t *pThis);
+void gtlsPostHandshake(nsd_gtls_t *pThis);
 rsRetVal gtlsRecordRecv(nsd_gtls_t *pThis);
 
 /* the name of our library binary */
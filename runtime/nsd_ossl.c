@@ -32,11 +32,16 @@
 #include <openssl/x509v3.h>
 #include <openssl/err.h>
 #include <openssl/engine.h>
+#include <openssl/rand.h>
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+#	include <openssl/core_names.h>
+#endif
 #include <errno.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <pthread.h>
+#include <time.h>
 
 #include "rsyslog.h"
 #include "syslogd-types.h"
@@ -50,6 +55,8 @@
 #include "nsd_ptcp.h"
 #include "nsdsel_ossl.h"
 #include "nsd_ossl.h"
+#include "glbl.h"
+#include "statsobj.h"
 #include "unicode-helper.h"
 
 /* things to move to some better place/functionality - TODO */
@@ -65,6 +72,7 @@ DEFobjCurrIf(glbl)
 DEFobjCurrIf(net)
 DEFobjCurrIf(datetime)
 DEFobjCurrIf(nsd_ptcp)
+DEFobjCurrIf(statsobj)
 
 /* OpenSSL API differences */
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
@@ -92,6 +100,39 @@ static short bHaveKey;
 static int bAnonInit;
 static MUTEX_TYPE anonInit_mut = PTHREAD_MUTEX_INITIALIZER;
 
+/* handshake statistics */
+static statsobj_t *osslStats;
+STATSCOUNTER_DEF(ctrHandshakeFull, mutCtrHandshakeFull)
+STATSCOUNTER_DEF(ctrHandshakeResumed, mutCtrHandshakeResumed)
+
+/* Session ticket keys (server side). We keep the previous key after a
+ * rotation, so that tickets issued shortly before the rotation can still
+ * be used (they are renewed with the current key on resumption).
+ */
+typedef struct osslTicketKey_s {
+	unsigned char name[16];
+	unsigned char aesKey[32];
+	unsigned char hmacKey[32];
+	time_t tCreated;
+} osslTicketKey_t;
+static osslTicketKey_t ticketKeys[2];	/* [0] - current, [1] - previous */
+static int nTicketKeys = 0;
+static MUTEX_TYPE mutTicketKeys = PTHREAD_MUTEX_INITIALIZER;
+
+/* Client side session cache, so that reconnects (e.g. by omfwd after a
+ * server restart) can resume the previous session. Sessions are keyed by
+ * "host:port" of the server. A client usually talks to only a few servers,
+ * so the cache is small and full entries are replaced round-robin.
+ */
+#define OSSL_CLNT_SESS_CACHE_SIZE 32
+static struct {
+	char *pszKey;
+	SSL_SESSION *sess;
+} clntSessCache[OSSL_CLNT_SESS_CACHE_SIZE];
+static int clntSessCacheNext = 0;
+static MUTEX_TYPE mutClntSessCache = PTHREAD_MUTEX_INITIALIZER;
+#define OSSL_TICKET_PEEK_TRIES 16
+
 /*--------------------------------------MT OpenSSL helpers ------------------------------------------*/
 static MUTEX_TYPE *mutex_buf = NULL;
 
@@ -417,6 +458,215 @@ finalize_it:
 }
 
 
+/* ---------------------------- session resumption ---------------------------- */
+
+/* generate a new ticket key, the current one becomes the previous one.
+ * Must be called with mutTicketKeys locked.
+ */
+static int
+osslNewTicketKey(void)
+{
+	osslTicketKey_t key;
+
+	if(   RAND_bytes(key.name, sizeof(key.name)) != 1
+	   || RAND_bytes(key.aesKey, sizeof(key.aesKey)) != 1
+	   || RAND_bytes(key.hmacKey, sizeof(key.hmacKey)) != 1) {
+		LogError(0, RS_RET_NO_ERRCODE, "nsd_ossl: could not generate session ticket key, "
+			"sessions can not be resumed");
+		return 0;
+	}
+	key.tCreated = time(NULL);
+	ticketKeys[1] = ticketKeys[0];
+	ticketKeys[0] = key;
+	if(nTicketKeys < 2)
+		++nTicketKeys;
+	OPENSSL_cleanse(&key, sizeof(key));
+	DBGPRINTF("nsd_ossl: new session ticket key generated\n");
+	return 1;
+}
+
+/* obtain a copy of a ticket key. If keyName is NULL, the current key for
+ * encryption is returned (and rotated if due), otherwise the key with that
+ * name. Returns 0 if there is no such key, 1 for the current and 2 for the
+ * previous key - exactly what OpenSSL's ticket key callback needs.
+ */
+static int
+osslGetTicketKey(const unsigned char *const keyName, osslTicketKey_t *const pKey)
+{
+	int r = 0;
+
+	MUTEX_LOCK(mutTicketKeys);
+	if(keyName == NULL) {
+		if(nTicketKeys == 0 || (glblTlsTicketKeyRotation > 0
+		   && time(NULL) - ticketKeys[0].tCreated >= glblTlsTicketKeyRotation)) {
+			if(!osslNewTicketKey())
+				goto done;
+		}
+		*pKey = ticketKeys[0];
+		r = 1;
+	} else {
+		for(int i = 0 ; i < nTicketKeys ; ++i) {
+			if(!memcmp(keyName, ticketKeys[i].name, sizeof(ticketKeys[i].name))) {
+				*pKey = ticketKeys[i];
+				r = i + 1;
+				break;
+			}
+		}
+	}
+done:
+	MUTEX_UNLOCK(mutTicketKeys);
+	return r;
+}
+
+/* OpenSSL callback to en-/decrypt session tickets with our rotating keys */
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+static int
+osslTicketKeyCb(SSL __attribute__((unused)) *ssl, unsigned char keyName[16], unsigned char *iv,
+	EVP_CIPHER_CTX *cctx, EVP_MAC_CTX *hctx, int enc)
+#else
+static int
+osslTicketKeyCb(SSL __attribute__((unused)) *ssl, unsigned char keyName[16], unsigned char *iv,
+	EVP_CIPHER_CTX *cctx, HMAC_CTX *hctx, int enc)
+#endif
+{
+	osslTicketKey_t key;
+	int r;
+
+	if(enc) {
+		if((r = osslGetTicketKey(NULL, &key)) == 0)
+			return -1;
+		if(RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1) {
+			r = -1;
+			goto done;
+		}
+		memcpy(keyName, key.name, sizeof(key.name));
+		if(EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, key.aesKey, iv) != 1) {
+			r = -1;
+			goto done;
+		}
+	} else {
+		if((r = osslGetTicketKey(keyName, &key)) == 0)
+			return 0; /* unknown (expired) key: do a full handshake */
+		if(EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, key.aesKey, iv) != 1) {
+			r = -1;
+			goto done;
+		}
+	}
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	OSSL_PARAM params[3];
+	params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmacKey, sizeof(key.hmacKey));
+	params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char*) "sha256", 0);
+	params[2] = OSSL_PARAM_construct_end();
+	if(EVP_MAC_CTX_set_params(hctx, params) != 1)
+		r = -1;
+#else
+	if(HMAC_Init_ex(hctx, key.hmacKey, sizeof(key.hmacKey), EVP_sha256(), NULL) != 1)
+		r = -1;
+#endif
+
+done:
+	OPENSSL_cleanse(&key, sizeof(key));
+	return r;
+}
+
+/* OpenSSL callback for new sessions. We use it on the client side to
+ * store the session for later resumption. Returns 1 if we keep the
+ * session reference, 0 otherwise.
+ */
+static int
+osslNewSessCb(SSL *ssl, SSL_SESSION *sess)
+{
+	nsd_ossl_t *pThis;
+	int i;
+
+	if(SSL_is_server(ssl))
+		return 0;
+	pThis = (nsd_ossl_t*) SSL_get_ex_data(ssl, 0);
+	if(pThis == NULL || pThis->pszSessKey == NULL)
+		return 0;
+
+	MUTEX_LOCK(mutClntSessCache);
+	for(i = 0 ; i < OSSL_CLNT_SESS_CACHE_SIZE ; ++i) {
+		if(   clntSessCache[i].pszKey != NULL
+		   && !strcmp(clntSessCache[i].pszKey, (char*) pThis->pszSessKey))
+			break;
+	}
+	if(i == OSSL_CLNT_SESS_CACHE_SIZE) {
+		char *const pszKey = strdup((char*) pThis->pszSessKey);
+		if(pszKey == NULL) {
+			MUTEX_UNLOCK(mutClntSessCache);
+			return 0;
+		}
+		i = clntSessCacheNext;
+		clntSessCacheNext = (clntSessCacheNext + 1) % OSSL_CLNT_SESS_CACHE_SIZE;
+		free(clntSessCache[i].pszKey);
+		clntSessCache[i].pszKey = pszKey;
+	}
+	if(clntSessCache[i].sess != NULL)
+		SSL_SESSION_free(clntSessCache[i].sess);
+	clntSessCache[i].sess = sess;
+	MUTEX_UNLOCK(mutClntSessCache);
+
+	pThis->iTicketPeek = 0;
+	DBGPRINTF("nsd_ossl: stored session for %s\n", pThis->pszSessKey);
+	return 1;
+}
+
+/* offer a cached session (if we have one) for the next client handshake */
+static void
+osslSetClntSess(nsd_ossl_t *const pThis)
+{
+	SSL_SESSION *sess;
+
+	MUTEX_LOCK(mutClntSessCache);
+	for(int i = 0 ; i < OSSL_CLNT_SESS_CACHE_SIZE ; ++i) {
+		if(   clntSessCache[i].pszKey == NULL
+		   || strcmp(clntSessCache[i].pszKey, (char*) pThis->pszSessKey))
+			continue;
+		sess = clntSessCache[i].sess;
+		if((time_t) (SSL_SESSION_get_time(sess) + SSL_SESSION_get_timeout(sess)) > time(NULL)) {
+			SSL_set_session(pThis->ssl, sess);
+			DBGPRINTF("nsd_ossl: trying to resume session for %s\n", pThis->pszSessKey);
+		}
+		break;
+	}
+	MUTEX_UNLOCK(mutClntSessCache);
+}
+
+/* With TLS 1.3, the server sends session tickets after the handshake. The
+ * client only processes them when reading, which our senders never do. So
+ * we peek (non-blocking) into the connection a couple of times after the
+ * handshake, until we got a ticket.
+ */
+static void
+osslPickupTicket(nsd_ossl_t *const pThis)
+{
+	char c;
+
+	--pThis->iTicketPeek;
+	if(SSL_peek(pThis->ssl, &c, 1) <= 0)
+		ERR_clear_error();
+}
+
+static void
+osslClntSessCacheExit(void)
+{
+	for(int i = 0 ; i < OSSL_CLNT_SESS_CACHE_SIZE ; ++i) {
+		free(clntSessCache[i].pszKey);
+		clntSessCache[i].pszKey = NULL;
+		if(clntSessCache[i].sess != NULL) {
+			SSL_SESSION_free(clntSessCache[i].sess);
+			clntSessCache[i].sess = NULL;
+		}
+	}
+	OPENSSL_cleanse(ticketKeys, sizeof(ticketKeys));
+	nTicketKeys = 0;
+}
+
+/* ---------------------------- end session resumption ---------------------------- */
+
+
 /* globally initialize OpenSSL  */
 static rsRetVal
 osslGlblInit(void)
@@ -492,11 +742,29 @@ osslGlblInit(void)
 	SSL_CTX_set_options(ctx, SSL_OP_NO_SSLv2);		/* Disable insecure SSLv2 Protocol */
 	SSL_CTX_set_options(ctx, SSL_OP_NO_SSLv3);		/* Disable insecure SSLv3 Protocol */
 	SSL_CTX_sess_set_cache_size(ctx,1024);			/* TODO: make configurable? */
+	/* required for resumption of sessions with client certificate checks */
+	SSL_CTX_set_session_id_context(ctx, (const unsigned char*) "rsyslog", sizeof("rsyslog") - 1);
 
 	/* Set default VERIFY Options for OpenSSL CTX - and CALLBACK */
 	SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, verify_callback);
 
-	SSL_CTX_set_timeout(ctx, 30);	/* Default Session Timeout, TODO: Make configureable */
+	/* session resumption: server side cache and tickets, client side via our own cache */
+	if(glblTlsSessLifetime > 0) {
+		SSL_CTX_set_timeout(ctx, glblTlsSessLifetime);
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_BOTH);
+		SSL_CTX_sess_set_new_cb(ctx, osslNewSessCb);
+		#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+		SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, osslTicketKeyCb);
+		#else
+		SSL_CTX_set_tlsext_ticket_key_cb(ctx, osslTicketKeyCb);
+		#endif
+		#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+		SSL_CTX_set_num_tickets(ctx, 1);
+		#endif
+	} else {
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+		SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+	}
 	SSL_CTX_set_mode(ctx, SSL_MODE_AUTO_RETRY);
 
 	bGlblSrvrInitDone = 1;
@@ -617,6 +885,21 @@ finalize_it:
 	RETiRet;
 }
 
+/* Ask OpenSSL to move record processing to the kernel (kTLS) once the
+ * handshake is done. OpenSSL silently keeps doing it in userspace if the
+ * kernel, the negotiated cipher or the BIO does not support this, so no
+ * error handling is needed here.
+ */
+static void
+osslSetKTLS(nsd_ossl_t *pThis)
+{
+	if(!pThis->bKTLS)
+		return;
+#ifdef SSL_OP_ENABLE_KTLS
+	SSL_set_options(pThis->ssl, SSL_OP_ENABLE_KTLS);
+#endif
+}
+
 static rsRetVal
 osslInitSession(nsd_ossl_t *pThis) /* , nsd_ossl_t *pServer) */
 {
@@ -629,7 +912,9 @@ osslInitSession(nsd_ossl_t *pThis) /* , nsd_ossl_t *pServer) */
 	if(!(pThis->ssl = SSL_new(ctx))) {
 		pThis->ssl = NULL;
 		osslLastSSLErrorMsg(0, pThis->ssl, LOG_ERR, "osslInitSession");
+		ABORT_FINALIZE(RS_RET_NO_ERRCODE);
 	}
+	osslSetKTLS(pThis);
 
 	if (pThis->authMode != OSSL_AUTH_CERTANON) {
 		dbgprintf("osslInitSession: enable certificate checking (Mode=%d)\n", pThis->authMode);
@@ -975,6 +1260,7 @@ osslGlblExit(void)
 {
 	DEFiRet;
 	DBGPRINTF("openssl: entering osslGlblExit\n");
+	osslClntSessCacheExit();
 	ENGINE_cleanup();
 	ERR_free_strings();
 	EVP_cleanup();
@@ -1056,6 +1342,7 @@ CODESTARTobjDestruct(nsd_ossl)
 	if(pThis->pszConnectHost != NULL) {
 		free(pThis->pszConnectHost);
 	}
+	free(pThis->pszSessKey);
 
 	if(pThis->pszRcvBuf != NULL) {
 		free(pThis->pszRcvBuf);
@@ -1375,6 +1662,35 @@ osslPostHandshakeCheck(nsd_ossl_t *pNsd)
 		dbgprintf("osslPostHandshakeCheck: Debug Version: %s Name: %s\n",
 			SSL_CIPHER_get_version(sslCipher), SSL_CIPHER_get_name(sslCipher));
 
+	if(!pNsd->bHandshakeDone) {
+		pNsd->bHandshakeDone = 1;
+		if(SSL_session_reused(pNsd->ssl)) {
+			STATSCOUNTER_INC(ctrHandshakeResumed, mutCtrHandshakeResumed);
+		} else {
+			STATSCOUNTER_INC(ctrHandshakeFull, mutCtrHandshakeFull);
+		}
+		#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+		if(pNsd->pszSessKey != NULL && SSL_version(pNsd->ssl) == TLS1_3_VERSION)
+			pNsd->iTicketPeek = OSSL_TICKET_PEEK_TRIES;
+		#endif
+	}
+#ifdef SSL_OP_ENABLE_KTLS
+	if(pNsd->bKTLS) {
+		static int bReported = 0;
+		const int ktlsSend = BIO_get_ktls_send(SSL_get_wbio(pNsd->ssl));
+		const int ktlsRecv = BIO_get_ktls_recv(SSL_get_rbio(pNsd->ssl));
+		dbgprintf("osslPostHandshakeCheck: kTLS recv %s, send %s\n",
+			ktlsRecv ? "on" : "off", ktlsSend ? "on" : "off");
+		if(!(ktlsSend && ktlsRecv) && !bReported) {
+			bReported = 1;
+			LogMsg(0, NO_ERRCODE, LOG_INFO, "nsd_ossl: kernel TLS offload requested, but not "
+				"active for this session - using userspace TLS. Check that the tls kernel "
+				"module is loaded, the cipher is supported by it and OpenSSL was built "
+				"with ktls support. This message is only emitted once.");
+		}
+	}
+#endif
+
 	FINALIZE;
 
 finalize_it:
@@ -1480,6 +1796,7 @@ AcceptConnReq(nsd_t *pNsd, nsd_t **ppNew)
 	pNew->authMode = pThis->authMode;
 	pNew->permitExpiredCerts = pThis->permitExpiredCerts;
 	pNew->pPermPeers = pThis->pPermPeers;
+	pNew->bKTLS = pThis->bKTLS;
 	CHKiRet(osslInitSession(pNew));
 
 	/* Store nsd_ossl_t* reference in SSL obj */
@@ -1644,6 +1961,11 @@ Send(nsd_t *pNsd, uchar *pBuf, ssize_t *pLenBuf)
 		iSent = SSL_write(pThis->ssl, pBuf, *pLenBuf);
 		if(iSent > 0) {
 			*pLenBuf = iSent;
+			/* the handshake may have been completed by SSL_write() */
+			if(!pThis->bHandshakeDone)
+				CHKiRet(osslPostHandshakeCheck(pThis));
+			if(pThis->iTicketPeek > 0)
+				osslPickupTicket(pThis);
 			break;
 		} else {
 			err = SSL_get_error(pThis->ssl, iSent);
@@ -1718,6 +2040,7 @@ Connect(nsd_t *pNsd, int family, uchar *port, uchar *host, char *device)
 		osslLastSSLErrorMsg(0, pThis->ssl, LOG_ERR, "Connect");
 		ABORT_FINALIZE(RS_RET_NO_ERRCODE);
 	}
+	osslSetKTLS(pThis);
 
 	if (pThis->authMode != OSSL_AUTH_CERTANON) {
 		dbgprintf("Connect: enable certificate checking (Mode=%d)\n", pThis->authMode);
@@ -1758,6 +2081,14 @@ BIO_set_nbio( conn, 1 );
 	/* Store nsd_ossl_t* reference in SSL obj */
 	SSL_set_ex_data(pThis->ssl, 0, pThis);
 
+	/* try to resume a previous session with this server */
+	if(glblTlsSessLifetime > 0) {
+		free(pThis->pszSessKey);
+		CHKmalloc(pThis->pszSessKey = malloc(strlen((char*)host) + strlen((char*)port) + 2));
+		sprintf((char*)pThis->pszSessKey, "%s:%s", host, port);
+		osslSetClntSess(pThis);
+	}
+
 	/* We now do the handshake */
 	iRet = osslHandshakeCheck(pThis);
 finalize_it:
@@ -1906,6 +2237,39 @@ finalize_it:
 	RETiRet;
 }
 
+/* Set whether kernel TLS (kTLS) offload is requested
+ * 0 - records are always en-/decrypted by OpenSSL in userspace
+ * 1 - use kTLS if possible, otherwise silently fall back to userspace
+ */
+static rsRetVal
+SetKTLS(nsd_t *pNsd, int bKTLS)
+{
+	DEFiRet;
+	nsd_ossl_t *pThis = (nsd_ossl_t*) pNsd;
+
+	ISOBJ_TYPE_assert((pThis), nsd_ossl);
+	if(bKTLS != 0 && bKTLS != 1) {
+		LogError(0, RS_RET_VALUE_NOT_SUPPORTED, "error: driver ktls %d "
+				"not supported by ossl netstream driver", bKTLS);
+		ABORT_FINALIZE(RS_RET_VALUE_NOT_SUPPORTED);
+	}
+#	ifndef SSL_OP_ENABLE_KTLS
+	if(bKTLS) {
+		static int bWarned = 0;
+		if(!bWarned) {
+			bWarned = 1;
+			LogMsg(0, RS_RET_VALUE_NOT_SUPPORTED, LOG_WARNING, "nsd_ossl: kernel TLS offload "
+				"requested, but OpenSSL version does not support it - using userspace TLS");
+		}
+	}
+#	endif
+
+	pThis->bKTLS = bKTLS;
+
+finalize_it:
+	RETiRet;
+}
+
 /* queryInterface function */
 BEGINobjQueryInterface(nsd_ossl)
 CODESTARTobjQueryInterface(nsd_ossl)
@@ -1942,6 +2306,7 @@ CODESTARTobjQueryInterface(nsd_ossl)
 	pIf->SetGnutlsPriorityString = SetGnutlsPriorityString; /* we don't NEED this interface! */
 	pIf->SetCheckExtendedKeyUsage = SetCheckExtendedKeyUsage; /* we don't NEED this interface! */
 	pIf->SetPrioritizeSAN = SetPrioritizeSAN; /* we don't NEED this interface! */
+	pIf->SetKTLS = SetKTLS;
 
 finalize_it:
 ENDobjQueryInterface(nsd_ossl)
@@ -1953,7 +2318,10 @@ BEGINObjClassExit(nsd_ossl, OBJ_IS_LOADABLE_MODULE) /* CHANGE class also in END
 CODESTARTObjClassExit(nsd_ossl)
 	osslGlblExit();	/* shut down OpenSSL */
 
+	statsobj.Destruct(&osslStats);
+
 	/* release objects we no longer need */
+	objRelease(statsobj, CORE_COMPONENT);
 	objRelease(nsd_ptcp, LM_NSD_PTCP_FILENAME);
 	objRelease(net, LM_NET_FILENAME);
 	objRelease(glbl, CORE_COMPONENT);
@@ -1970,6 +2338,19 @@ BEGINObjClassInit(nsd_ossl, 1, OBJ_IS_LOADABLE_MODULE) /* class, version */
 	CHKiRet(objUse(glbl, CORE_COMPONENT));
 	CHKiRet(objUse(net, LM_NET_FILENAME));
 	CHKiRet(objUse(nsd_ptcp, LM_NSD_PTCP_FILENAME));
+	CHKiRet(objUse(statsobj, CORE_COMPONENT));
+
+	/* handshake statistics */
+	CHKiRet(statsobj.Construct(&osslStats));
+	CHKiRet(statsobj.SetName(osslStats, (uchar *)"nsd_ossl"));
+	CHKiRet(statsobj.SetOrigin(osslStats, (uchar *)"nsd_ossl"));
+	STATSCOUNTER_INIT(ctrHandshakeFull, mutCtrHandshakeFull);
+	CHKiRet(statsobj.AddCounter(osslStats, (uchar *)"handshakes.full",
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ctrHandshakeFull));
+	STATSCOUNTER_INIT(ctrHandshakeResumed, mutCtrHandshakeResumed);
+	CHKiRet(statsobj.AddCounter(osslStats, (uchar *)"handshakes.resumed",
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ctrHandshakeResumed));
+	CHKiRet(statsobj.ConstructFinalize(osslStats));
 
 	/* now do global TLS init stuff */
 	CHKiRet(osslGlblInit());
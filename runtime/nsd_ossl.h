@@ -63,6 +63,10 @@ struct nsd_ossl_s {
 	osslRtryCall_t rtryCall;/**< what must we retry? */
 	int rtryOsslErr;	/**< store ssl error code into like SSL_ERROR_WANT_READ or SSL_ERROR_WANT_WRITE */
 	int bIsInitiator;	/**< 0 if socket is the server end (listener), 1 if it is the initiator */
+	int bKTLS;		/**< 1 if kernel TLS offload is requested */
+	int bHandshakeDone;	/**< 1 if post-handshake processing has been done */
+	uchar *pszSessKey;	/**< client only: "host:port" key for the session cache */
+	int iTicketPeek;	/**< client only: remaining tries to pick up a TLS 1.3 session ticket */
 	int bHaveSess;		/* as we don't know exactly which gnutls_session values
 					are invalid, we use this one to flag whether or
 					not we are in a session (same as -1 for a socket
@@ -182,6 +182,20 @@ finalize_it:
 	RETiRet;
 }
 
+/* Set kernel TLS offload, not supported in ptcp (there is no TLS). */
+static rsRetVal
+SetKTLS(nsd_t __attribute__((unused)) *pNsd, int bKTLS)
+{
+	DEFiRet;
+	if(bKTLS != 0) {
+		LogError(0, RS_RET_VALUE_NOT_SUPPORTED, "error: driver ktls %d "
+				"not supported by ptcp netstream driver", bKTLS);
+		ABORT_FINALIZE(RS_RET_VALUE_NOT_SUPPORTED);
+	}
+finalize_it:
+	RETiRet;
+}
+
 /* Set the authentication mode. For us, the following is supported:
  * anon - no certificate checks whatsoever (discouraged, but supported)
  * mode == NULL is valid and defaults to anon
@@ -646,6 +660,7 @@ LstnInit(netstrms_t *pNS, void *pUsr, rsRetVal(*fAddLstn)(void*,netstrm_t*),
 		CHKiRet(pNS->Drvr.SetMode(pNewNsd, netstrms.GetDrvrMode(pNS)));
 		CHKiRet(pNS->Drvr.SetCheckExtendedKeyUsage(pNewNsd, netstrms.GetDrvrCheckExtendedKeyUsage(pNS)));
 		CHKiRet(pNS->Drvr.SetPrioritizeSAN(pNewNsd, netstrms.GetDrvrPrioritizeSAN(pNS)));
+		CHKiRet(pNS->Drvr.SetKTLS(pNewNsd, netstrms.GetDrvrKTLS(pNS)));
 		CHKiRet(pNS->Drvr.SetAuthMode(pNewNsd, netstrms.GetDrvrAuthMode(pNS)));
 		CHKiRet(pNS->Drvr.SetPermitExpiredCerts(pNewNsd, netstrms.GetDrvrPermitExpiredCerts(pNS)));
 		CHKiRet(pNS->Drvr.SetPermPeers(pNewNsd, netstrms.GetDrvrPermPeers(pNS)));
@@ -998,6 +1013,7 @@ CODESTARTobjQueryInterface(nsd_ptcp)
 	pIf->SetKeepAliveTime = SetKeepAliveTime;
 	pIf->SetCheckExtendedKeyUsage = SetCheckExtendedKeyUsage;
 	pIf->SetPrioritizeSAN = SetPrioritizeSAN;
+	pIf->SetKTLS = SetKTLS;
 finalize_it:
 ENDobjQueryInterface(nsd_ptcp)
 
@@ -152,6 +152,7 @@ doRetry(nsd_gtls_t *pNsd)
 			gnuRet = gnutls_handshake(pNsd->sess);
 			if(gnuRet == 0) {
 				pNsd->rtryCall = gtlsRtry_None; /* we are done */
+				gtlsPostHandshake(pNsd);
 				/* we got a handshake, now check authorization */
 				CHKiRet(gtlsChkPeerAuth(pNsd));
 			}
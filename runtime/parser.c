@@ -29,7 +29,10 @@
 #include <ctype.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
 #include <zlib.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
 
 #include "rsyslog.h"
 #include "dirty.h"
@@ -42,6 +45,9 @@
 #include "unicode-helper.h"
 #include "dirty.h"
 #include "cfsysline.h"
+#include "glbl.h"
+#include "prop.h"
+#include "hashtable.h"
 
 /* some defines */
 #define DEFUPRI		(LOG_USER|LOG_NOTICE)
@@ -51,6 +57,7 @@ DEFobjStaticHelpers
 DEFobjCurrIf(glbl)
 DEFobjCurrIf(datetime)
 DEFobjCurrIf(ruleset)
+DEFobjCurrIf(statsobj)
 
 /* static data */
 
@@ -68,6 +75,32 @@ parserList_t *pParsLstRoot = NULL;
  */
 parserList_t *pDfltParsLst = NULL;
 
+/* The parser dispatch cache (global parser.dispatchCache="on") remembers, per
+ * input name and sender IP, which parser of the list last accepted a message.
+ * That parser is tried first, and only if it fails do we walk the configured
+ * list. Note that this changes semantics if an earlier parser in the list
+ * would also have accepted the message - which is why it is off by default.
+ * It is only used for parsers which, when tried first, leave every
+ * parser of the list with the same sanitization and PRI parsing state the
+ * configured order would have left it in (see dispCacheUsable()).
+ */
+#define DISPCACHE_TAB_SIZE 1024
+#define DISPCACHE_MAX_ETRIES 16384	/* cache is flushed when this is reached */
+#define DISPCACHE_MAX_KEYLEN 512
+typedef struct dispCacheKey_s {
+	int len;
+	uchar data[];
+} dispCacheKey_t;
+typedef struct dispCacheEtry_s {
+	parserList_t *pList;	/* list the parser was found in */
+	parser_t *pParser;	/* parser that last succeeded */
+} dispCacheEtry_t;
+static struct hashtable *dispCache = NULL;
+static pthread_rwlock_t dispCacheLock = PTHREAD_RWLOCK_INITIALIZER;
+static statsobj_t *dispCacheStats = NULL;
+STATSCOUNTER_DEF(ctrDispCacheHits, mutCtrDispCacheHits)
+STATSCOUNTER_DEF(ctrDispCacheMisses, mutCtrDispCacheMisses)
+
 
 /* intialize (but NOT allocate) a parser list. Primarily meant as a hook
  * which can be used to extend the list in the future. So far, just sets
@@ -251,6 +284,16 @@ static rsRetVal parserConstructFinalize(parser_t *pThis)
 	DEFiRet;
 
 	ISOBJ_TYPE_assert(pThis, parser);
+	CHKiRet(statsobj.Construct(&pThis->stats));
+	CHKiRet(statsobj.SetName(pThis->stats, pThis->pName));
+	CHKiRet(statsobj.SetOrigin(pThis->stats, UCHAR_CONSTANT("core.parser")));
+	STATSCOUNTER_INIT(pThis->ctrAttempts, pThis->mutCtrAttempts);
+	CHKiRet(statsobj.AddCounter(pThis->stats, UCHAR_CONSTANT("attempts"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &pThis->ctrAttempts));
+	STATSCOUNTER_INIT(pThis->ctrHits, pThis->mutCtrHits);
+	CHKiRet(statsobj.AddCounter(pThis->stats, UCHAR_CONSTANT("hits"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &pThis->ctrHits));
+	CHKiRet(statsobj.ConstructFinalize(pThis->stats));
 	CHKiRet(AddParserToList(&pParsLstRoot, pThis));
 	DBGPRINTF("Parser '%s' added to list of available parsers.\n", pThis->pName);
 
@@ -290,8 +333,12 @@ parserConstructViaModAndName(modInfo_t *__restrict__ pMod, uchar *const __restri
 	pParser->pInst = pInst;
 	CHKiRet(parserConstructFinalize(pParser));
 finalize_it:
-	if(iRet != RS_RET_OK)
+	if(iRet != RS_RET_OK && pParser != NULL) {
+		if(pParser->stats != NULL)
+			statsobj.Destruct(&pParser->stats);
+		free(pParser->pName);
 		free(pParser);
+	}
 	RETiRet;
 }
 BEGINobjDestruct(parser) /* be sure to specify the object type also in END and CODESTART macros! */
@@ -300,6 +347,8 @@ CODESTARTobjDestruct(parser)
 	if(pThis->pInst != NULL) {
 		pThis->pModule->mod.pm.freeParserInst(pThis->pInst);
 	}
+	if(pThis->stats != NULL)
+		statsobj.Destruct(&pThis->stats);
 	free(pThis->pName);
 ENDobjDestruct(parser)
 
@@ -608,6 +657,217 @@ ParsePRI(smsg_t *pMsg)
 }
 
 
+/* --- parser dispatch cache --- */
+
+static unsigned int
+dispCacheHash(void *k)
+{
+	const dispCacheKey_t *const key = (dispCacheKey_t*) k;
+	unsigned int hash = 2166136261u; /* FNV-1a */
+	int i;
+
+	for(i = 0 ; i < key->len ; ++i) {
+		hash ^= key->data[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static int
+dispCacheKeyEq(void *k1, void *k2)
+{
+	const dispCacheKey_t *const key1 = (dispCacheKey_t*) k1;
+	const dispCacheKey_t *const key2 = (dispCacheKey_t*) k2;
+	return key1->len == key2->len && !memcmp(key1->data, key2->data, key1->len);
+}
+
+
+/* build the cache key (input name plus sender IP) for a message. Returns
+ * 0 on success and -1 if no key can be built. Note that we must not
+ * trigger DNS resolution here, so for not yet resolved senders we use
+ * the raw address.
+ */
+static int
+dispCacheBuildKey(smsg_t *const pMsg, dispCacheKey_t *const key)
+{
+	uchar *psz;
+	int len;
+	const void *addr = NULL;
+	int lenAddr = 0;
+
+	getInputName(pMsg, &psz, &len);
+	if(pMsg->pRcvFromIP != NULL) {
+		addr = propGetSzStr(pMsg->pRcvFromIP);
+		lenAddr = pMsg->pRcvFromIP->len;
+	} else if((pMsg->msgFlags & NEEDS_DNSRESOL) && pMsg->rcvFrom.pfrominet != NULL) {
+		const struct sockaddr_storage *const sa = pMsg->rcvFrom.pfrominet;
+		if(sa->ss_family == AF_INET) {
+			addr = &((const struct sockaddr_in*) sa)->sin_addr;
+			lenAddr = sizeof(struct in_addr);
+		} else if(sa->ss_family == AF_INET6) {
+			addr = &((const struct sockaddr_in6*) sa)->sin6_addr;
+			lenAddr = sizeof(struct in6_addr);
+		}
+	}
+	/* else local message without sender - key is input name only */
+
+	if(len + 1 + lenAddr > DISPCACHE_MAX_KEYLEN)
+		return -1;
+	memcpy(key->data, psz, len);
+	key->data[len] = '\0'; /* separator */
+	if(lenAddr > 0)
+		memcpy(key->data + len + 1, addr, lenAddr);
+	key->len = len + 1 + lenAddr;
+	return 0;
+}
+
+
+/* apply the state changes prepareMsgForParser() would do for pParser,
+ * without touching any message.
+ */
+static inline void
+dispCachePrepState(const parser_t *const pParser, sbool *const pbIsSanitized, sbool *const pbPRIisParsed)
+{
+	if(pParser->bDoSanitazion && *pbIsSanitized == RSFALSE) {
+		if(pParser->bDoPRIParsing && *pbPRIisParsed == RSFALSE)
+			*pbPRIisParsed = RSTRUE;
+		*pbIsSanitized = RSTRUE;
+	}
+}
+
+/* can pParser be tried ahead of the rest of pList? See comment at the
+ * top of this file. We simulate the sanitization/PRI state each parser
+ * would see, once in configured order and once with pParser tried first
+ * (with the rest of the list following, as on a cache miss). pParser is
+ * usable only if every parser sees the same state in both cases. Note
+ * that it is not sufficient to compare with the list head: for
+ * [A(no sanitize), B(sanitize), C(no sanitize)], C sees a sanitized
+ * message in list order, but not if it is called alone.
+ */
+static int
+dispCacheUsable(const parserList_t *const pList, const parser_t *const pParser)
+{
+	const parserList_t *pEtry;
+	sbool bSanAlone = RSFALSE, bPRIAlone = RSFALSE;
+	sbool bSanList = RSFALSE, bPRIList = RSFALSE;
+	sbool bSanCached, bPRICached;
+
+	/* state seen by pParser when it is called first */
+	dispCachePrepState(pParser, &bSanAlone, &bPRIAlone);
+	bSanCached = bSanAlone;
+	bPRICached = bPRIAlone;
+	for(pEtry = pList ; pEtry != NULL ; pEtry = pEtry->pNext) {
+		dispCachePrepState(pEtry->pParser, &bSanList, &bPRIList);
+		if(pEtry->pParser == pParser) {
+			if(bSanList != bSanAlone || bPRIList != bPRIAlone)
+				return 0;
+		} else {
+			/* on a cache miss, the others follow in list order */
+			dispCachePrepState(pEtry->pParser, &bSanCached, &bPRICached);
+			if(bSanList != bSanCached || bPRIList != bPRICached)
+				return 0;
+		}
+	}
+	return 1;
+}
+
+
+static parser_t *
+dispCacheLookup(const parserList_t *const pList, dispCacheKey_t *const key)
+{
+	dispCacheEtry_t *etry;
+	parser_t *pParser = NULL;
+
+	pthread_rwlock_rdlock(&dispCacheLock);
+	if(dispCache != NULL) {
+		etry = hashtable_search(dispCache, key);
+		if(etry != NULL && etry->pList == pList)
+			pParser = etry->pParser;
+	}
+	pthread_rwlock_unlock(&dispCacheLock);
+	return pParser;
+}
+
+
+/* remember pParser as the one that succeeded for key. Errors are
+ * ignored - in the worst case, the cache simply does not help.
+ */
+static void
+dispCacheUpdate(parserList_t *const pList, dispCacheKey_t *const key, parser_t *const pParser)
+{
+	dispCacheEtry_t *etry;
+	dispCacheKey_t *newKey = NULL;
+
+	pthread_rwlock_wrlock(&dispCacheLock);
+	if(dispCache != NULL && hashtable_count(dispCache) >= DISPCACHE_MAX_ETRIES) {
+		DBGPRINTF("parser dispatch cache full, flushing it\n");
+		hashtable_destroy(dispCache, 1);
+		dispCache = NULL;
+	}
+	if(dispCache == NULL) {
+		dispCache = create_hashtable(DISPCACHE_TAB_SIZE, dispCacheHash, dispCacheKeyEq, NULL);
+		if(dispCache == NULL)
+			goto done;
+	}
+	if((etry = hashtable_search(dispCache, key)) == NULL) {
+		if((etry = malloc(sizeof(dispCacheEtry_t))) == NULL)
+			goto done;
+		if((newKey = malloc(sizeof(dispCacheKey_t) + key->len)) == NULL) {
+			free(etry);
+			goto done;
+		}
+		memcpy(newKey, key, sizeof(dispCacheKey_t) + key->len);
+		if(hashtable_insert(dispCache, newKey, etry) == 0) {
+			free(newKey);
+			free(etry);
+			goto done;
+		}
+	}
+	etry->pList = pList;
+	etry->pParser = pParser;
+done:
+	pthread_rwlock_unlock(&dispCacheLock);
+}
+
+/* --- END parser dispatch cache --- */
+
+
+/* do the generic preprocessing a parser requests, if not already done */
+static rsRetVal
+prepareMsgForParser(smsg_t *const pMsg, const parser_t *const pParser,
+	sbool *const pbIsSanitized, sbool *const pbPRIisParsed)
+{
+	DEFiRet;
+	if(pParser->bDoSanitazion && *pbIsSanitized == RSFALSE) {
+		CHKiRet(SanitizeMsg(pMsg));
+		if(pParser->bDoPRIParsing && *pbPRIisParsed == RSFALSE) {
+			CHKiRet(ParsePRI(pMsg));
+			*pbPRIisParsed = RSTRUE;
+		}
+		*pbIsSanitized = RSTRUE;
+	}
+finalize_it:
+	RETiRet;
+}
+
+
+static rsRetVal
+callParser(parser_t *const pParser, smsg_t *const pMsg)
+{
+	rsRetVal localRet;
+
+	STATSCOUNTER_INC(pParser->ctrAttempts, pParser->mutCtrAttempts);
+	if(pParser->pModule->mod.pm.parse2 == NULL)
+		localRet = pParser->pModule->mod.pm.parse(pMsg);
+	else
+		localRet = pParser->pModule->mod.pm.parse2(pParser->pInst, pMsg);
+	DBGPRINTF("Parser '%s' returned %d\n", pParser->pName, localRet);
+	if(localRet == RS_RET_OK)
+		STATSCOUNTER_INC(pParser->ctrHits, pParser->mutCtrHits);
+	return localRet;
+}
+
+
 /* Parse a received message. The object's rawmsg property is taken and
  * parsed according to the relevant standards. This can later be
  * extended to support configured parsers.
@@ -617,10 +877,17 @@ static rsRetVal
 ParseMsg(smsg_t *pMsg)
 {
 	rsRetVal localRet = RS_RET_ERR;
+	parserList_t *pParserListRoot;
 	parserList_t *pParserList;
-	parser_t *pParser;
+	parser_t *pParser = NULL;
+	parser_t *pCached = NULL;
 	sbool bIsSanitized;
 	sbool bPRIisParsed;
+	sbool bHaveKey = RSFALSE;
+	union { /* force alignment of the key */
+		dispCacheKey_t key;
+		uchar buf[sizeof(dispCacheKey_t) + DISPCACHE_MAX_KEYLEN];
+	} cacheKey;
 	static int iErrMsgRateLimiter = 0;
 	DEFiRet;
 
@@ -641,35 +908,47 @@ ParseMsg(smsg_t *pMsg)
 	 * will cause it to happen. After that, access to the unsanitized message is no
 	 * loger possible.
 	 */
-	pParserList = ruleset.GetParserList(ourConf, pMsg);
-	if(pParserList == NULL) {
-		pParserList = pDfltParsLst;
+	pParserListRoot = ruleset.GetParserList(ourConf, pMsg);
+	if(pParserListRoot == NULL) {
+		pParserListRoot = pDfltParsLst;
 	}
-	DBGPRINTF("parse using parser list %p%s.\n", pParserList,
-		  (pParserList == pDfltParsLst) ? " (the default list)" : "");
+	DBGPRINTF("parse using parser list %p%s.\n", pParserListRoot,
+		  (pParserListRoot == pDfltParsLst) ? " (the default list)" : "");
 
 	bIsSanitized = RSFALSE;
 	bPRIisParsed = RSFALSE;
-	while(pParserList != NULL) {
-		pParser = pParserList->pParser;
-		if(pParser->bDoSanitazion && bIsSanitized == RSFALSE) {
-			CHKiRet(SanitizeMsg(pMsg));
-			if(pParser->bDoPRIParsing && bPRIisParsed == RSFALSE) {
-				CHKiRet(ParsePRI(pMsg));
-				bPRIisParsed = RSTRUE;
+
+	/* with more than one parser, first try the one that worked last time */
+	if(bParserDispatchCache && pParserListRoot != NULL && pParserListRoot->pNext != NULL
+	   && dispCacheBuildKey(pMsg, &cacheKey.key) == 0) {
+		bHaveKey = RSTRUE;
+		pCached = dispCacheLookup(pParserListRoot, &cacheKey.key);
+		if(pCached != NULL) {
+			CHKiRet(prepareMsgForParser(pMsg, pCached, &bIsSanitized, &bPRIisParsed));
+			localRet = callParser(pCached, pMsg);
+			if(localRet != RS_RET_COULD_NOT_PARSE) {
+				STATSCOUNTER_INC(ctrDispCacheHits, mutCtrDispCacheHits);
+				pParser = pCached;
+				goto parser_done;
 			}
-			bIsSanitized = RSTRUE;
 		}
-		if(pParser->pModule->mod.pm.parse2 == NULL)
-			localRet = pParser->pModule->mod.pm.parse(pMsg);
-		else
-			localRet = pParser->pModule->mod.pm.parse2(pParser->pInst, pMsg);
-		DBGPRINTF("Parser '%s' returned %d\n", pParser->pName, localRet);
+		STATSCOUNTER_INC(ctrDispCacheMisses, mutCtrDispCacheMisses);
+	}
+
+	for(pParserList = pParserListRoot ; pParserList != NULL ; pParserList = pParserList->pNext) {
+		pParser = pParserList->pParser;
+		if(pParser == pCached)
+			continue; /* already tried above */
+		CHKiRet(prepareMsgForParser(pMsg, pParser, &bIsSanitized, &bPRIisParsed));
+		localRet = callParser(pParser, pMsg);
 		if(localRet != RS_RET_COULD_NOT_PARSE)
 			break;
-		pParserList = pParserList->pNext;
 	}
 
+	if(bHaveKey && localRet == RS_RET_OK && dispCacheUsable(pParserListRoot, pParser))
+		dispCacheUpdate(pParserListRoot, &cacheKey.key, pParser);
+
+parser_done:
 	/* We need to log a warning message and drop the message if we did not find a parser.
 	 * Note that we log at most the first 1000 message, as this may very well be a problem
 	 * that causes a message generation loop. We do not synchronize that counter, it doesn't
@@ -745,6 +1024,13 @@ destroyMasterParserList(void)
 BEGINObjClassExit(parser, OBJ_IS_CORE_MODULE) /* class, version */
 	DestructParserList(&pDfltParsLst);
 	destroyMasterParserList();
+	if(dispCache != NULL) {
+		hashtable_destroy(dispCache, 1);
+		dispCache = NULL;
+	}
+	if(dispCacheStats != NULL)
+		statsobj.Destruct(&dispCacheStats);
+	objRelease(statsobj, CORE_COMPONENT);
 	objRelease(glbl, CORE_COMPONENT);
 	objRelease(datetime, CORE_COMPONENT);
 	objRelease(ruleset, CORE_COMPONENT);
@@ -760,6 +1046,18 @@ BEGINObjClassInit(parser, 1, OBJ_IS_CORE_MODULE) /* class, version */
 	CHKiRet(objUse(glbl, CORE_COMPONENT));
 	CHKiRet(objUse(datetime, CORE_COMPONENT));
 	CHKiRet(objUse(ruleset, CORE_COMPONENT));
+	CHKiRet(objUse(statsobj, CORE_COMPONENT));
+
+	CHKiRet(statsobj.Construct(&dispCacheStats));
+	CHKiRet(statsobj.SetName(dispCacheStats, UCHAR_CONSTANT("parser.dispatchcache")));
+	CHKiRet(statsobj.SetOrigin(dispCacheStats, UCHAR_CONSTANT("core.parser")));
+	STATSCOUNTER_INIT(ctrDispCacheHits, mutCtrDispCacheHits);
+	CHKiRet(statsobj.AddCounter(dispCacheStats, UCHAR_CONSTANT("hits"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ctrDispCacheHits));
+	STATSCOUNTER_INIT(ctrDispCacheMisses, mutCtrDispCacheMisses);
+	CHKiRet(statsobj.AddCounter(dispCacheStats, UCHAR_CONSTANT("misses"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &ctrDispCacheMisses));
+	CHKiRet(statsobj.ConstructFinalize(dispCacheStats));
 
 	InitParserList(&pParsLstRoot);
 	InitParserList(&pDfltParsLst);
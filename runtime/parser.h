@@ -21,6 +21,8 @@
 #ifndef INCLUDED_PARSER_H
 #define INCLUDED_PARSER_H
 
+#include "statsobj.h"
+
 /* we create a small helper object, a list of parsers, that we can use to
  * build a chain of them whereever this is needed (initially thought to be
  * used in ruleset.c as well as ourselvs).
@@ -39,6 +41,9 @@ struct parser_s {
 	void *pInst;		/* instance data for the parser (v2+ module interface) */
 	sbool bDoSanitazion;	/* do standard message sanitazion before calling parser? */
 	sbool bDoPRIParsing;	/* do standard PRI parsing before calling parser? */
+	statsobj_t *stats;	/* statistics for this parser */
+	STATSCOUNTER_DEF(ctrAttempts, mutCtrAttempts)
+	STATSCOUNTER_DEF(ctrHits, mutCtrHits)
 };
 
 /* interfaces */
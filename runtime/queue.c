@@ -1767,6 +1767,60 @@ DeleteProcessedBatch(qqueue_t *pThis, batch_t *pBatch)
 }
 
 
+/* move the current batch of a worker to its list of held batches. This is
+ * done while the consumer keeps a transaction open across dequeues (see
+ * action.linger.*). The messages must stay in the queue store until that
+ * transaction is committed, so we delay deletion. Note that we hold empty
+ * batches as well: for disk queues, any deletion would also remove the
+ * held messages from the store.
+ */
+static rsRetVal
+HoldProcessedBatch(wti_t *const pWti)
+{
+	heldBatch_t *pHeld;
+	DEFiRet;
+
+	CHKmalloc(pHeld = calloc(1, sizeof(heldBatch_t)));
+	pHeld->batch = pWti->batch;
+	iRet = batchInit(&pWti->batch, pHeld->batch.maxElem);
+	if(iRet != RS_RET_OK) {
+		batchFree(&pWti->batch);
+		pWti->batch = pHeld->batch;
+		free(pHeld);
+		FINALIZE;
+	}
+	if(pWti->pHeldLast == NULL)
+		pWti->pHeldRoot = pHeld;
+	else
+		pWti->pHeldLast->pNext = pHeld;
+	pWti->pHeldLast = pHeld;
+
+finalize_it:
+	RETiRet;
+}
+
+
+/* delete all batches held by a worker, oldest first.
+ * @returns number of elements deleted
+ */
+static int
+DeleteHeldBatches(qqueue_t *const pThis, wti_t *const pWti)
+{
+	heldBatch_t *pHeld;
+	int nDeleted = 0;
+
+	while((pHeld = pWti->pHeldRoot) != NULL) {
+		pWti->pHeldRoot = pHeld->pNext;
+		nDeleted += pHeld->batch.nElemDeq;
+		DeleteProcessedBatch(pThis, &pHeld->batch);
+		batchFree(&pHeld->batch);
+		free(pHeld);
+	}
+	pWti->pHeldLast = NULL;
+	return nDeleted;
+}
+
+
 /* dequeue as many user pointers as are available, until we hit the configured
  * upper limit of pointers. Note that this function also deletes all processed
  * objects from the previous batch. However, it is perfectly valid that the
@@ -1791,7 +1845,12 @@ DequeueConsumableElements(qqueue_t *const pThis, wti_t *const pWti,
 	DEFiRet;
 
 	nDeleted = pWti->batch.nElemDeq;
-	DeleteProcessedBatch(pThis, &pWti->batch);
+	if(pWti->bBatchHold && HoldProcessedBatch(pWti) == RS_RET_OK) {
+		nDeleted = 0;
+	} else {
+		nDeleted += DeleteHeldBatches(pThis, pWti);
+		DeleteProcessedBatch(pThis, &pWti->batch);
+	}
 
 	nDequeued = nDiscarded = 0;
 	if(pThis->qType == QUEUETYPE_DISK) {
@@ -2085,6 +2144,7 @@ batchProcessed(qqueue_t *pThis, wti_t *pWti)
 	int iCancelStateSave;
 	/* at this spot, we must not be cancelled */
 	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &iCancelStateSave);
+	DeleteHeldBatches(pThis, pWti);
 	DeleteProcessedBatch(pThis, &pWti->batch);
 	qqueueChkPersist(pThis, pWti->batch.nElemDeq);
 	pthread_setcancelstate(iCancelStateSave, NULL);
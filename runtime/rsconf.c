@@ -1347,6 +1347,8 @@ ourConf = loadConf; // TODO: remove, once ourConf is gone!
 
 	CHKiRet(tellCoreConfigLoadDone());
 	tellModulesConfigLoadDone();
+	if(glblRulesetProfiling)
+		CHKiRet(rulesetSetupProfilingAll(loadConf));
 
 	tellModulesCheckConfig();
 	CHKiRet(validateConf());
@@ -31,8 +31,12 @@
  */
 #include "config.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include <ctype.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
 
 #include "rsyslog.h"
 #include "obj.h"
@@ -49,17 +53,54 @@
 #include "srUtils.h"
 #include "modules.h"
 #include "wti.h"
+#include "statsobj.h"
+#include "glbl.h"
 #include "dirty.h" /* for main ruleset queue creation */
 
 
 /* static data */
 DEFobjStaticHelpers
 DEFobjCurrIf(parser)
+DEFobjCurrIf(statsobj)
+
+/* profiling data for a single statement. Execution time is only
+ * measured for every (STMT_PROF_SAMPLE_MASK+1)th statement a worker
+ * executes and then scaled up, so the counter is an estimate.
+ */
+struct cnfstmtprof {
+	statsobj_t *stats;
+	STATSCOUNTER_DEF(ctrExecuted, mutCtrExecuted)
+	STATSCOUNTER_DEF(ctrTaken, mutCtrTaken)
+	STATSCOUNTER_DEF(ctrTimeNs, mutCtrTimeNs)
+};
+#define STMT_PROF_SAMPLE_MASK 0x0f
+
+/* helper pool for committing the direct-mode actions of a batch in
+ * parallel. Only one set of jobs is processed at a time. If another
+ * worker of the same ruleset finds the pool busy, it simply commits
+ * sequentially as usual.
+ */
+struct rsCommitPool_s {
+	pthread_mutex_t mut;
+	pthread_cond_t condWork;	/* new jobs available or shutdown requested */
+	pthread_cond_t condDone;	/* all jobs of the current set are done */
+	pthread_t *tids;
+	int nThrds;			/* configured number of helper threads */
+	int nRunning;			/* number of helper threads actually started */
+	sbool bBusy;			/* a job set is currently being processed */
+	sbool bShutdown;
+	wti_t *pWti;			/* worker whose actions are to be committed */
+	action_t **actions;		/* actions with pending transactions */
+	int nJobs;
+	int nextJob;
+	int nDone;
+};
 
 /* tables for interfacing with the v6 config system (as far as we need to) */
 static struct cnfparamdescr rspdescr[] = {
 	{ "name", eCmdHdlrString, CNFPARAM_REQUIRED },
-	{ "parser", eCmdHdlrArray, 0 }
+	{ "parser", eCmdHdlrArray, 0 },
+	{ "parallelactions", eCmdHdlrNonNegInt, 0 }
 };
 static struct cnfparamblk rspblk =
 	{ CNFPARAMBLK_VERSION,
@@ -309,6 +350,8 @@ execIf(struct cnfstmt *const stmt, smsg_t *const pMsg, wti_t *const pWti)
 	bRet = cnfexprEvalBool(stmt->d.s_if.expr, pMsg, pWti);
 	DBGPRINTF("if condition result is %d\n", bRet);
 	if(bRet) {
+		if(stmt->prof != NULL)
+			STATSCOUNTER_INC(stmt->prof->ctrTaken, stmt->prof->mutCtrTaken);
 		if(stmt->d.s_if.t_then != NULL)
 			CHKiRet(scriptExec(stmt->d.s_if.t_then, pMsg, pWti));
 	} else {
@@ -326,6 +369,7 @@ invokeForeachBodyWith(struct cnfstmt *stmt, json_object *o, smsg_t *pMsg, wti_t
 	v.d.json = o;
 	DEFiRet;
 	CHKiRet(msgSetJSONFromVar(pMsg, (uchar*)stmt->d.s_foreach.iter->var, &v, 1));
+	wtiInvalidateExprCache(pWti);
 	CHKiRet(scriptExec(stmt->d.s_foreach.body, pMsg, pWti));
 finalize_it:
 	RETiRet;
@@ -431,6 +475,8 @@ execPRIFILT(struct cnfstmt *stmt, smsg_t *pMsg, wti_t *pWti)
 
 	DBGPRINTF("PRIFILT condition result is %d\n", bRet);
 	if(bRet) {
+		if(stmt->prof != NULL)
+			STATSCOUNTER_INC(stmt->prof->ctrTaken, stmt->prof->mutCtrTaken);
 		if(stmt->d.s_prifilt.t_then != NULL)
 			CHKiRet(scriptExec(stmt->d.s_prifilt.t_then, pMsg, pWti));
 	} else {
@@ -542,8 +588,11 @@ execPROPFILT(struct cnfstmt *stmt, smsg_t *pMsg, wti_t *pWti)
 
 	bRet = evalPROPFILT(stmt, pMsg);
 	DBGPRINTF("PROPFILT condition result is %d\n", bRet);
-	if(bRet)
+	if(bRet) {
+		if(stmt->prof != NULL)
+			STATSCOUNTER_INC(stmt->prof->ctrTaken, stmt->prof->mutCtrTaken);
 		CHKiRet(scriptExec(stmt->d.s_propfilt.t_then, pMsg, pWti));
+	}
 finalize_it:
 	RETiRet;
 }
@@ -568,6 +617,91 @@ finalize_it:
 	RETiRet;
 }
 
+/* execute a single statement */
+static rsRetVal ATTR_NONNULL()
+execStmt(struct cnfstmt *const stmt, smsg_t *const pMsg, wti_t *const pWti)
+{
+	DEFiRet;
+
+	switch(stmt->nodetype) {
+	case S_NOP:
+		break;
+	case S_STOP:
+		ABORT_FINALIZE(RS_RET_DISCARDMSG);
+		break;
+	case S_ACT:
+		CHKiRet(execAct(stmt, pMsg, pWti));
+		wtiInvalidateExprCache(pWti);
+		break;
+	case S_SET:
+		CHKiRet(execSet(stmt, pMsg, pWti));
+		wtiInvalidateExprCache(pWti);
+		break;
+	case S_UNSET:
+		CHKiRet(execUnset(stmt, pMsg));
+		wtiInvalidateExprCache(pWti);
+		break;
+	case S_CALL:
+		CHKiRet(execCall(stmt, pMsg, pWti));
+		break;
+	case S_CALL_INDIRECT:
+		CHKiRet(execCallIndirect(stmt, pMsg, pWti));
+		break;
+	case S_IF:
+		CHKiRet(execIf(stmt, pMsg, pWti));
+		break;
+	case S_FOREACH:
+		CHKiRet(execForeach(stmt, pMsg, pWti));
+		wtiInvalidateExprCache(pWti);
+		break;
+	case S_PRIFILT:
+		CHKiRet(execPRIFILT(stmt, pMsg, pWti));
+		break;
+	case S_PROPFILT:
+		CHKiRet(execPROPFILT(stmt, pMsg, pWti));
+		break;
+	case S_RELOAD_LOOKUP_TABLE:
+		CHKiRet(execReloadLookupTable(stmt));
+		wtiInvalidateExprCache(pWti);
+		break;
+	default:
+		dbgprintf("error: unknown stmt type %u during exec\n",
+			(unsigned) stmt->nodetype);
+		break;
+	}
+finalize_it:
+	RETiRet;
+}
+
+/* execute a single statement with profiling. Execution time is
+ * measured for a sample of executions only, as obtaining the time
+ * is much more expensive than the rest of the profiling.
+ */
+static rsRetVal ATTR_NONNULL()
+execStmtProfiled(struct cnfstmt *const stmt, smsg_t *const pMsg, wti_t *const pWti)
+{
+	struct cnfstmtprof *const prof = stmt->prof;
+	struct timespec tBegin, tEnd;
+	int64_t ns;
+	DEFiRet;
+
+	STATSCOUNTER_INC(prof->ctrExecuted, prof->mutCtrExecuted);
+	if((pWti->execState.profSampleCtr++ & STMT_PROF_SAMPLE_MASK) != 0) {
+		iRet = execStmt(stmt, pMsg, pWti);
+	} else {
+		clock_gettime(CLOCK_MONOTONIC, &tBegin);
+		iRet = execStmt(stmt, pMsg, pWti);
+		clock_gettime(CLOCK_MONOTONIC, &tEnd);
+		ns = (int64_t) (tEnd.tv_sec - tBegin.tv_sec) * 1000000000
+			+ (tEnd.tv_nsec - tBegin.tv_nsec);
+		if(ns > 0) {
+			STATSCOUNTER_ADD(prof->ctrTimeNs, prof->mutCtrTimeNs,
+				ns * (STMT_PROF_SAMPLE_MASK + 1));
+		}
+	}
+	RETiRet;
+}
+
 /* The rainerscript execution engine. It is debatable if that would be better
  * contained in grammer/rainerscript.c, HOWEVER, that file focusses primarily
  * on the parsing and object creation part. So as an actual executor, it is
@@ -589,52 +723,211 @@ scriptExec(struct cnfstmt *const root, smsg_t *const pMsg, wti_t *const pWti)
 		if(Debug) {
 			cnfstmtPrintOnly(stmt, 2, 0);
 		}
-		switch(stmt->nodetype) {
-		case S_NOP:
-			break;
-		case S_STOP:
-			ABORT_FINALIZE(RS_RET_DISCARDMSG);
-			break;
-		case S_ACT:
-			CHKiRet(execAct(stmt, pMsg, pWti));
-			break;
-		case S_SET:
-			CHKiRet(execSet(stmt, pMsg, pWti));
-			break;
-		case S_UNSET:
-			CHKiRet(execUnset(stmt, pMsg));
-			break;
-		case S_CALL:
-			CHKiRet(execCall(stmt, pMsg, pWti));
-			break;
-		case S_CALL_INDIRECT:
-			CHKiRet(execCallIndirect(stmt, pMsg, pWti));
-			break;
-		case S_IF:
-			CHKiRet(execIf(stmt, pMsg, pWti));
-			break;
-		case S_FOREACH:
-			CHKiRet(execForeach(stmt, pMsg, pWti));
-			break;
-		case S_PRIFILT:
-			CHKiRet(execPRIFILT(stmt, pMsg, pWti));
-			break;
-		case S_PROPFILT:
-			CHKiRet(execPROPFILT(stmt, pMsg, pWti));
-			break;
-		case S_RELOAD_LOOKUP_TABLE:
-			CHKiRet(execReloadLookupTable(stmt));
+		if(stmt->prof == NULL) {
+			CHKiRet(execStmt(stmt, pMsg, pWti));
+		} else {
+			CHKiRet(execStmtProfiled(stmt, pMsg, pWti));
+		}
+	}
+finalize_it:
+	RETiRet;
+}
+
+
+/* run the next job of the current job set. Must be called with the pool
+ * mutex locked, which is temporarily released while the action commits.
+ * The commit code writes to the worker's execution state (e.g. when an
+ * action is suspended during retry), so each job runs on a private wti
+ * that shares only the per-action worker info with the real worker. The
+ * per-action entries are distinct for all jobs. Any suspension is merged
+ * back into the worker's state under the pool mutex.
+ */
+static void
+commitPoolRunJob(struct rsCommitPool_s *const pool)
+{
+	wti_t *const pWti = pool->pWti;
+	action_t *const pAction = pool->actions[pool->nextJob++];
+	wti_t wtiJob;
+
+	memset(&wtiJob, 0, sizeof(wtiJob));
+	wtiJob.pbShutdownImmediate = pWti->pbShutdownImmediate;
+	wtiJob.pWtp = pWti->pWtp;
+	wtiJob.pszDbgHdr = pWti->pszDbgHdr;
+	wtiJob.actWrkrInfo = pWti->actWrkrInfo;
+	wtiJob.execState = pWti->execState;
+	pthread_mutex_unlock(&pool->mut);
+	actionCommitDirect(pAction, &wtiJob);
+	pthread_mutex_lock(&pool->mut);
+	if(wtiJob.execState.bPrevWasSuspended)
+		pWti->execState.bPrevWasSuspended = 1;
+	++pool->nDone;
+}
+
+/* thread function of a commit pool helper */
+static void *
+commitPoolWorker(void *arg)
+{
+	struct rsCommitPool_s *const pool = (struct rsCommitPool_s*) arg;
+	sigset_t sigSet;
+
+	/* block all signals except SIGTTIN and SIGSEGV */
+	sigfillset(&sigSet);
+	sigdelset(&sigSet, SIGTTIN);
+	sigdelset(&sigSet, SIGSEGV);
+	pthread_sigmask(SIG_BLOCK, &sigSet, NULL);
+
+	pthread_mutex_lock(&pool->mut);
+	while(1) {
+		while(!pool->bShutdown && pool->nextJob >= pool->nJobs)
+			pthread_cond_wait(&pool->condWork, &pool->mut);
+		if(pool->bShutdown)
 			break;
-		default:
-			dbgprintf("error: unknown stmt type %u during exec\n",
-				(unsigned) stmt->nodetype);
+		commitPoolRunJob(pool);
+		if(pool->nDone == pool->nJobs)
+			pthread_cond_signal(&pool->condDone);
+	}
+	pthread_mutex_unlock(&pool->mut);
+	return NULL;
+}
+
+/* start the helper threads on first use, when the number of actions is
+ * known. Must be called with the pool mutex locked. If not all threads
+ * can be started, we continue with those we have - the calling worker
+ * always takes part in processing, so this just reduces concurrency.
+ */
+static rsRetVal
+commitPoolStart(struct rsCommitPool_s *const pool)
+{
+	int i, r;
+	DEFiRet;
+
+	if(pool->actions != NULL)
+		FINALIZE; /* already started */
+	CHKmalloc(pool->actions = calloc(iActionNbr, sizeof(action_t*)));
+	CHKmalloc(pool->tids = calloc(pool->nThrds, sizeof(pthread_t)));
+	for(i = 0 ; i < pool->nThrds ; ++i) {
+		r = pthread_create(&pool->tids[pool->nRunning], NULL, commitPoolWorker, pool);
+		if(r != 0) {
+			LogError(r, RS_RET_ERR, "ruleset: could not start parallel action helper "
+				"thread %d of %d, continuing with fewer", i + 1, pool->nThrds);
 			break;
 		}
+		++pool->nRunning;
+	}
+
+finalize_it:
+	if(iRet != RS_RET_OK) {
+		free(pool->actions);
+		pool->actions = NULL;
+		free(pool->tids);
+		pool->tids = NULL;
+	}
+	RETiRet;
+}
+
+/* commit all direct-mode actions of a worker, running the commits of
+ * independent actions concurrently. Each action is committed by exactly
+ * one thread, so per-action ordering is kept. We return only after all
+ * actions have been committed.
+ */
+static void
+commitAllDirectParallel(struct rsCommitPool_s *const pool, wti_t *const pWti)
+{
+	action_t *pAction;
+	int i, n;
+	int iCancelStateSave;
+
+	/* only transactional actions with pending messages need to commit */
+	n = 0;
+	for(i = 0 ; i < iActionNbr ; ++i) {
+		pAction = pWti->actWrkrInfo[i].pAction;
+		if(   pAction != NULL && pAction->isTransactional
+		   && pAction->pQueue->qType == QUEUETYPE_DIRECT
+		   && pWti->actWrkrInfo[i].p.tx.currIParam > 0)
+			++n;
 	}
+	if(n < 2) {
+		actionCommitAllDirect(pWti);
+		return;
+	}
+
+	/* The queue worker may be cancelled, but the helpers work on our wti
+	 * and the pool must be left in a consistent state. So we are not
+	 * cancelable until all jobs are done. Actions terminate their retry
+	 * loops on pbShutdownImmediate, so this does not block shutdown.
+	 */
+	pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &iCancelStateSave);
+	pthread_mutex_lock(&pool->mut);
+	if(pool->bBusy || commitPoolStart(pool) != RS_RET_OK) {
+		pthread_mutex_unlock(&pool->mut);
+		pthread_setcancelstate(iCancelStateSave, NULL);
+		actionCommitAllDirect(pWti);
+		return;
+	}
+	n = 0;
+	for(i = 0 ; i < iActionNbr ; ++i) {
+		pAction = pWti->actWrkrInfo[i].pAction;
+		if(   pAction != NULL && pAction->isTransactional
+		   && pAction->pQueue->qType == QUEUETYPE_DIRECT
+		   && pWti->actWrkrInfo[i].p.tx.currIParam > 0)
+			pool->actions[n++] = pAction;
+	}
+	DBGPRINTF("ruleset: committing %d actions in parallel\n", n);
+	pool->bBusy = 1;
+	pool->pWti = pWti;
+	pool->nJobs = n;
+	pool->nextJob = 0;
+	pool->nDone = 0;
+	pthread_cond_broadcast(&pool->condWork);
+
+	/* we do not sit idle but take part in processing */
+	while(pool->nextJob < pool->nJobs)
+		commitPoolRunJob(pool);
+	while(pool->nDone < pool->nJobs)
+		pthread_cond_wait(&pool->condDone, &pool->mut);
+
+	pool->nJobs = pool->nextJob = pool->nDone = 0;
+	pool->pWti = NULL;
+	pool->bBusy = 0;
+	pthread_mutex_unlock(&pool->mut);
+	pthread_setcancelstate(iCancelStateSave, NULL);
+}
+
+static rsRetVal
+commitPoolConstruct(struct rsCommitPool_s **const ppPool, const int nThrds)
+{
+	struct rsCommitPool_s *pool;
+	DEFiRet;
+
+	CHKmalloc(pool = calloc(1, sizeof(struct rsCommitPool_s)));
+	pthread_mutex_init(&pool->mut, NULL);
+	pthread_cond_init(&pool->condWork, NULL);
+	pthread_cond_init(&pool->condDone, NULL);
+	pool->nThrds = nThrds;
+	*ppPool = pool;
 finalize_it:
 	RETiRet;
 }
 
+static void
+commitPoolDestruct(struct rsCommitPool_s *const pool)
+{
+	int i;
+
+	pthread_mutex_lock(&pool->mut);
+	pool->bShutdown = 1;
+	pthread_cond_broadcast(&pool->condWork);
+	pthread_mutex_unlock(&pool->mut);
+	for(i = 0 ; i < pool->nRunning ; ++i)
+		pthread_join(pool->tids[i], NULL);
+	pthread_cond_destroy(&pool->condDone);
+	pthread_cond_destroy(&pool->condWork);
+	pthread_mutex_destroy(&pool->mut);
+	free(pool->tids);
+	free(pool->actions);
+	free(pool);
+}
+
 
 /* Process (consume) a batch of messages. Calls the actions configured.
  * This is called by MAIN queues.
@@ -645,6 +938,8 @@ processBatch(batch_t *pBatch, wti_t *pWti)
 	int i;
 	smsg_t *pMsg;
 	ruleset_t *pRuleset;
+	ruleset_t *pBatchRuleset = NULL;
+	sbool bMixedRulesets = 0;
 	rsRetVal localRet;
 	DEFiRet;
 
@@ -657,6 +952,11 @@ processBatch(batch_t *pBatch, wti_t *pWti)
 		pMsg = pBatch->pElem[i].pMsg;
 		DBGPRINTF("processBATCH: next msg %d: %.128s\n", i, pMsg->pszRawMsg);
 		pRuleset = (pMsg->pRuleset == NULL) ? ourConf->rulesets.pDflt : pMsg->pRuleset;
+		if(pBatchRuleset == NULL)
+			pBatchRuleset = pRuleset;
+		else if(pRuleset != pBatchRuleset)
+			bMixedRulesets = 1;
+		wtiInvalidateExprCache(pWti);
 		localRet = scriptExec(pRuleset->root, pMsg, pWti);
 		/* the most important case here is that processing may be aborted
 		 * due to pbShutdownImmediate, in which case we MUST NOT flag this
@@ -672,7 +972,14 @@ processBatch(batch_t *pBatch, wti_t *pWti)
 	/* commit phase */
 	DBGPRINTF("END batch execution phase, entering to commit phase "
 		"[processed %d of %d messages]\n", i, batchNumMsgs(pBatch));
-	actionCommitAllDirect(pWti);
+	/* the commit phase covers all direct actions of the worker, so the
+	 * commit pool is only used if the whole batch belongs to its ruleset.
+	 */
+	if(pBatchRuleset == NULL || bMixedRulesets || pBatchRuleset->pCommitPool == NULL) {
+		actionCommitAllDirect(pWti);
+	} else {
+		commitAllDirectParallel(pBatchRuleset->pCommitPool, pWti);
+	}
 
 	DBGPRINTF("processBATCH: batch of %d elements has been processed\n", pBatch->nElem);
 	RETiRet;
@@ -836,6 +1143,9 @@ CODESTARTobjDestruct(ruleset)
 	if(pThis->pParserLst != NULL) {
 		parser.DestructParserList(&pThis->pParserLst);
 	}
+	if(pThis->pCommitPool != NULL) {
+		commitPoolDestruct(pThis->pCommitPool);
+	}
 	free(pThis->pszName);
 ENDobjDestruct(ruleset)
 
@@ -943,6 +1253,7 @@ rulesetOptimize(ruleset_t *pRuleset)
 		rulesetDebugPrint((ruleset_t*) pRuleset);
 	}
 	pRuleset->root = cnfstmtOptimize(pRuleset->root);
+	cnfstmtOptimizeCSE(pRuleset->root);
 	if(Debug) {
 		dbgprintf("ruleset '%s' after optimization:\n",
 			  pRuleset->pszName);
@@ -969,6 +1280,126 @@ rulesetOptimizeAll(rsconf_t *conf)
 }
 
 
+static const char *
+stmtTypeName(const unsigned nodetype)
+{
+	switch(nodetype) {
+	case S_NOP: return "nop";
+	case S_STOP: return "stop";
+	case S_ACT: return "action";
+	case S_SET: return "set";
+	case S_UNSET: return "unset";
+	case S_CALL: return "call";
+	case S_CALL_INDIRECT: return "call_indirect";
+	case S_IF: return "if";
+	case S_FOREACH: return "foreach";
+	case S_PRIFILT: return "prifilt";
+	case S_PROPFILT: return "propfilt";
+	case S_RELOAD_LOOKUP_TABLE: return "reload_lookup_table";
+	default: return "unknown";
+	}
+}
+
+/* destruct the profiling data of a statement */
+void
+rulesetDestructStmtProf(struct cnfstmtprof *const prof)
+{
+	if(prof->stats != NULL)
+		statsobj.Destruct(&prof->stats);
+	free(prof);
+}
+
+/* set up profiling for a single statement. The stats object is named
+ * after the location of the statement in the config ("file:line type").
+ */
+static rsRetVal
+setupStmtProf(struct cnfstmt *const stmt)
+{
+	struct cnfstmtprof *prof = NULL;
+	uchar statsname[1024];
+	DEFiRet;
+
+	CHKmalloc(prof = calloc(1, sizeof(struct cnfstmtprof)));
+	snprintf((char*)statsname, sizeof(statsname), "%s:%d %s",
+		(stmt->srcFile == NULL) ? "-" : stmt->srcFile, stmt->srcLine,
+		stmtTypeName(stmt->nodetype));
+	CHKiRet(statsobj.Construct(&prof->stats));
+	CHKiRet(statsobj.SetName(prof->stats, statsname));
+	CHKiRet(statsobj.SetOrigin(prof->stats, UCHAR_CONSTANT("core.ruleset.profile")));
+	STATSCOUNTER_INIT(prof->ctrExecuted, prof->mutCtrExecuted);
+	CHKiRet(statsobj.AddCounter(prof->stats, UCHAR_CONSTANT("executed"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &prof->ctrExecuted));
+	if(stmt->nodetype == S_IF || stmt->nodetype == S_PRIFILT || stmt->nodetype == S_PROPFILT) {
+		STATSCOUNTER_INIT(prof->ctrTaken, prof->mutCtrTaken);
+		CHKiRet(statsobj.AddCounter(prof->stats, UCHAR_CONSTANT("taken"),
+			ctrType_IntCtr, CTR_FLAG_RESETTABLE, &prof->ctrTaken));
+	}
+	STATSCOUNTER_INIT(prof->ctrTimeNs, prof->mutCtrTimeNs);
+	CHKiRet(statsobj.AddCounter(prof->stats, UCHAR_CONSTANT("time.ns"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &prof->ctrTimeNs));
+	CHKiRet(statsobj.ConstructFinalize(prof->stats));
+	stmt->prof = prof;
+	prof = NULL;
+
+finalize_it:
+	if(prof != NULL)
+		rulesetDestructStmtProf(prof);
+	RETiRet;
+}
+
+/* set up profiling for all statements of a (sub)script */
+static rsRetVal
+scriptSetupProf(struct cnfstmt *const root)
+{
+	struct cnfstmt *stmt;
+	DEFiRet;
+
+	for(stmt = root ; stmt != NULL ; stmt = stmt->next) {
+		if(stmt->prof != NULL)
+			continue; /* already done (e.g. shared via CALL) */
+		CHKiRet(setupStmtProf(stmt));
+		switch(stmt->nodetype) {
+		case S_IF:
+			CHKiRet(scriptSetupProf(stmt->d.s_if.t_then));
+			CHKiRet(scriptSetupProf(stmt->d.s_if.t_else));
+			break;
+		case S_FOREACH:
+			CHKiRet(scriptSetupProf(stmt->d.s_foreach.body));
+			break;
+		case S_PRIFILT:
+			CHKiRet(scriptSetupProf(stmt->d.s_prifilt.t_then));
+			CHKiRet(scriptSetupProf(stmt->d.s_prifilt.t_else));
+			break;
+		case S_PROPFILT:
+			CHKiRet(scriptSetupProf(stmt->d.s_propfilt.t_then));
+			break;
+		default: /* no sub-statements */
+			break;
+		}
+	}
+finalize_it:
+	RETiRet;
+}
+
+/* helper for rulesetSetupProfilingAll(), handles a single ruleset */
+DEFFUNC_llExecFunc(doRulesetSetupProfilingAll)
+{
+	return scriptSetupProf(((ruleset_t*) pData)->root);
+}
+/* set up statement profiling for all rulesets. This must be called after
+ * the optimizer has run, as the optimizer changes the statements.
+ */
+rsRetVal
+rulesetSetupProfilingAll(rsconf_t *conf)
+{
+	DEFiRet;
+	dbgprintf("setting up ruleset profiling\n");
+	CHKiRet(llExecFunc(&(conf->rulesets.llRulesets), doRulesetSetupProfilingAll, NULL));
+finalize_it:
+	RETiRet;
+}
+
+
 /* Create a ruleset-specific "main" queue for this ruleset. If one is already
  * defined, an error message is emitted but nothing else is done.
  * Note: we use the main message queue parameters for queue creation and access
@@ -1062,7 +1493,7 @@ rulesetProcessCnf(struct cnfobj *o)
 	rsRetVal localRet;
 	uchar *rsName = NULL;
 	uchar *parserName;
-	int nameIdx, parserIdx;
+	int nameIdx, parserIdx, parActIdx;
 	ruleset_t *pRuleset;
 	struct cnfarray *ar;
 	int i;
@@ -1100,7 +1531,7 @@ rulesetProcessCnf(struct cnfobj *o)
 	}
 	addScript(pRuleset, o->script);
 
-	/* we have only two params, so we do NOT do the usual param loop */
+	/* we have only a few params, so we do NOT do the usual param loop */
 	parserIdx = cnfparamGetIdx(&rspblk, "parser");
 	if(parserIdx != -1  && pvals[parserIdx].bUsed) {
 		ar = pvals[parserIdx].val.d.ar;
@@ -1111,6 +1542,11 @@ rulesetProcessCnf(struct cnfobj *o)
 		}
 	}
 
+	parActIdx = cnfparamGetIdx(&rspblk, "parallelactions");
+	if(parActIdx != -1 && pvals[parActIdx].bUsed && pvals[parActIdx].val.d.n > 0) {
+		CHKiRet(commitPoolConstruct(&pRuleset->pCommitPool, (int) pvals[parActIdx].val.d.n));
+	}
+
 	/* pick up ruleset queue parameters */
 	if(queueCnfParamsSet(o->nvlst)) {
 		rsname = (pRuleset->pszName == NULL) ? (uchar*) "[ruleset]" : pRuleset->pszName;
@@ -1165,6 +1601,7 @@ ENDobjQueryInterface(ruleset)
  */
 BEGINObjClassExit(ruleset, OBJ_IS_CORE_MODULE) /* class, version */
 	objRelease(parser, CORE_COMPONENT);
+	objRelease(statsobj, CORE_COMPONENT);
 ENDObjClassExit(ruleset)
 
 
@@ -1174,6 +1611,7 @@ ENDObjClassExit(ruleset)
  */
 BEGINObjClassInit(ruleset, 1, OBJ_IS_CORE_MODULE) /* class, version */
 	/* request objects we use */
+	CHKiRet(objUse(statsobj, CORE_COMPONENT));
 
 	/* set our own handlers */
 	OBJSetMethodHandler(objMethod_DEBUGPRINT, rulesetDebugPrint);
@@ -35,6 +35,7 @@ struct ruleset_s {
 	struct cnfstmt *root;
 	struct cnfstmt *last;
 	parserList_t *pParserLst;/* list of parsers to use for this ruleset */
+	struct rsCommitPool_s *pCommitPool; /* helpers for parallel action commit, NULL if not enabled */
 };
 
 /* interfaces */
@@ -96,6 +97,8 @@ rsRetVal rulesetKeyDestruct(void __attribute__((unused)) *pData);
  */
 rsRetVal rulesetGetRuleset(rsconf_t *conf, ruleset_t **ppRuleset, uchar *pszName);
 rsRetVal rulesetOptimizeAll(rsconf_t *conf);
+rsRetVal rulesetSetupProfilingAll(rsconf_t *conf);
+void rulesetDestructStmtProf(struct cnfstmtprof *prof);
 rsRetVal rulesetProcessCnf(struct cnfobj *o);
 rsRetVal activateRulesetQueues(void);
 
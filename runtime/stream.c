@@ -866,6 +866,59 @@ static rsRetVal strmUnreadChar(strm_t *pThis, uchar c)
 	return RS_RET_OK;
 }
 
+/* read the remainder of a line, that is everything up to the next LF, and
+ * append it to pCStr. The LF itself is consumed but not appended. This is
+ * the bulk equivalent of calling strmReadChar() in a loop: we search the
+ * current buffer with memchr() (which is vectorized in all relevant libcs)
+ * and copy the whole run at once. Offsets are updated exactly as
+ * strmReadChar() would do, so state persistence and truncation checking
+ * are not affected. On EOF, everything read so far is already in pCStr.
+ */
+static rsRetVal ATTR_NONNULL()
+strmReadToLF(strm_t *const pThis, cstr_t *const pCStr)
+{
+	int padBytes;
+	uchar c;
+	const uchar *pData;
+	const uchar *pLF;
+	size_t lenAvail;
+	size_t lenData;
+	DEFiRet;
+
+	if(pThis->iUngetC != -1) {
+		CHKiRet(strmReadChar(pThis, &c));
+		if(c == '\n')
+			FINALIZE;
+		CHKiRet(cstrAppendChar(pCStr, c));
+	}
+
+	while(1) {
+		if(pThis->iBufPtr >= pThis->iBufPtrMax) {
+			padBytes = 0;
+			CHKiRet(strmReadBuf(pThis, &padBytes));
+			pThis->iCurrOffs += padBytes;
+		}
+		pData = pThis->pIOBuf + pThis->iBufPtr;
+		lenAvail = pThis->iBufPtrMax - pThis->iBufPtr;
+		pLF = memchr(pData, '\n', lenAvail);
+		lenData = (pLF == NULL) ? lenAvail : (size_t) (pLF - pData);
+		if(lenData > 0) {
+			CHKiRet(rsCStrAppendStrWithLen(pCStr, pData, lenData));
+		}
+		if(pLF == NULL) {
+			pThis->iBufPtr += lenAvail;
+			pThis->iCurrOffs += lenAvail;
+		} else {
+			pThis->iBufPtr += lenData + 1;
+			pThis->iCurrOffs += lenData + 1;
+			break;
+		}
+	}
+
+finalize_it:
+	RETiRet;
+}
+
 /* read a 'paragraph' from a strm file.
  * A paragraph may be terminated by a LF, by a LFLF, or by LF<not whitespace> depending on the option set.
  * The termination LF characters are read, but are
@@ -901,9 +954,9 @@ strmReadLine(strm_t *const pThis, cstr_t **ppCStr, uint8_t mode, sbool bEscapeLF
 		cstrDestruct(&pThis->prevLineSegment);
 	}
 	if(mode == 0) {
-		while(c != '\n') {
+		if(c != '\n') {
 			CHKiRet(cstrAppendChar(*ppCStr, c));
-			CHKiRet(strmReadChar(pThis, &c));
+			CHKiRet(strmReadToLF(pThis, *ppCStr));
 		}
 		if (trimLineOverBytes > 0 && (uint32_t) cstrLen(*ppCStr) > trimLineOverBytes) {
 			/* Truncate long line at trimLineOverBytes position */
@@ -1066,9 +1119,9 @@ strmReadMultiLine(strm_t *pThis, cstr_t **ppCStr, regex_t *start_preg, regex_t *
 			cstrDestruct(&pThis->prevLineSegment);
 		}
 
-		while(c != '\n') {
+		if(c != '\n') {
 			CHKiRet(cstrAppendChar(thisLine, c));
-			readCharRet = strmReadChar(pThis, &c);
+			readCharRet = strmReadToLF(pThis, thisLine);
 			if(readCharRet == RS_RET_EOF) {/* end of file reached without \n? */
 				CHKiRet(rsCStrConstructFromCStr(&pThis->prevLineSegment, thisLine));
 			}
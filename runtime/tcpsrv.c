@@ -83,6 +83,7 @@ MODULE_TYPE_NOKEEP
 /* defines */
 #define TCPSESS_MAX_DEFAULT 200 /* default for nbr of tcp sessions if no number is given */
 #define TCPLSTN_MAX_DEFAULT 20 /* default for nbr of listeners */
+#define TCPSESS_READBUDGET_DEFAULT (512*1024) /* max bytes read from a session per activation */
 
 /* static data */
 DEFobjStaticHelpers
@@ -102,22 +103,43 @@ static void startWorkerPool(void);
 
 /* The following structure controls the worker threads. Global data is
  * needed for their access.
+ * Each worker owns a small deque of workset items. The dispatcher
+ * (the thread running Run()) distributes a workset round-robin over
+ * these deques. A worker first takes items from the head of its own
+ * deque and, once that is empty, steals from the tail of the fullest
+ * other deque. So a worker that got stuck with a few busy sessions does
+ * not leave the others idle while it is still working through its share.
+ * All deques are guarded by wrkrMut; the work per item (a recv() and
+ * message submission) is large enough that a single mutex does not show
+ * up in profiles.
  */
+#define WRKR_DEQUE_SIZE 128	/* max items queued per worker (one full workset) */
+typedef struct wrkrItem_s {
+	tcpsrv_t *pSrv;
+	nspoll_t *pPoll;
+	int idx;
+	void *pUsr;
+	int *pPending;	/* outstanding items of the workset this item belongs to */
+} wrkrItem_t;
 static struct wrkrInfo_s {
 	pthread_t tid;	/* the worker's thread ID */
 	pthread_cond_t run;
-	int idx;
-	tcpsrv_t *pSrv; /* pSrv == NULL -> idle */
-	nspoll_t *pPoll;
-	void *pUsr;
 	sbool enabled;
+	wrkrItem_t deque[WRKR_DEQUE_SIZE];
+	int dqHead;	/* index of oldest item (owner end) */
+	int dqNum;	/* number of items currently queued */
 	long long unsigned numCalled;	/* how often was this called */
+	statsobj_t *stats;
+	STATSCOUNTER_DEF(ctrProcessed, mutCtrProcessed)
+	STATSCOUNTER_DEF(ctrStolen, mutCtrStolen)
+	STATSCOUNTER_DEF(ctrYielded, mutCtrYielded)
+	STATSCOUNTER_DEF(ctrBusyUs, mutCtrBusyUs)
 } wrkrInfo[4];
 static sbool bWrkrRunning; /* are the worker threads running? */
 static pthread_mutex_t wrkrMut;
 static pthread_cond_t wrkrIdle;
 static int wrkrMax = 4;
-static int wrkrRunning;
+static int wrkrNextPush; /* round-robin start for distributing worksets */
 
 /* add new listener port to listener port list
  * rgerhards, 2009-05-21
@@ -578,13 +600,20 @@ finalize_it:
 /* process a receive request on one of the streams
  * If pPoll is non-NULL, we have a netstream in epoll mode, which means we need
  * to remove any descriptor we close from the epoll set.
+ * We keep on reading as long as the driver fills our buffer completely (so
+ * more data is most probably waiting), but at most iSessReadBudget bytes per
+ * activation. After that, the session yields and is picked up again by the
+ * next poll round, so that a single very chatty peer can not starve the
+ * other sessions of its workset. *pbYielded tells the caller if this
+ * happened.
  * rgerhards, 2009-07-020
  */
 static rsRetVal
-doReceive(tcpsrv_t *pThis, tcps_sess_t **ppSess, nspoll_t *pPoll)
+doReceive(tcpsrv_t *pThis, tcps_sess_t **ppSess, nspoll_t *pPoll, int *const pbYielded)
 {
 	char buf[128*1024]; /* reception buffer - may hold a partial or multiple messages */
 	ssize_t iRcvd;
+	size_t lenRcvdTotal = 0;
 	rsRetVal localRet;
 	DEFiRet;
 	uchar *pszPeer;
@@ -593,40 +622,51 @@ doReceive(tcpsrv_t *pThis, tcps_sess_t **ppSess, nspoll_t *pPoll)
 
 	ISOBJ_TYPE_assert(pThis, tcpsrv);
 	DBGPRINTF("netstream %p with new data\n", (*ppSess)->pStrm);
-	/* Receive message */
-	iRet = pThis->pRcvData(*ppSess, buf, sizeof(buf), &iRcvd, &oserr);
-	switch(iRet) {
-	case RS_RET_CLOSED:
-		if(pThis->bEmitMsgOnClose) {
-			errno = 0;
-			prop.GetString((*ppSess)->fromHostIP, &pszPeer, &lenPeer);
-			LogError(0, RS_RET_PEER_CLOSED_CONN, "Netstream session %p closed by remote "
-				"peer %s.\n", (*ppSess)->pStrm, pszPeer);
-		}
-		CHKiRet(closeSess(pThis, ppSess, pPoll));
-		break;
-	case RS_RET_RETRY:
-		/* we simply ignore retry - this is not an error, but we also have not received anything */
-		break;
-	case RS_RET_OK:
-		/* valid data received, process it! */
-		localRet = tcps_sess.DataRcvd(*ppSess, buf, iRcvd);
-		if(localRet != RS_RET_OK && localRet != RS_RET_QUEUE_FULL) {
-			/* in this case, something went awfully wrong.
-			 * We are instructed to terminate the session.
-			 */
+	*pbYielded = 0;
+	do {
+		/* Receive message */
+		iRcvd = 0;
+		iRet = pThis->pRcvData(*ppSess, buf, sizeof(buf), &iRcvd, &oserr);
+		switch(iRet) {
+		case RS_RET_CLOSED:
+			if(pThis->bEmitMsgOnClose) {
+				errno = 0;
+				prop.GetString((*ppSess)->fromHostIP, &pszPeer, &lenPeer);
+				LogError(0, RS_RET_PEER_CLOSED_CONN, "Netstream session %p closed by remote "
+					"peer %s.\n", (*ppSess)->pStrm, pszPeer);
+			}
+			CHKiRet(closeSess(pThis, ppSess, pPoll));
+			break;
+		case RS_RET_RETRY:
+			/* we simply ignore retry - this is not an error, but we also have not received anything */
+			break;
+		case RS_RET_OK:
+			/* valid data received, process it! */
+			lenRcvdTotal += iRcvd;
+			localRet = tcps_sess.DataRcvd(*ppSess, buf, iRcvd);
+			if(localRet != RS_RET_OK && localRet != RS_RET_QUEUE_FULL) {
+				/* in this case, something went awfully wrong.
+				 * We are instructed to terminate the session.
+				 */
+				prop.GetString((*ppSess)->fromHostIP, &pszPeer, &lenPeer);
+				LogError(oserr, localRet, "Tearing down TCP Session from %s", pszPeer);
+				CHKiRet(closeSess(pThis, ppSess, pPoll));
+			}
+			break;
+		default:
 			prop.GetString((*ppSess)->fromHostIP, &pszPeer, &lenPeer);
-			LogError(oserr, localRet, "Tearing down TCP Session from %s", pszPeer);
+			LogError(oserr, iRet, "netstream session %p from %s will be closed due to error",
+					(*ppSess)->pStrm, pszPeer);
 			CHKiRet(closeSess(pThis, ppSess, pPoll));
+			break;
 		}
-		break;
-	default:
-		prop.GetString((*ppSess)->fromHostIP, &pszPeer, &lenPeer);
-		LogError(oserr, iRet, "netstream session %p from %s will be closed due to error",
-				(*ppSess)->pStrm, pszPeer);
-		CHKiRet(closeSess(pThis, ppSess, pPoll));
-		break;
-	}
+		if(iRet != RS_RET_OK || *ppSess == NULL || iRcvd != (ssize_t) sizeof(buf))
+			break;
+		if(lenRcvdTotal >= (size_t) pThis->iSessReadBudget) {
+			*pbYielded = 1;
+			break;
+		}
+	} while(glbl.GetGlobalInputTermState() == 0);
 
 finalize_it:
 	RETiRet;
@@ -634,13 +674,14 @@ finalize_it:
 
 /* process a single workset item
  */
-static rsRetVal ATTR_NONNULL(1)
-processWorksetItem(tcpsrv_t *const pThis, nspoll_t *pPoll, const int idx, void *pUsr)
+static rsRetVal ATTR_NONNULL(1, 5)
+processWorksetItem(tcpsrv_t *const pThis, nspoll_t *pPoll, const int idx, void *pUsr, int *const pbYielded)
 {
 	tcps_sess_t *pNewSess = NULL;
 	DEFiRet;
 
 	DBGPRINTF("tcpsrv: processing item %d, pUsr %p, bAbortConn\n", idx, pUsr);
+	*pbYielded = 0;
 	if(pUsr == pThis->ppLstn) {
 		DBGPRINTF("New connect on NSD %p.\n", pThis->ppLstn[idx]);
 		iRet = SessAccept(pThis, pThis->ppLstnPort[idx], &pNewSess, pThis->ppLstn[idx]);
@@ -654,7 +695,7 @@ processWorksetItem(tcpsrv_t *const pThis, nspoll_t *pPoll, const int idx, void *
 		}
 	} else {
 		pNewSess = (tcps_sess_t*) pUsr;
-		doReceive(pThis, &pNewSess, pPoll);
+		doReceive(pThis, &pNewSess, pPoll, pbYielded);
 		if(pPoll == NULL && pNewSess == NULL) {
 			pThis->pSessions[idx] = NULL;
 		}
@@ -665,37 +706,126 @@ finalize_it:
 }
 
 
+/* queue a workset item to the next worker that has room in its deque.
+ * Must be called with wrkrMut locked. Returns 0 if the item could not
+ * be queued, in which case the caller must process it itself.
+ */
+static int ATTR_NONNULL()
+wrkrPushItem(tcpsrv_t *const pThis, nspoll_t *const pPoll, nsd_epworkset_t *const pWork, int *const pPending)
+{
+	struct wrkrInfo_s *pWrkr;
+	wrkrItem_t *pItem;
+	int i;
+
+	for(i = 0 ; i < wrkrMax ; ++i) {
+		pWrkr = &wrkrInfo[(wrkrNextPush + i) % wrkrMax];
+		if(pWrkr->enabled && pWrkr->dqNum < WRKR_DEQUE_SIZE)
+			break;
+	}
+	if(i == wrkrMax)
+		return 0;
+	wrkrNextPush = (wrkrNextPush + i + 1) % wrkrMax;
+
+	pItem = &pWrkr->deque[(pWrkr->dqHead + pWrkr->dqNum) % WRKR_DEQUE_SIZE];
+	pItem->pSrv = pThis;
+	pItem->pPoll = pPoll;
+	pItem->idx = pWork->id;
+	pItem->pUsr = pWork->pUsr;
+	pItem->pPending = pPending;
+	++pWrkr->dqNum;
+	++(*pPending);
+	return 1;
+}
+
+
+/* obtain the next item to work on. If me is non-NULL, our own deque is
+ * checked first. Otherwise (and if it is empty), we steal the youngest
+ * item from the fullest other deque. Must be called with wrkrMut locked.
+ * Returns -1 if there is no work at all, 0 if the item came from our own
+ * deque and 1 if it was stolen.
+ */
+static int ATTR_NONNULL(2)
+wrkrGetItem(struct wrkrInfo_s *const me, wrkrItem_t *const pItem)
+{
+	struct wrkrInfo_s *pVictim = NULL;
+	int i;
+
+	if(me != NULL && me->dqNum > 0) {
+		*pItem = me->deque[me->dqHead];
+		me->dqHead = (me->dqHead + 1) % WRKR_DEQUE_SIZE;
+		--me->dqNum;
+		return 0;
+	}
+
+	for(i = 0 ; i < wrkrMax ; ++i) {
+		if(&wrkrInfo[i] != me && wrkrInfo[i].dqNum > 0
+		   && (pVictim == NULL || wrkrInfo[i].dqNum > pVictim->dqNum))
+			pVictim = &wrkrInfo[i];
+	}
+	if(pVictim == NULL)
+		return -1;
+	--pVictim->dqNum;
+	*pItem = pVictim->deque[(pVictim->dqHead + pVictim->dqNum) % WRKR_DEQUE_SIZE];
+	return 1;
+}
+
+
+/* mark an item as done and wake up its dispatcher if that was the last
+ * outstanding one. Must be called with wrkrMut locked. Note that more than
+ * one dispatcher (tcpsrv instance) may wait, so we need to broadcast.
+ */
+static void ATTR_NONNULL()
+wrkrItemDone(wrkrItem_t *const pItem)
+{
+	if(--(*pItem->pPending) == 0)
+		pthread_cond_broadcast(&wrkrIdle);
+}
+
+
 /* worker to process incoming requests
  */
 static void * ATTR_NONNULL(1)
 wrkr(void *const myself)
 {
 	struct wrkrInfo_s *const me = (struct wrkrInfo_s*) myself;
-
+	wrkrItem_t item;
+	struct timespec tBegin, tEnd;
+	int64_t us;
+	int bYielded;
+	int r;
 
 	pthread_mutex_lock(&wrkrMut);
 	while(1) {
-		// wait for work, in which case pSrv will be populated
-		while(me->pSrv == NULL && glbl.GetGlobalInputTermState() == 0) {
+		// wait for work, either in our own deque or one we can steal from
+		while((r = wrkrGetItem(me, &item)) == -1 && glbl.GetGlobalInputTermState() == 0) {
 			pthread_cond_wait(&me->run, &wrkrMut);
 		}
-		if(me->pSrv == NULL) {
+		if(r == -1) {
 			// only possible if glbl.GetGlobalInputTermState() == 1
-			// we need to query me->opSrv to avoid clang static
-			// analyzer false positive! -- rgerhards, 2017-10-23
 			assert(glbl.GetGlobalInputTermState() == 1);
-			--wrkrRunning;
 			break;
 		}
 		pthread_mutex_unlock(&wrkrMut);
 
 		++me->numCalled;
-		processWorksetItem(me->pSrv, me->pPoll, me->idx, me->pUsr);
+		if(r == 1) {
+			STATSCOUNTER_INC(me->ctrStolen, me->mutCtrStolen);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &tBegin);
+		processWorksetItem(item.pSrv, item.pPoll, item.idx, item.pUsr, &bYielded);
+		clock_gettime(CLOCK_MONOTONIC, &tEnd);
+		us = (int64_t) (tEnd.tv_sec - tBegin.tv_sec) * 1000000
+			+ (tEnd.tv_nsec - tBegin.tv_nsec) / 1000;
+		STATSCOUNTER_INC(me->ctrProcessed, me->mutCtrProcessed);
+		if(bYielded) {
+			STATSCOUNTER_INC(me->ctrYielded, me->mutCtrYielded);
+		}
+		if(us > 0) {
+			STATSCOUNTER_ADD(me->ctrBusyUs, me->mutCtrBusyUs, us);
+		}
 
 		pthread_mutex_lock(&wrkrMut);
-		me->pSrv = NULL;	/* indicate we are free again */
-		--wrkrRunning;
-		pthread_cond_signal(&wrkrIdle);
+		wrkrItemDone(&item);
 	}
 	me->enabled = 0; /* indicate we are no longer available */
 	pthread_mutex_unlock(&wrkrMut);
@@ -707,63 +837,71 @@ wrkr(void *const myself)
 /* Process a workset, that is handle io. We become activated
  * from either select or epoll handler. We split the workload
  * out to a pool of threads, but try to avoid context switches
- * as much as possible.
+ * as much as possible: a single item is processed by ourselves,
+ * and after distributing a larger workset, we help the workers
+ * drain the deques instead of just waiting for them.
  */
 static rsRetVal
 processWorkset(tcpsrv_t *pThis, nspoll_t *pPoll, int numEntries, nsd_epworkset_t workset[])
 {
 	int i;
-	int origEntries = numEntries;
+	int numQueued;
+	int numPending = 0;
+	int bYielded;
+	wrkrItem_t item;
 	DEFiRet;
 
 	DBGPRINTF("tcpsrv: ready to process %d event entries\n", numEntries);
 
-	while(numEntries > 0) {
-		if(glbl.GetGlobalInputTermState() == 1)
-			ABORT_FINALIZE(RS_RET_FORCE_TERM);
-		if(numEntries == 1) {
-			/* process self, save context switch */
-			iRet = processWorksetItem(pThis, pPoll, workset[numEntries-1].id, workset[numEntries-1].pUsr);
-		} else {
-			pthread_mutex_lock(&wrkrMut);
-			/* check if there is a free worker */
-			for(i = 0 ; (i < wrkrMax) && ((wrkrInfo[i].pSrv != NULL) || (wrkrInfo[i].enabled == 0)) ; ++i)
-				/*do search*/;
-			if(i < wrkrMax) {
-				/* worker free -> use it! */
-				wrkrInfo[i].pSrv = pThis;
-				wrkrInfo[i].pPoll = pPoll;
-				wrkrInfo[i].idx = workset[numEntries -1].id;
-				wrkrInfo[i].pUsr = workset[numEntries -1].pUsr;
-				/* Note: we must increment wrkrRunning HERE and not inside the worker's
-				 * code. This is because a worker may actually never start, and thus
-				 * increment wrkrRunning, before we finish and check the running worker
-				 * count. We can only avoid this by incrementing it here.
-				 */
-				++wrkrRunning;
-				pthread_cond_signal(&wrkrInfo[i].run);
-				pthread_mutex_unlock(&wrkrMut);
-			} else {
-				pthread_mutex_unlock(&wrkrMut);
-				/* no free worker, so we process this one ourselfs */
-				iRet = processWorksetItem(pThis, pPoll, workset[numEntries-1].id,
-						   workset[numEntries-1].pUsr);
-			}
+	if(glbl.GetGlobalInputTermState() == 1)
+		ABORT_FINALIZE(RS_RET_FORCE_TERM);
+	if(numEntries == 1) {
+		/* process self, save context switch */
+		iRet = processWorksetItem(pThis, pPoll, workset[0].id, workset[0].pUsr, &bYielded);
+		FINALIZE;
+	}
+
+	pthread_mutex_lock(&wrkrMut);
+	for(numQueued = 0 ; numQueued < numEntries ; ++numQueued) {
+		if(!wrkrPushItem(pThis, pPoll, &workset[numQueued], &numPending))
+			break;
+	}
+	if(numQueued > 0) {
+		for(i = 0 ; i < wrkrMax ; ++i)
+			pthread_cond_signal(&wrkrInfo[i].run);
+	}
+	pthread_mutex_unlock(&wrkrMut);
+
+	/* whatever did not fit into the deques is processed by ourselves */
+	for(i = numQueued ; i < numEntries ; ++i) {
+		if(glbl.GetGlobalInputTermState() == 1) {
+			iRet = RS_RET_FORCE_TERM;
+			break;
 		}
-		--numEntries;
+		iRet = processWorksetItem(pThis, pPoll, workset[i].id, workset[i].pUsr, &bYielded);
 	}
 
-	if(origEntries > 1) {
-		/* we now need to wait until all workers finish. This is because the
-		 * rest of this module can not handle the concurrency introduced
-		 * by workers running during the epoll call.
-		 */
-		pthread_mutex_lock(&wrkrMut);
-		while(wrkrRunning > 0) {
+	/* we now need to wait until all of our items are done. This is because the
+	 * rest of this module can not handle the concurrency introduced by workers
+	 * running during the epoll call. While waiting, we steal work ourselves. On
+	 * termination, workers may already be gone, so we drop what is left over.
+	 */
+	pthread_mutex_lock(&wrkrMut);
+	while(numPending > 0) {
+		if(wrkrGetItem(NULL, &item) == -1) {
 			pthread_cond_wait(&wrkrIdle, &wrkrMut);
+			continue;
 		}
 		pthread_mutex_unlock(&wrkrMut);
+		if(glbl.GetGlobalInputTermState() == 1) {
+			iRet = RS_RET_FORCE_TERM;
+		} else {
+			processWorksetItem(item.pSrv, item.pPoll, item.idx, item.pUsr, &bYielded);
+		}
+		pthread_mutex_lock(&wrkrMut);
+		wrkrItemDone(&item);
 	}
+	pthread_mutex_unlock(&wrkrMut);
 
 finalize_it:
 	RETiRet;
@@ -1000,6 +1138,7 @@ BEGINobjConstruct(tcpsrv) /* be sure to specify the object type also in END macr
 	pThis->bUseFlowControl = 1;
 	pThis->pszDrvrName = NULL;
 	pThis->bPreserveCase = 1; /* preserve case in fromhost; default to true. */
+	pThis->iSessReadBudget = TCPSESS_READBUDGET_DEFAULT;
 ENDobjConstruct(tcpsrv)
 
 
@@ -1017,6 +1156,7 @@ tcpsrvConstructFinalize(tcpsrv_t *pThis)
 	CHKiRet(netstrms.SetDrvrMode(pThis->pNS, pThis->iDrvrMode));
 	CHKiRet(netstrms.SetDrvrCheckExtendedKeyUsage(pThis->pNS, pThis->DrvrChkExtendedKeyUsage));
 	CHKiRet(netstrms.SetDrvrPrioritizeSAN(pThis->pNS, pThis->DrvrPrioritizeSan));
+	CHKiRet(netstrms.SetDrvrKTLS(pThis->pNS, pThis->DrvrKTLS));
 	if(pThis->pszDrvrAuthMode != NULL)
 		CHKiRet(netstrms.SetDrvrAuthMode(pThis->pNS, pThis->pszDrvrAuthMode));
 	if(pThis->pszDrvrPermitExpiredCerts != NULL)
@@ -1429,6 +1569,16 @@ SetDrvrPrioritizeSAN(tcpsrv_t *pThis, int prioritizeSan)
 	RETiRet;
 }
 
+/* set whether kernel TLS offload shall be tried */
+static rsRetVal
+SetDrvrKTLS(tcpsrv_t *pThis, int bKTLS)
+{
+	DEFiRet;
+	ISOBJ_TYPE_assert(pThis, tcpsrv);
+	pThis->DrvrKTLS = bKTLS;
+	RETiRet;
+}
+
 
 /* End of methods to shuffle autentication settings to the driver.;
 
@@ -1485,6 +1635,19 @@ SetPreserveCase(tcpsrv_t *pThis, int bPreserveCase)
 }
 
 
+/* set the max number of bytes we read from a single session before we
+ * yield to the other ones. 0 means a single read per activation.
+ */
+static rsRetVal
+SetSessReadBudget(tcpsrv_t *pThis, int iBudget)
+{
+	DEFiRet;
+	ISOBJ_TYPE_assert(pThis, tcpsrv);
+	pThis->iSessReadBudget = iBudget;
+	RETiRet;
+}
+
+
 /* queryInterface function
  * rgerhards, 2008-02-29
  */
@@ -1548,6 +1711,8 @@ CODESTARTobjQueryInterface(tcpsrv)
 	pIf->SetPreserveCase = SetPreserveCase;
 	pIf->SetDrvrCheckExtendedKeyUsage = SetDrvrCheckExtendedKeyUsage;
 	pIf->SetDrvrPrioritizeSAN = SetDrvrPrioritizeSAN;
+	pIf->SetDrvrKTLS = SetDrvrKTLS;
+	pIf->SetSessReadBudget = SetSessReadBudget;
 
 finalize_it:
 ENDobjQueryInterface(tcpsrv)
@@ -1596,6 +1761,41 @@ BEGINObjClassInit(tcpsrv, 1, OBJ_IS_LOADABLE_MODULE) /* class, version - CHANGE
 ENDObjClassInit(tcpsrv)
 
 
+/* set up the per-worker statistics. They permit to see how evenly the load
+ * is spread over the pool ("stolen") and how busy each worker is ("busy.us",
+ * the time spent processing items, in microseconds).
+ */
+static rsRetVal
+wrkrStatsConstruct(struct wrkrInfo_s *const pWrkr, const int idx)
+{
+	uchar statname[64];
+	DEFiRet;
+
+	CHKiRet(statsobj.Construct(&pWrkr->stats));
+	snprintf((char*)statname, sizeof(statname), "tcpsrv-worker(%d)", idx);
+	CHKiRet(statsobj.SetName(pWrkr->stats, statname));
+	CHKiRet(statsobj.SetOrigin(pWrkr->stats, UCHAR_CONSTANT("tcpsrv")));
+	STATSCOUNTER_INIT(pWrkr->ctrProcessed, pWrkr->mutCtrProcessed);
+	CHKiRet(statsobj.AddCounter(pWrkr->stats, UCHAR_CONSTANT("processed"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &pWrkr->ctrProcessed));
+	STATSCOUNTER_INIT(pWrkr->ctrStolen, pWrkr->mutCtrStolen);
+	CHKiRet(statsobj.AddCounter(pWrkr->stats, UCHAR_CONSTANT("stolen"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &pWrkr->ctrStolen));
+	STATSCOUNTER_INIT(pWrkr->ctrYielded, pWrkr->mutCtrYielded);
+	CHKiRet(statsobj.AddCounter(pWrkr->stats, UCHAR_CONSTANT("yielded"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &pWrkr->ctrYielded));
+	STATSCOUNTER_INIT(pWrkr->ctrBusyUs, pWrkr->mutCtrBusyUs);
+	CHKiRet(statsobj.AddCounter(pWrkr->stats, UCHAR_CONSTANT("busy.us"),
+		ctrType_IntCtr, CTR_FLAG_RESETTABLE, &pWrkr->ctrBusyUs));
+	CHKiRet(statsobj.ConstructFinalize(pWrkr->stats));
+
+finalize_it:
+	if(iRet != RS_RET_OK && pWrkr->stats != NULL)
+		statsobj.Destruct(&pWrkr->stats);
+	RETiRet;
+}
+
+
 /* start worker threads
  * Important: if we fork, this MUST be done AFTER forking
  */
@@ -1617,15 +1817,18 @@ startWorkerPool(void)
 	sigfillset(&sigSet);
 	pthread_sigmask(SIG_SETMASK, &sigSet, &sigSetSave);
 
-	wrkrRunning = 0;
 	pthread_cond_init(&wrkrIdle, NULL);
 	pthread_attr_init(&sessThrdAttr);
 	pthread_attr_setstacksize(&sessThrdAttr, 4096*1024);
 	for(i = 0 ; i < wrkrMax ; ++i) {
 		/* init worker info structure! */
 		pthread_cond_init(&wrkrInfo[i].run, NULL);
-		wrkrInfo[i].pSrv = NULL;
+		wrkrInfo[i].dqHead = 0;
+		wrkrInfo[i].dqNum = 0;
 		wrkrInfo[i].numCalled = 0;
+		if(wrkrStatsConstruct(&wrkrInfo[i], i) != RS_RET_OK) {
+			LogError(0, NO_ERRCODE, "tcpsrv: could not create statistics for worker %d", i);
+		}
 		r = pthread_create(&wrkrInfo[i].tid, &sessThrdAttr, wrkr, &(wrkrInfo[i]));
 		if(r == 0) {
 			wrkrInfo[i].enabled = 1;
@@ -1650,6 +1853,8 @@ stopWorkerPool(void)
 		pthread_join(wrkrInfo[i].tid, NULL);
 		DBGPRINTF("tcpsrv: info: worker %d was called %llu times\n", i, wrkrInfo[i].numCalled);
 		pthread_cond_destroy(&wrkrInfo[i].run);
+		if(wrkrInfo[i].stats != NULL)
+			statsobj.Destruct(&wrkrInfo[i].stats);
 	}
 	pthread_cond_destroy(&wrkrIdle);
 }
@@ -64,6 +64,7 @@ struct tcpsrv_s {
 	int iDrvrMode;		/**< mode of the stream driver to use */
 	int DrvrChkExtendedKeyUsage;		/**< if true, verify extended key usage in certs */
 	int DrvrPrioritizeSan;		/**< if true, perform stricter checking of names in certs */
+	int DrvrKTLS;			/**< if true, try to offload TLS records to the kernel */
 	uchar *gnutlsPriorityString;	/**< priority string for gnutls */
 	uchar *pszLstnPortFileName;	/**< File in which the dynamic port is written */
 	uchar *pszDrvrAuthMode;	/**< auth mode of the stream driver to use */
@@ -82,6 +83,7 @@ struct tcpsrv_s {
 	tcpLstnPortList_t **ppLstnPort; /**< pointer to relevant listen port description */
 	int iLstnMax;		/**< max number of listeners supported */
 	int iSessMax;		/**< max number of sessions supported */
+	int iSessReadBudget;	/**< max bytes read from one session before yielding to others */
 	uchar dfltTZ[8];	/**< default TZ if none in timestamp; '\0' =No Default */
 	tcpLstnPortList_t *pLstnPorts;	/**< head pointer for listen ports */
 
@@ -192,8 +194,12 @@ BEGINinterface(tcpsrv) /* name must also be changed in ENDinterface macro! */
 	/* added v23 -- Options for stricter driver behavior, 2019-08-16 */
 	rsRetVal (*SetDrvrCheckExtendedKeyUsage)(tcpsrv_t *pThis, int ChkExtendedKeyUsage);
 	rsRetVal (*SetDrvrPrioritizeSAN)(tcpsrv_t *pThis, int prioritizeSan);
+	/* added v24 -- kernel TLS offload */
+	rsRetVal (*SetDrvrKTLS)(tcpsrv_t *pThis, int bKTLS);
+	/* added v25 -- per-session read budget */
+	rsRetVal (*SetSessReadBudget)(tcpsrv_t *pThis, int iBudget);
 ENDinterface(tcpsrv)
-#define tcpsrvCURR_IF_VERSION 23 /* increment whenever you change the interface structure! */
+#define tcpsrvCURR_IF_VERSION 25 /* increment whenever you change the interface structure! */
 /* change for v4:
  * - SetAddtlFrameDelim() added -- rgerhards, 2008-12-10
  * - SetInputName() added -- rgerhards, 2008-12-10
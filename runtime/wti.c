@@ -233,6 +233,68 @@ finalize_it:
 
 
 
+/* obtain a result from the expression cache. On a cache hit, 1 is returned
+ * and ret is filled with a copy of the value (which the caller must free).
+ * On a miss, 0 is returned and ret is not touched.
+ */
+int ATTR_NONNULL()
+wtiGetExprCache(wti_t *const pWti, const int idx, struct svar *const ret)
+{
+	exprCacheEntry_t *entry;
+
+	if(idx >= pWti->exprCache.nEntries)
+		return 0;
+	entry = &pWti->exprCache.entries[idx];
+	if(entry->gen != pWti->exprCache.currGen || entry->val.datatype == 0)
+		return 0;
+	if(entry->val.datatype == 'S') {
+		if((ret->d.estr = es_strdup(entry->val.d.estr)) == NULL)
+			return 0;
+	} else {
+		ret->d.n = entry->val.d.n;
+	}
+	ret->datatype = entry->val.datatype;
+	return 1;
+}
+
+
+/* store a result in the expression cache. Only numbers and strings are
+ * cached. JSON results are not, as they reference live message data.
+ * Errors are not reported, the value is just not cached in that case.
+ */
+void ATTR_NONNULL()
+wtiSetExprCache(wti_t *const pWti, const int idx, const struct svar *const val)
+{
+	exprCacheEntry_t *entries;
+	exprCacheEntry_t *entry;
+	es_str_t *estr = NULL;
+	int newMax;
+
+	if(val->datatype != 'N' && val->datatype != 'S')
+		return;
+	if(idx >= pWti->exprCache.nEntries) {
+		newMax = idx + 8;
+		if((entries = realloc(pWti->exprCache.entries, sizeof(exprCacheEntry_t) * newMax)) == NULL)
+			return;
+		memset(entries + pWti->exprCache.nEntries, 0,
+		       sizeof(exprCacheEntry_t) * (newMax - pWti->exprCache.nEntries));
+		pWti->exprCache.entries = entries;
+		pWti->exprCache.nEntries = newMax;
+	}
+	if(val->datatype == 'S' && (estr = es_strdup(val->d.estr)) == NULL)
+		return;
+	entry = &pWti->exprCache.entries[idx];
+	if(entry->val.datatype == 'S')
+		es_deleteStr(entry->val.d.estr);
+	entry->val.datatype = val->datatype;
+	if(val->datatype == 'S')
+		entry->val.d.estr = estr;
+	else
+		entry->val.d.n = val->d.n;
+	entry->gen = pWti->exprCache.currGen;
+}
+
+
 /* Destructor */
 BEGINobjDestruct(wti) /* be sure to specify the object type also in END and CODESTART macros! */
 CODESTARTobjDestruct(wti)
@@ -248,7 +310,18 @@ CODESTARTobjDestruct(wti)
 	}
 	/* actual destruction */
 	batchFree(&pThis->batch);
+	while(pThis->pHeldRoot != NULL) { /* should already be released by queue */
+		heldBatch_t *const pHeld = pThis->pHeldRoot;
+		pThis->pHeldRoot = pHeld->pNext;
+		batchFree(&pHeld->batch);
+		free(pHeld);
+	}
 	free(pThis->actWrkrInfo);
+	for(int i = 0 ; i < pThis->exprCache.nEntries ; ++i) {
+		if(pThis->exprCache.entries[i].val.datatype == 'S')
+			es_deleteStr(pThis->exprCache.entries[i].val.d.estr);
+	}
+	free(pThis->exprCache.entries);
 	pthread_cond_destroy(&pThis->pcondBusy);
 	DESTROY_ATOMIC_HELPER_MUT(pThis->mutIsRunning);
 	free(pThis->pszDbgHdr);
@@ -260,6 +333,7 @@ ENDobjDestruct(wti)
 BEGINobjConstruct(wti) /* be sure to specify the object type also in END macro! */
 	INIT_ATOMIC_HELPER_MUT(pThis->mutIsRunning);
 	pthread_cond_init(&pThis->pcondBusy, NULL);
+	pThis->exprCache.currGen = 1; /* zeroed entries must be stale */
 ENDobjConstruct(wti)
 
 
@@ -385,6 +459,7 @@ wtiWorker(wti_t *__restrict__ const pThis)
 	rsRetVal localRet;
 	rsRetVal terminateRet;
 	actWrkrInfo_t *__restrict__ wrkrInfo;
+	struct timespec tLinger;
 	int iCancelStateSave;
 	int i, j, k;
 	DEFiRet;
@@ -417,6 +492,12 @@ wtiWorker(wti_t *__restrict__ const pThis)
 		/* first check if we are in shutdown process (but evaluate a bit later) */
 		terminateRet = wtpChkStopWrkr(pWtp, MUTEX_ALREADY_LOCKED);
 		if(terminateRet == RS_RET_TERMINATE_NOW) {
+			/* commit lingering and async transactions before their
+			 * batches are deleted */
+			d_pthread_mutex_unlock(pWtp->pmutUsr);
+			actionDrainAsync(pThis);
+			actionFlushLinger(pThis);
+			d_pthread_mutex_lock(pWtp->pmutUsr);
 			/* we now need to free the old batch */
 			localRet = pWtp->pfObjProcessed(pWtp->pUsr, pThis);
 			DBGOPRINT((obj_t*) pThis, "terminating worker because of "
@@ -430,6 +511,26 @@ wtiWorker(wti_t *__restrict__ const pThis)
 		if(localRet == RS_RET_ERR_QUEUE_EMERGENCY) {
 			break;	/* end of loop */
 		} else if(localRet == RS_RET_IDLE) {
+			if(actionHasAsyncInflight(pThis) && !*pThis->pbShutdownImmediate) {
+				/* complete async transactions before we go idle */
+				d_pthread_mutex_unlock(pWtp->pmutUsr);
+				actionDrainAsync(pThis);
+				d_pthread_mutex_lock(pWtp->pmutUsr);
+				continue; /* new work may have arrived in the meantime */
+			}
+			if(actionGetLingerTimeout(pThis, &tLinger)) {
+				/* wait for more work until the lingering transaction is due,
+				 * then commit it - the next dequeue releases its batches.
+				 */
+				if(terminateRet != RS_RET_TERMINATE_WHEN_IDLE && !*pThis->pbShutdownImmediate
+				   && wtiWaitNonEmpty(pThis, tLinger)) {
+					continue;
+				}
+				d_pthread_mutex_unlock(pWtp->pmutUsr);
+				actionFlushLinger(pThis);
+				d_pthread_mutex_lock(pWtp->pmutUsr);
+				continue;
+			}
 			if(terminateRet == RS_RET_TERMINATE_WHEN_IDLE || bInactivityTOOccured) {
 				DBGOPRINT((obj_t*) pThis, "terminating worker terminateRet=%d, "
 					"bInactivityTOOccured=%d\n", terminateRet, bInactivityTOOccured);
@@ -445,6 +546,8 @@ wtiWorker(wti_t *__restrict__ const pThis)
 	d_pthread_mutex_unlock(pWtp->pmutUsr);
 
 	DBGPRINTF("DDDD: wti %p: worker cleanup action instances\n", pThis);
+	actionDrainAsync(pThis);
+	actionFlushLinger(pThis);
 	for(i = 0 ; i < iActionNbr ; ++i) {
 		wrkrInfo = &(pThis->actWrkrInfo[i]);
 		dbgprintf("wti %p, action %d, ptr %p\n", pThis, i, wrkrInfo->actWrkrData);
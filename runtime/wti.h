@@ -28,6 +28,7 @@
 #include "obj.h"
 #include "batch.h"
 #include "action.h"
+#include "rainerscript.h"
 
 
 #define ACT_STATE_RDY  0	/* action ready, waiting for new transaction */
@@ -51,11 +52,15 @@ typedef struct actWrkrInfo {
 	struct {
 		unsigned actState : 3;
 	} flags;
+	int	nAsyncInflight;	/* number of async transactions submitted but not yet completed */
+	struct actAsyncTx_s *asyncDone; /* completed async transactions, not yet processed */
 	union {
 		struct {
 			actWrkrIParams_t *iparams;/* dynamically sized array for transactional outputs */
 			int currIParam;
 			int maxIParams;	/* current max */
+			size_t lingerBytes; /* size of params in open lingering transaction */
+			long long lingerStart; /* when lingering transaction was opened (ms) */
 		} tx;
 		struct {
 			actWrkrIParams_t actParams[CONF_OMOD_NUMSTRINGS_MAXSIZE];
@@ -63,7 +68,21 @@ typedef struct actWrkrInfo {
 	} p; /* short name for "parameters" */
 } actWrkrInfo_t;
 
+/* entry of the per-message expression cache, see cnfstmtOptimizeCSE() */
+typedef struct exprCacheEntry_s {
+	uint64_t gen;		/* cache generation this value belongs to */
+	struct svar val;	/* cached value ('N' or 'S'), datatype 0 if unused */
+} exprCacheEntry_t;
+
 /* the worker thread instance class */
+/* a batch that was processed by the consumer, but is not yet to be deleted
+ * from the queue store (see action.linger.*)
+ */
+typedef struct heldBatch_s {
+	batch_t batch;
+	struct heldBatch_s *pNext;
+} heldBatch_t;
+
 struct wti_s {
 	BEGINobjInstance;
 	pthread_t thrdID; 	/* thread ID */
@@ -73,6 +92,9 @@ struct wti_s {
 	wtp_t *pWtp; /* my worker thread pool (important if only the work thread instance is passed! */
 	batch_t batch; /* pointer to an object array meaningful for current user
 			  pointer (e.g. queue pUsr data elemt) */
+	sbool bBatchHold; /* consumer keeps its transaction open, do not yet delete batch */
+	heldBatch_t *pHeldRoot; /* batches held back from deletion, oldest first */
+	heldBatch_t *pHeldLast;
 	uchar *pszDbgHdr;	/* header string for debug messages */
 	actWrkrInfo_t *actWrkrInfo; /* *array* of action wrkr infos for all actions
 				      (sized for max nbr of actions in config!) */
@@ -85,7 +107,13 @@ struct wti_s {
 		                        * this is usually set for batches with 0 element, but may
 					* also be added as a user-selectable option (not implemented yet)
 					*/
+		unsigned profSampleCtr; /* selects statements to time when profiling */
 	} execState;	/* state for the execution engine */
+	struct {
+		exprCacheEntry_t *entries; /* *array* indexed by cache slot, dynamically sized */
+		int nEntries;
+		uint64_t currGen; /* entries of a different generation are stale */
+	} exprCache;	/* common subexpression cache, valid for the current message only */
 };
 
 
@@ -140,5 +168,13 @@ wtiResetExecState(wti_t * const pWti, batch_t * const pBatch)
 }
 
 
+/* invalidate all cached expression results. This must be done whenever
+ * processing of a new message begins and whenever the message or its
+ * variables may have been modified.
+ */
+#define wtiInvalidateExprCache(pWti) (++(pWti)->exprCache.currGen)
+
+int wtiGetExprCache(wti_t *const pWti, const int idx, struct svar *const ret);
+void wtiSetExprCache(wti_t *const pWti, const int idx, const struct svar *const val);
 rsRetVal wtiNewIParam(wti_t *const pWti, action_t *const pAction, actWrkrIParams_t **piparams);
 #endif /* #ifndef WTI_H_INCLUDED */
@@ -0,0 +1,25 @@
+#!/bin/bash
+# check the asynchronous output module interface via the omasynctest test
+# module. Transactions are still in flight when the next batch is processed
+# and every 3rd one fails, so that it must be committed synchronously. No
+# message may be lost or duplicated.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=10000
+generate_conf
+add_conf '
+module(load="./.libs/omasynctest")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then
+	action(type="omasynctest" file="'$RSYSLOG_OUT_LOG'" template="outfmt" failEvery="3"
+	       queue.type="linkedList" queue.dequeueBatchSize="16"
+	       action.maxInFlight="4")
+'
+startup
+injectmsg 0 $NUMMESSAGES
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $(( NUMMESSAGES - 1 ))
+content_check --regex 'async=[1-9][0-9]* sync=[1-9][0-9]*' $RSYSLOG_OUT_LOG.summary
+exit_test
@@ -0,0 +1,37 @@
+#!/bin/bash
+# check that an action with action.circuitBreaker="on" does not stall the
+# worker while its destination is down and that the circuit state is
+# reported via impstats
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+export DEAD_PORT="$(get_free_port)"
+generate_conf
+add_conf '
+main_queue(queue.workerthreads="1")
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+ruleset(name="stats") {
+  action(type="omfile" file="'${RSYSLOG_DYNNAME}'.out.stats.log")
+}
+
+module(load="../plugins/impstats/.libs/impstats" interval="1" severity="7" Ruleset="stats" format="json")
+
+if $msg contains "msgnum:" then {
+  # classic retry processing would block the worker for 100 seconds here
+  action(name="dead" type="omfwd" target="127.0.0.1" port="'$DEAD_PORT'" protocol="tcp"
+         action.resumeRetryCount="10" action.resumeInterval="10"
+         action.circuitBreaker="on")
+  action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+}
+'
+startup
+injectmsg 0 $NUMMESSAGES
+wait_file_lines $RSYSLOG_OUT_LOG $NUMMESSAGES 30
+. $srcdir/diag.sh wait-for-stats-flush ${RSYSLOG_DYNNAME}.out.stats.log
+shutdown_when_empty
+wait_shutdown
+seq_check
+content_check --regex '"name": "dead", "origin": "core.action".*"circuit.state": [12], "circuit.opened": 1' \
+	"${RSYSLOG_DYNNAME}.out.stats.log"
+exit_test
@@ -0,0 +1,23 @@
+#!/bin/bash
+# check that transactions kept open via action.linger.* are committed when
+# the size limit is reached, when the queue runs empty and on shutdown
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=10000
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if $msg contains "msgnum:" then
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt"
+	       queue.type="linkedList" queue.dequeueBatchSize="16"
+	       action.linger.ms="500" action.linger.bytes="4k")
+'
+startup
+injectmsg 0 $NUMMESSAGES
+wait_file_lines
+injectmsg $NUMMESSAGES 5
+shutdown_when_empty
+wait_shutdown
+seq_check 0 $(( NUMMESSAGES + 4 ))
+exit_test
@@ -0,0 +1,31 @@
+#!/bin/bash
+# check that many files are read completely when the reader pool is used
+# added 2026-10-18, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+. $srcdir/diag.sh check-inotify
+export NUMFILES=8
+export PERFILE=5000
+export NUMMESSAGES=$((NUMFILES * PERFILE * 2))
+generate_conf
+add_conf '
+global(workDirectory="'${RSYSLOG_DYNNAME}'.spool")
+module(load="../plugins/imfile/.libs/imfile" readerThreads="4")
+input(type="imfile" File="./'$RSYSLOG_DYNNAME'.input.*.log" tag="file:")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+if $msg contains "msgnum:" then
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+# first half of the data exists at startup, second half is appended later
+for i in $(seq 0 $((NUMFILES - 1))); do
+	./inputfilegen -m $PERFILE -i $((i * PERFILE)) > $RSYSLOG_DYNNAME.input.$i.log
+done
+startup
+for i in $(seq 0 $((NUMFILES - 1))); do
+	./inputfilegen -m $PERFILE -i $(((NUMFILES + i) * PERFILE)) >> $RSYSLOG_DYNNAME.input.$i.log
+done
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+seq_check
+exit_test
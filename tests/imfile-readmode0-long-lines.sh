@@ -0,0 +1,28 @@
+#!/bin/bash
+# lines larger than the imfile read buffer must be reassembled correctly,
+# also across a restart with persisted state in the middle of the file
+# added 2026-10-18, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=100
+generate_conf
+add_conf '
+global(workDirectory="'${RSYSLOG_DYNNAME}'.spool" maxMessageSize="300k")
+module(load="../plugins/imfile/.libs/imfile")
+input(type="imfile" File="./'$RSYSLOG_DYNNAME'.input" tag="file:")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+if $msg contains "msgnum:" then
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+./inputfilegen -m $((NUMMESSAGES / 2)) -d200000 > $RSYSLOG_DYNNAME.input
+startup
+wait_file_lines $RSYSLOG_OUT_LOG $((NUMMESSAGES / 2))
+shutdown_when_empty
+wait_shutdown
+./inputfilegen -m $((NUMMESSAGES / 2)) -i $((NUMMESSAGES / 2)) -d200000 >> $RSYSLOG_DYNNAME.input
+startup
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+seq_check
+exit_test
@@ -0,0 +1,37 @@
+#!/bin/bash
+# imfile startup benchmark: measures how long it takes until all files
+# matched by a wildcard have been read, for a list of file counts. This
+# is not part of the regular testbench, run it manually, e.g.
+#   IMFILE_SCALING_FILES="1000 10000 100000" ./imfile-startup-bench.sh
+# Note that large counts need a sufficiently high fs.inotify.max_user_watches
+# setting. The default is 1k, 10k and 100k files.
+# added 2026-10-18, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+. $srcdir/diag.sh check-inotify
+export IMFILE_SCALING_FILES="${IMFILE_SCALING_FILES:-1000 10000 100000}"
+generate_conf
+add_conf '
+global(workDirectory="'${RSYSLOG_DYNNAME}'.spool")
+module(load="../plugins/imfile/.libs/imfile")
+input(type="imfile" File="./'$RSYSLOG_DYNNAME'.input.d/*.log" tag="file:")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+if $msg contains "msgnum:" then
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+for NUMFILES in $IMFILE_SCALING_FILES; do
+	rm -rf $RSYSLOG_DYNNAME.input.d $RSYSLOG_DYNNAME.spool $RSYSLOG_OUT_LOG
+	mkdir $RSYSLOG_DYNNAME.input.d $RSYSLOG_DYNNAME.spool
+	for i in $(seq 0 $((NUMFILES - 1))); do
+		printf 'msgnum:%8.8d:\n' $i > $RSYSLOG_DYNNAME.input.d/$i.log
+	done
+	export NUMMESSAGES=$NUMFILES
+	starttime=$(date +%s%N)
+	startup
+	wait_file_lines
+	echo "imfile startup with $NUMFILES files took $(( ($(date +%s%N) - starttime) / 1000000 )) ms"
+	shutdown_when_empty
+	wait_shutdown
+	seq_check
+done
+exit_test
@@ -0,0 +1,36 @@
+#!/bin/bash
+# check imfile startup with a large number of files matched by a wildcard,
+# as well as files created and deleted while many files are monitored.
+# added 2026-10-18, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+. $srcdir/diag.sh check-inotify
+export NUMFILES=1000
+generate_conf
+add_conf '
+global(workDirectory="'${RSYSLOG_DYNNAME}'.spool")
+module(load="../plugins/imfile/.libs/imfile")
+input(type="imfile" File="./'$RSYSLOG_DYNNAME'.input.d/*.log" tag="file:")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+if $msg contains "msgnum:" then
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+mkdir $RSYSLOG_DYNNAME.input.d $RSYSLOG_DYNNAME.spool
+for i in $(seq 0 $((NUMFILES - 1))); do
+	printf 'msgnum:%8.8d:\n' $i > $RSYSLOG_DYNNAME.input.d/$i.log
+done
+export NUMMESSAGES=$NUMFILES
+startup
+wait_file_lines
+
+# now delete some files and add new ones while all others are monitored
+for i in $(seq 0 9); do
+	rm $RSYSLOG_DYNNAME.input.d/$i.log
+	printf 'msgnum:%8.8d:\n' $((NUMFILES + i)) > $RSYSLOG_DYNNAME.input.d/new$i.log
+done
+export NUMMESSAGES=$((NUMFILES + 10))
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+seq_check
+exit_test
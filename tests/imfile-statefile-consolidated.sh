@@ -0,0 +1,58 @@
+#!/bin/bash
+# check the consolidated state file: per-file state files are imported on
+# first start and processing continues without duplicates across restarts.
+# added 2026-10-18, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+. $srcdir/diag.sh check-inotify
+# $1 is "on" or "off" for statefile.consolidated
+imfile_conf() {
+	generate_conf
+	add_conf '
+global(workDirectory="'${RSYSLOG_DYNNAME}'.spool")
+module(load="../plugins/imfile/.libs/imfile" statefile.consolidated="'$1'")
+input(type="imfile" File="./'$RSYSLOG_DYNNAME'.input.*.log" tag="file:")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+if $msg contains "msgnum:" then
+	action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+}
+
+# first run creates per-file state files
+imfile_conf off
+./inputfilegen -m 100 -i 0 > $RSYSLOG_DYNNAME.input.1.log
+./inputfilegen -m 100 -i 100 > $RSYSLOG_DYNNAME.input.2.log
+startup
+export NUMMESSAGES=200
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+
+# second run must import them into the consolidated state file
+imfile_conf on
+./inputfilegen -m 100 -i 200 >> $RSYSLOG_DYNNAME.input.1.log
+startup
+export NUMMESSAGES=300
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+if [ ! -f $RSYSLOG_DYNNAME.spool/imfile-state.db ]; then
+	echo "FAIL: consolidated state file not created, spool dir is:"
+	ls -l $RSYSLOG_DYNNAME.spool
+	error_exit 1
+fi
+if ls $RSYSLOG_DYNNAME.spool/imfile-state:* > /dev/null 2>&1; then
+	echo "FAIL: per-file state files still present after import, spool dir is:"
+	ls -l $RSYSLOG_DYNNAME.spool
+	error_exit 1
+fi
+
+# third run continues from the consolidated state file
+./inputfilegen -m 100 -i 300 >> $RSYSLOG_DYNNAME.input.2.log
+startup
+export NUMMESSAGES=400
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+seq_check 0 399
+exit_test
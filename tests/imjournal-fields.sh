@@ -0,0 +1,36 @@
+#!/bin/bash
+# check that with the "fields" parameter, only the listed journal fields
+# are added to $!. We inject a test message as imjournal-basic.sh does.
+# added 2026-10-18, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+. $srcdir/diag.sh require-journalctl
+generate_conf
+add_conf '
+module(load="../plugins/imjournal/.libs/imjournal" IgnorePreviousMessages="on"
+	RateLimit.Burst="1000000" fields=["MESSAGE", "_PID"])
+
+template(name="outfmt" type="string" string="%msg%|%$!MESSAGE%|%$!PRIORITY%\n")
+action(type="omfile" template="outfmt" file="'$RSYSLOG_OUT_LOG'")
+'
+TESTMSG="TestBenCH-RSYSLog imjournal This is a test message - $(date +%s) - $RSYSLOG_DYNNAME"
+
+startup
+./journal_print "$TESTMSG"
+journal_write_state=$?
+if [ $journal_write_state -ne 0 ]; then
+	printf 'SKIP: journal_print returned state %d writing message: %s\n' "$journal_write_state" "$TESTMSG"
+	printf 'skipping test, journal probably not working\n'
+	exit 77
+fi
+content_check_with_count "$TESTMSG|$TESTMSG|" 1 300
+shutdown_when_empty
+wait_shutdown
+check_journal_testmsg_received
+
+# PRIORITY is present in the journal, but not listed - so it must be empty
+if ! grep -qxF "$TESTMSG|$TESTMSG|" < $RSYSLOG_OUT_LOG; then
+	echo "FAIL: unexpected field content, $RSYSLOG_OUT_LOG is:"
+	cat $RSYSLOG_OUT_LOG
+	error_exit 1
+fi
+exit_test
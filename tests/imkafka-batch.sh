@@ -0,0 +1,66 @@
+#!/bin/bash
+# check imkafka batch consumption with per-batch offset commits and
+# per-partition statistics
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+check_command_available kafkacat
+export KEEP_KAFKA_RUNNING="YES"
+
+export TESTMESSAGES=100000
+export TESTMESSAGESFULL=$TESTMESSAGES
+# Set EXTRA_EXITCHECK to dump kafka/zookeeperlogfiles on failure only.
+export EXTRA_EXITCHECK=dumpkafkalogs
+export EXTRA_EXIT=kafka
+
+export RANDTOPIC=$(tr -dc 'a-zA-Z0-9' < /dev/urandom | fold -w 8 | head -n 1)
+
+download_kafka
+stop_zookeeper
+stop_kafka
+
+start_zookeeper
+start_kafka
+create_kafka_topic $RANDTOPIC '.dep_wrk' '22181'
+
+generate_conf
+add_conf '
+main_queue(queue.timeoutactioncompletion="60000" queue.timeoutshutdown="60000")
+
+ruleset(name="stats") {
+	action(type="omfile" file="'${RSYSLOG_DYNNAME}'.out.stats.log")
+}
+module(load="../plugins/impstats/.libs/impstats" interval="1" severity="7" ruleset="stats")
+module(load="../plugins/imkafka/.libs/imkafka")
+/* Polls messages from kafka server!*/
+input(	type="imkafka"
+	topic="'$RANDTOPIC'"
+	broker="localhost:29092"
+	consumergroup="default"
+	batchsize="64"
+	batch.commit="on"
+	confParam=[ "compression.codec=none",
+		"session.timeout.ms=10000",
+		"socket.timeout.ms=5000",
+		"socket.keepalive.enable=true",
+		"reconnect.backoff.jitter.ms=1000",
+		"enable.partition.eof=false" ]
+	)
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+if ($msg contains "msgnum:") then {
+	action( type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt" )
+}
+'
+startup
+injectmsg_kafkacat --wait 1 $TESTMESSAGESFULL -d
+shutdown_when_empty
+wait_shutdown
+
+delete_kafka_topic $RANDTOPIC '.dep_wrk' '22181'
+
+seq_check 1 $TESTMESSAGESFULL -d
+custom_content_check "imkafka($RANDTOPIC/0)" "${RSYSLOG_DYNNAME}.out.stats.log"
+custom_content_check 'lag=' "${RSYSLOG_DYNNAME}.out.stats.log"
+
+exit_test
@@ -0,0 +1,28 @@
+#!/bin/bash
+# check that several LF-delimited messages received in a single read
+# are each submitted exactly once, and that the sender stats count
+# them correctly
+# added 2026-10-18, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+global(senders.keepTrack="on")
+module(load="../plugins/impstats/.libs/impstats" interval="1" log.syslog="off"
+	log.file=`echo $RSYSLOG_DYNNAME.stats`)
+module(load="../plugins/imptcp/.libs/imptcp")
+input(type="imptcp" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcpflood_port")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+action(type="omfile" template="outfmt" file=`echo $RSYSLOG_OUT_LOG`)
+'
+startup
+for i in 0 1 2 3 4; do
+	printf '<167>Mar  6 16:57:54 172.20.245.8 test: msgnum:%d\n' $i
+done > $RSYSLOG_DYNNAME.input
+tcpflood -B -I $RSYSLOG_DYNNAME.input
+wait_content '_sender_stat: sender=.* messages=5$' $RSYSLOG_DYNNAME.stats
+shutdown_when_empty
+wait_shutdown
+seq_check 0 4
+check_not_present '_sender_stat: sender=.* messages=\([6-9]\|[1-9][0-9]\)' $RSYSLOG_DYNNAME.stats
+exit_test
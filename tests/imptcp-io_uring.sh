@@ -0,0 +1,34 @@
+#!/bin/bash
+# Test imptcp with the io_uring engine. The test is skipped if rsyslog was
+# built without liburing or the kernel lacks support, as imptcp then falls
+# back to epoll.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=20000
+export RSYSLOG_DEBUG="debug nostdout"
+export RSYSLOG_DEBUGLOG="$RSYSLOG_DYNNAME.debuglog"
+generate_conf
+add_conf '
+global(debug.whitelist="on" debug.files=["imptcp.c"])
+module(load="../plugins/imptcp/.libs/imptcp" io.engine="io_uring")
+input(type="imptcp" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcpflood_port")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" action(type="omfile" template="outfmt"
+			         file="'$RSYSLOG_OUT_LOG'")
+if $syslogtag startswith "rsyslogd" then
+	action(type="omfile" file="'$RSYSLOG_DYNNAME'.internal.log")
+'
+startup
+tcpflood -c20 -m$NUMMESSAGES
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+if grep -qs "built without liburing\|not supported by kernel" $RSYSLOG_DYNNAME.internal.log; then
+	echo "io_uring engine not available, skipping test"
+	skip_test
+fi
+seq_check
+custom_content_check "io_uring engine initialized" $RSYSLOG_DEBUGLOG
+custom_content_check "io_uring data(" $RSYSLOG_DEBUGLOG
+exit_test
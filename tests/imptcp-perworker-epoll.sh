@@ -0,0 +1,22 @@
+#!/bin/bash
+# Test imptcp with per-worker epoll sets and SO_REUSEPORT listeners.
+# Many connections are used so that all workers get sessions.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=20000
+generate_conf
+add_conf '
+module(load="../plugins/imptcp/.libs/imptcp" threads="4" perWorkerEpoll="on")
+input(type="imptcp" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcpflood_port")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" action(type="omfile" template="outfmt"
+			         file="'$RSYSLOG_OUT_LOG'")
+'
+startup
+tcpflood -c100 -m$NUMMESSAGES
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+seq_check
+exit_test
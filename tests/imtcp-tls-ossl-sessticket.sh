@@ -0,0 +1,64 @@
+#!/bin/bash
+# check that TLS sessions are resumed when omfwd reconnects to imtcp. The
+# sender rebinds several times, and each new connection must be able to
+# resume the session (via ticket issued with our own rotating keys).
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=1000
+
+#receiver
+generate_conf
+export PORT_RCVR="$(get_free_port)"
+add_conf '
+global(	defaultNetstreamDriverCAFile="'$srcdir/tls-certs/ca.pem'"
+	defaultNetstreamDriverCertFile="'$srcdir/tls-certs/cert.pem'"
+	defaultNetstreamDriverKeyFile="'$srcdir/tls-certs/key.pem'"
+	tls.session.lifetime="600"
+	tls.session.ticketKeyRotation="60"
+)
+
+module(load="../plugins/impstats/.libs/impstats" interval="1" log.syslog="off"
+	log.file="'$RSYSLOG_DYNNAME'.stats")
+module(	load="../plugins/imtcp/.libs/imtcp"
+	StreamDriver.Name="ossl"
+	StreamDriver.Mode="1"
+	StreamDriver.AuthMode="anon" )
+input(	type="imtcp"
+	port="'$PORT_RCVR'" )
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" action(	type="omfile"
+					template="outfmt"
+					file=`echo $RSYSLOG_OUT_LOG`)
+'
+startup
+
+#sender
+generate_conf 2
+export TCPFLOOD_PORT="$(get_free_port)"
+add_conf '
+global(	defaultNetstreamDriverCAFile="'$srcdir/tls-certs/ca.pem'"
+	defaultNetstreamDriverCertFile="'$srcdir/tls-certs/cert.pem'"
+	defaultNetstreamDriverKeyFile="'$srcdir/tls-certs/key.pem'"
+)
+
+# Note: no TLS for the listener, this is for tcpflood!
+module(load="../plugins/imtcp/.libs/imtcp")
+input(type="imtcp" port="'$TCPFLOOD_PORT'")
+
+# rebind after 200 messages, so that we reconnect several times
+action(type="omfwd" target="127.0.0.1" port="'$PORT_RCVR'" protocol="tcp"
+	StreamDriver="ossl" StreamDriverMode="1" StreamDriverAuthMode="anon"
+	RebindInterval="200")
+' 2
+startup 2
+
+tcpflood -m$NUMMESSAGES -i1
+shutdown_when_empty 2
+wait_shutdown 2
+wait_content 'nsd_ossl: .*handshakes.resumed=[1-9]' $RSYSLOG_DYNNAME.stats
+shutdown_when_empty
+wait_shutdown
+seq_check 1 $NUMMESSAGES
+unset PORT_RCVR
+exit_test
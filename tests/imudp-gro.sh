@@ -0,0 +1,29 @@
+#!/bin/bash
+# check imudp in GRO receive mode. With DNS disabled, the sender
+# props are created by imudp itself, so we check fromhost-ip as well.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=100 # UDP, so keep it small to avoid loss
+generate_conf
+add_conf '
+global(net.enableDNS="off")
+module(load="../plugins/imudp/.libs/imudp" gro="on")
+input(type="imudp" address="127.0.0.1" port="'$TCPFLOOD_PORT'")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+template(name="hostfmt" type="string" string="%fromhost-ip%\n")
+:msg, contains, "msgnum:" action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+:msg, contains, "msgnum:" action(type="omfile" file="'$RSYSLOG_DYNNAME'.host.log" template="hostfmt")
+'
+startup
+tcpflood -m$NUMMESSAGES -Tudp
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+seq_check
+if [ "$(sort -u $RSYSLOG_DYNNAME.host.log)" != "127.0.0.1" ]; then
+	echo "FAIL: unexpected fromhost-ip values:"
+	sort -u $RSYSLOG_DYNNAME.host.log
+	error_exit 1
+fi
+exit_test
@@ -0,0 +1,22 @@
+#!/bin/bash
+# check that imudp works with one SO_REUSEPORT socket per worker
+# and source address steering of datagrams to workers.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=100 # UDP, so keep it small to avoid loss
+generate_conf
+add_conf '
+module(load="../plugins/imudp/.libs/imudp" threads="3"
+	reuseport="on" reuseport.steering="source")
+input(type="imudp" address="127.0.0.1" port="'$TCPFLOOD_PORT'")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+startup
+tcpflood -m$NUMMESSAGES -Tudp
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+seq_check
+exit_test
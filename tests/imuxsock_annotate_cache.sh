@@ -0,0 +1,40 @@
+#!/bin/bash
+# check that trusted properties are served from the per-pid cache
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+check_logger_has_option_d
+generate_conf
+add_conf '
+ruleset(name="stats") {
+  action(type="omfile" file="'${RSYSLOG_DYNNAME}'.out.stats.log")
+}
+module(load="../plugins/impstats/.libs/impstats" interval="1" severity="7" ruleset="stats")
+module(load="../plugins/imuxsock/.libs/imuxsock" sysSock.use="off" annotate.cacheTTL="600")
+input(type="imuxsock" Socket="'$RSYSLOG_DYNNAME'-testbench_socket"
+      annotate="on" parseTrusted="on")
+
+template(name="outfmt" type="string" string="%msg:%,%$!appname%\n")
+if $inputname == "imuxsock" then
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+'
+startup
+# all messages are sent by the same logger process, so only the first
+# one must read the trusted properties from /proc. We keep logger's stdin
+# open until all messages are processed, so that it is still alive when
+# rsyslog looks up its properties.
+export NUMMESSAGES=5
+{
+	printf 'msg1\nmsg2\nmsg3\nmsg4\nmsg5\n'
+	wait_file_lines >&2 # progress output must not go to logger
+} | logger -d -u $RSYSLOG_DYNNAME-testbench_socket
+wait_content 'trustedprops.cache.hits=4' "${RSYSLOG_DYNNAME}.out.stats.log"
+shutdown_when_empty
+wait_shutdown
+export EXPECTED=' msg1,logger
+ msg2,logger
+ msg3,logger
+ msg4,logger
+ msg5,logger'
+cmp_exact
+custom_content_check 'trustedprops.cache.misses=1' "${RSYSLOG_DYNNAME}.out.stats.log"
+exit_test
@@ -0,0 +1,24 @@
+#!/bin/bash
+# check imuxsock batch receive (recvmmsg) with a small batch size, so that
+# a burst of messages spans many batches. Order must be preserved.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+check_logger_has_option_d
+export NUMMESSAGES=2000
+generate_conf
+add_conf '
+module(load="../plugins/imuxsock/.libs/imuxsock" sysSock.use="off" batchSize="8")
+input(type="imuxsock" Socket="'$RSYSLOG_DYNNAME'-testbench_socket")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+:msg, contains, "msgnum:" action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+startup
+for i in $(seq 0 $((NUMMESSAGES - 1))); do
+	printf 'msgnum:%08d:\n' $i
+done | logger -d -u $RSYSLOG_DYNNAME-testbench_socket
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+seq_check
+exit_test
@@ -0,0 +1,277 @@
+/* omasynctest.c
+ * This is a testing aid for the asynchronous output module interface
+ * (submitAsync/pollCompletions). It is not meant to be used in production.
+ *
+ * Each submitted transaction stays in flight until the next poll that does
+ * not belong to the submission itself, so transactions are always still
+ * pending when the next batch is processed. Completion writes the messages
+ * to the output file. With failEvery="n", every n-th transaction completes
+ * with RS_RET_SUSPENDED and is thus committed again via commitTransaction().
+ * On shutdown, the number of async and sync committed transactions is
+ * written to file.summary, so that tests can check which path was taken.
+ *
+ * Copyright 2026 Adiscon GmbH.
+ *
+ * This file is part of rsyslog.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *       http://www.apache.org/licenses/LICENSE-2.0
+ *       -or-
+ *       see COPYING.ASL20 in the source distribution
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "config.h"
+#include "rsyslog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include "conf.h"
+#include "syslogd-types.h"
+#include "module-template.h"
+#include "errmsg.h"
+
+MODULE_TYPE_OUTPUT
+MODULE_TYPE_NOKEEP
+MODULE_CNFNAME("omasynctest")
+
+DEF_OMOD_STATIC_DATA
+
+typedef struct _instanceData {
+	uchar *file;
+	uchar *tplName;
+	int failEvery;
+	FILE *fp;
+	unsigned nTx;		/* number of async transactions submitted */
+	unsigned nAsyncDone;	/* number of transactions completed asynchronously */
+	unsigned nSyncDone;	/* number of transactions committed synchronously */
+	pthread_mutex_t mut;
+} instanceData;
+
+/* a submitted, not yet completed transaction */
+typedef struct pendingTx_s {
+	actWrkrIParams_t *pParams;
+	unsigned nParams;
+	void *pCookie;
+	int bFail;
+	struct pendingTx_s *next;
+} pendingTx_t;
+
+typedef struct wrkrInstanceData {
+	instanceData *pData;
+	pendingTx_t *pendRoot;	/* oldest first */
+	pendingTx_t *pendLast;
+} wrkrInstanceData_t;
+
+static struct cnfparamdescr actpdescr[] = {
+	{ "file", eCmdHdlrGetWord, CNFPARAM_REQUIRED },
+	{ "template", eCmdHdlrGetWord, 0 },
+	{ "failevery", eCmdHdlrNonNegInt, 0 }
+};
+static struct cnfparamblk actpblk =
+	{ CNFPARAMBLK_VERSION,
+	  sizeof(actpdescr)/sizeof(struct cnfparamdescr),
+	  actpdescr
+	};
+
+
+BEGINinitConfVars
+CODESTARTinitConfVars
+ENDinitConfVars
+
+BEGINcreateInstance
+CODESTARTcreateInstance
+	pthread_mutex_init(&pData->mut, NULL);
+ENDcreateInstance
+
+BEGINcreateWrkrInstance
+CODESTARTcreateWrkrInstance
+	pWrkrData->pendRoot = NULL;
+	pWrkrData->pendLast = NULL;
+ENDcreateWrkrInstance
+
+BEGINisCompatibleWithFeature
+CODESTARTisCompatibleWithFeature
+ENDisCompatibleWithFeature
+
+BEGINfreeInstance
+	FILE *fpSum;
+	char sumName[4096];
+CODESTARTfreeInstance
+	snprintf(sumName, sizeof(sumName), "%s.summary", (char*) pData->file);
+	if((fpSum = fopen(sumName, "w")) != NULL) {
+		fprintf(fpSum, "async=%u sync=%u\n", pData->nAsyncDone, pData->nSyncDone);
+		fclose(fpSum);
+	}
+	if(pData->fp != NULL)
+		fclose(pData->fp);
+	free(pData->file);
+	free(pData->tplName);
+	pthread_mutex_destroy(&pData->mut);
+ENDfreeInstance
+
+BEGINfreeWrkrInstance
+	pendingTx_t *tx;
+CODESTARTfreeWrkrInstance
+	/* the core drains all transactions before, so this is for immediate shutdown */
+	while((tx = pWrkrData->pendRoot) != NULL) {
+		pWrkrData->pendRoot = tx->next;
+		free(tx);
+	}
+ENDfreeWrkrInstance
+
+BEGINdbgPrintInstInfo
+CODESTARTdbgPrintInstInfo
+ENDdbgPrintInstInfo
+
+BEGINtryResume
+CODESTARTtryResume
+ENDtryResume
+
+
+static void
+writeParams(instanceData *const pData, actWrkrIParams_t *const pParams, const unsigned nParams)
+{
+	unsigned i;
+
+	for(i = 0 ; i < nParams ; ++i) {
+		fputs((char*) actParam(pParams, 1, i, 0).param, pData->fp);
+	}
+	fflush(pData->fp);
+}
+
+
+BEGINbeginTransaction
+CODESTARTbeginTransaction
+ENDbeginTransaction
+
+BEGINcommitTransaction
+	instanceData *const pData = pWrkrData->pData;
+CODESTARTcommitTransaction
+	pthread_mutex_lock(&pData->mut);
+	writeParams(pData, pParams, nParams);
+	++pData->nSyncDone;
+	pthread_mutex_unlock(&pData->mut);
+ENDcommitTransaction
+
+
+BEGINsubmitAsync
+	instanceData *const pData = pWrkrData->pData;
+	pendingTx_t *tx;
+CODESTARTsubmitAsync
+	CHKmalloc(tx = calloc(1, sizeof(pendingTx_t)));
+	tx->pParams = pParams;
+	tx->nParams = nParams;
+	tx->pCookie = pCookie;
+	pthread_mutex_lock(&pData->mut);
+	++pData->nTx;
+	tx->bFail = (pData->failEvery > 0 && pData->nTx % pData->failEvery == 0);
+	pthread_mutex_unlock(&pData->mut);
+	if(pWrkrData->pendLast == NULL)
+		pWrkrData->pendRoot = tx;
+	else
+		pWrkrData->pendLast->next = tx;
+	pWrkrData->pendLast = tx;
+finalize_it:
+ENDsubmitAsync
+
+
+/* a non-blocking poll completes everything but the most recent transaction,
+ * so that it is still in flight when the worker processes the next batch.
+ * A blocking poll (the core waits for completions) completes everything.
+ */
+BEGINpollCompletions
+	instanceData *const pData = pWrkrData->pData;
+	pendingTx_t *tx;
+CODESTARTpollCompletions
+	while((tx = pWrkrData->pendRoot) != NULL && (timeoutMs > 0 || tx->next != NULL)) {
+		pWrkrData->pendRoot = tx->next;
+		if(pWrkrData->pendRoot == NULL)
+			pWrkrData->pendLast = NULL;
+		if(tx->bFail) {
+			onComplete(tx->pCookie, RS_RET_SUSPENDED);
+		} else {
+			pthread_mutex_lock(&pData->mut);
+			writeParams(pData, tx->pParams, tx->nParams);
+			++pData->nAsyncDone;
+			pthread_mutex_unlock(&pData->mut);
+			onComplete(tx->pCookie, RS_RET_OK);
+		}
+		free(tx);
+	}
+ENDpollCompletions
+
+
+BEGINnewActInst
+	struct cnfparamvals *pvals;
+	int i;
+CODESTARTnewActInst
+	if((pvals = nvlstGetParams(lst, &actpblk, NULL)) == NULL) {
+		ABORT_FINALIZE(RS_RET_MISSING_CNFPARAMS);
+	}
+
+	CHKiRet(createInstance(&pData));
+
+	CODE_STD_STRING_REQUESTnewActInst(1)
+	for(i = 0 ; i < actpblk.nParams ; ++i) {
+		if(!pvals[i].bUsed)
+			continue;
+		if(!strcmp(actpblk.descr[i].name, "file")) {
+			pData->file = (uchar*)es_str2cstr(pvals[i].val.d.estr, NULL);
+		} else if(!strcmp(actpblk.descr[i].name, "template")) {
+			pData->tplName = (uchar*)es_str2cstr(pvals[i].val.d.estr, NULL);
+		} else if(!strcmp(actpblk.descr[i].name, "failevery")) {
+			pData->failEvery = (int) pvals[i].val.d.n;
+		} else {
+			dbgprintf("omasynctest: program error, non-handled "
+			  "param '%s'\n", actpblk.descr[i].name);
+		}
+	}
+
+	if((pData->fp = fopen((char*) pData->file, "w")) == NULL) {
+		LogError(errno, RS_RET_FILE_OPEN_ERROR, "omasynctest: cannot open '%s'", pData->file);
+		ABORT_FINALIZE(RS_RET_FILE_OPEN_ERROR);
+	}
+	CHKiRet(OMSRsetEntry(*ppOMSR, 0, (uchar*) strdup((pData->tplName == NULL) ?
+		"RSYSLOG_FileFormat" : (char*) pData->tplName), OMSR_NO_RQD_TPL_OPTS));
+CODE_STD_FINALIZERnewActInst
+	cnfparamvalsDestruct(pvals, &actpblk);
+ENDnewActInst
+
+
+BEGINparseSelectorAct
+CODESTARTparseSelectorAct
+CODE_STD_STRING_REQUESTparseSelectorAct(1)
+	ABORT_FINALIZE(RS_RET_CONFLINE_UNPROCESSED);
+CODE_STD_FINALIZERparseSelectorAct
+ENDparseSelectorAct
+
+
+BEGINmodExit
+CODESTARTmodExit
+ENDmodExit
+
+
+BEGINqueryEtryPt
+CODESTARTqueryEtryPt
+CODEqueryEtryPt_STD_OMODTX_QUERIES
+CODEqueryEtryPt_STD_OMOD8_QUERIES
+CODEqueryEtryPt_STD_CONF2_OMOD_QUERIES
+CODEqueryEtryPt_ASYNC_OMOD_QUERIES
+ENDqueryEtryPt
+
+
+BEGINmodInit()
+CODESTARTmodInit
+	*ipIFVersProvided = CURR_MOD_IF_VERSION;
+CODEmodInit_QueryRegCFSLineHdlr
+ENDmodInit
@@ -0,0 +1,33 @@
+#!/bin/bash
+# check the parser dispatch cache: after the first message of a sender,
+# rfc3164 messages must go directly to the rfc3164 parser.
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=100
+generate_conf
+add_conf '
+global(parser.dispatchCache="on")
+module(load="../plugins/impstats/.libs/impstats" interval="1" severity="7" ruleset="stats")
+module(load="../plugins/imtcp/.libs/imtcp")
+input(type="imtcp" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcpflood_port" ruleset="ruleset1")
+
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+ruleset(name="stats") {
+	action(type="omfile" file="'${RSYSLOG_DYNNAME}'.out.stats.log")
+}
+ruleset(name="ruleset1" parser=["rsyslog.rfc5424","rsyslog.rfc3164"]) {
+	:msg, contains, "msgnum:" action(type="omfile" file=`echo $RSYSLOG_OUT_LOG`
+	       template="outfmt")
+}
+'
+startup
+tcpflood -m$NUMMESSAGES
+wait_file_lines
+rst_msleep 1100 # wait for stats flush
+shutdown_when_empty
+wait_shutdown
+seq_check
+custom_content_check 'parser.dispatchcache: origin=core.parser hits=99 misses=1' "${RSYSLOG_DYNNAME}.out.stats.log"
+custom_content_check 'rsyslog.rfc5424: origin=core.parser attempts=1 hits=0' "${RSYSLOG_DYNNAME}.out.stats.log"
+exit_test
@@ -0,0 +1,45 @@
+#!/bin/bash
+# parser benchmark for the rfc5424 and rfc3164 header fast paths. A corpus
+# of well-formed, non-canonical and malformed headers is repeated
+# PMRFC_BENCH_REPEAT times (default 100000) and the time until all messages
+# have been processed is reported. This is not part of the regular
+# testbench, run it manually, e.g.
+#   PMRFC_BENCH_REPEAT=500000 ./pmrfc-bench.sh
+# The functional check of the same corpus is pmrfc-fastpath.sh.
+# added 2026-10-18, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export PMRFC_BENCH_REPEAT="${PMRFC_BENCH_REPEAT:-100000}"
+export NUMMESSAGES=$((12 * PMRFC_BENCH_REPEAT))
+generate_conf
+add_conf '
+module(load="../plugins/imtcp/.libs/imtcp")
+input(type="imtcp" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcpflood_port")
+
+# use properties from the header, so that parsing results are actually used
+template(name="outfmt" type="string" string="%timereported:::date-rfc3339%|%hostname%|%syslogtag%\n")
+action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="outfmt")
+'
+cat > $RSYSLOG_DYNNAME.corpus <<'CORPUS'
+<165>1 2003-08-24T05:14:15.000003-07:00 192.0.2.1 myproc 8710 ID47 - valid:5424-fast
+<165>1 2003-10-11T22:14:15Z host2 app - - [ex@32473 a="1" b="x\]y"] valid:5424-sd
+<165>1 2003-8-24T5:14:15+7:00 host3 app 1 2 - valid:5424-generic
+<165>1 2003-13-24T05:14:15Z host app - - - bad:month
+<165>1 2003-08-24T05:14:15 host app - - - bad:notz
+<13>Oct 11 22:14:15 mymachine su: valid:3164-fast
+<13>oct  1 02:04:05.123: host4 tag[12]: valid:3164-fast-sp
+<13>Oct 1 22:14:15 host5 tag: valid:3164-generic
+<13>2019 Oct 11 22:14:15 host6 tag: valid:3164-year
+<13>Oct 11 2019 22:14:15 host7 tag: valid:3164-cisco
+<13>Oct 32 22:14:15 host tag: bad:day
+<13>Foo 11 22:14:15 host tag: bad:month
+CORPUS
+awk -v n=$PMRFC_BENCH_REPEAT '{ l[NR] = $0 } END { for(i = 0; i < n; ++i) for(j = 1; j <= NR; ++j) print l[j] }' \
+	< $RSYSLOG_DYNNAME.corpus > $RSYSLOG_DYNNAME.input
+startup
+starttime=$(date +%s%N)
+tcpflood -I $RSYSLOG_DYNNAME.input
+wait_file_lines
+echo "parsing $NUMMESSAGES messages took $(( ($(date +%s%N) - starttime) / 1000000 )) ms"
+shutdown_when_empty
+wait_shutdown
+exit_test
@@ -0,0 +1,64 @@
+#!/bin/bash
+# check the header fast paths of the rfc5424 and rfc3164 parsers. The
+# corpus mixes well-formed headers, which take the fast path, with
+# non-canonical ones the generic parser must still handle, and with
+# invalid ones. Lines marked "chk:" are checked for the exact header
+# properties, lines marked "bad:" must not disturb processing.
+# added 2026-10-18, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+export NUMMESSAGES=8
+generate_conf
+add_conf '
+module(load="../plugins/imtcp/.libs/imtcp")
+input(type="imtcp" port="0" listenPortFileName="'$RSYSLOG_DYNNAME'.tcpflood_port")
+
+template(name="fmt5424" type="string"
+	 string="5424|%timereported:::date-rfc3339%|%hostname%|%app-name%|%procid%|%msgid%|%structured-data%|%msg%\n")
+template(name="fmt3164" type="string"
+	 string="3164|%timereported:::date-month%-%timereported:::date-day% %timereported:::date-hour%:%timereported:::date-minute%:%timereported:::date-second%|%hostname%|%syslogtag%|%msg%\n")
+
+if $msg contains "chk:" then {
+	if $protocol-version == "1" then
+		action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="fmt5424")
+	else
+		action(type="omfile" file="'$RSYSLOG_OUT_LOG'" template="fmt3164")
+}
+'
+# we need to generate a file, because otherwise the exact spacing
+# does not survive the execution pathes through the shell
+cat > $RSYSLOG_DYNNAME.input <<'CORPUS'
+<165>1 2003-08-24T05:14:15.000003-07:00 192.0.2.1 myproc 8710 ID47 - chk:5424-fast
+<165>1 2003-10-11T22:14:15Z host2 app - - [ex@32473 a="1" b="x\]y"] chk:5424-sd
+<165>1 2003-8-24T5:14:15+7:00 host3 app 1 2 - chk:5424-generic
+<165>1 2003-13-24T05:14:15Z host app - - - bad:month
+<165>1 2003-08-24T05:14:15 host app - - - bad:notz
+<13>Oct 11 22:14:15 mymachine su: chk:3164-fast
+<13>oct  1 02:04:05.123: host4 tag[12]: chk:3164-fast-sp
+<13>Oct 1 22:14:15 host5 tag: chk:3164-generic
+<13>2019 Oct 11 22:14:15 host6 tag: chk:3164-year
+<13>Oct 11 2019 22:14:15 host7 tag: chk:3164-cisco
+<13>Oct 32 22:14:15 host tag: bad:day
+<13>Foo 11 22:14:15 host tag: bad:month
+CORPUS
+startup
+tcpflood -I $RSYSLOG_DYNNAME.input
+wait_file_lines
+shutdown_when_empty
+wait_shutdown
+
+LC_ALL=C sort < $RSYSLOG_OUT_LOG > $RSYSLOG_DYNNAME.sorted
+export EXPECTED='3164|10-01 02:04:05|host4|tag[12]:| chk:3164-fast-sp
+3164|10-01 22:14:15|host5|tag:| chk:3164-generic
+3164|10-11 22:14:15|host6|tag:| chk:3164-year
+3164|10-11 22:14:15|host7|tag:| chk:3164-cisco
+3164|10-11 22:14:15|mymachine|su:| chk:3164-fast
+5424|2003-08-24T05:14:15+07:00|host3|app|1|2|-|chk:5424-generic
+5424|2003-08-24T05:14:15.000003-07:00|192.0.2.1|myproc|8710|ID47|-|chk:5424-fast
+5424|2003-10-11T22:14:15Z|host2|app|-|-|[ex@32473 a="1" b="x\]y"]|chk:5424-sd'
+echo "$EXPECTED" | cmp - $RSYSLOG_DYNNAME.sorted
+if [ $? -ne 0 ]; then
+	echo "invalid header properties, sorted $RSYSLOG_OUT_LOG is:"
+	cat $RSYSLOG_DYNNAME.sorted
+	error_exit 1
+fi
+exit_test
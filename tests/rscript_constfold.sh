@@ -0,0 +1,24 @@
+#!/bin/bash
+# check that function calls with constant parameters which are folded
+# at config load deliver the same result as when evaluated at runtime
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%$.r%\n")
+
+if $msg contains "msgnum:00000000" then {
+	set $.r = tolower("CONST") & "," & strlen("abc") & "," & ltrim("  x") & "," &
+		  int2hex(42) & "," & replace("a.b", ".", "_") & "," & (cnum("123") + 1) & "," &
+		  field("a:b:c", 58, 2) & "," & re_extract("abc123", "[0-9]+", 0, 0, "none") & "," &
+		  substring(rtrim("abcdef  "), 1, 3) & "," & num2ipv4(ipv42num("10.0.0.1") + 1);
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+}
+'
+startup
+injectmsg  0 1
+shutdown_when_empty
+wait_shutdown
+export EXPECTED='const,3,x,2a,a_b,124,b,123,bcd,10.0.0.2'
+cmp_exact
+exit_test
@@ -0,0 +1,26 @@
+#!/bin/bash
+# check that common subexpressions are evaluated correctly and that
+# cached values are not reused after a variable or the message changed
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%$.num%\n")
+
+if $msg contains "msgnum" then {
+	set $.x = "A";
+	set $.y = tolower($.x);
+	set $.x = "B";
+	if tolower($.x) == "b" and $.y == "a" and
+	   field($msg, 58, 2) == field($msg, 58, 2) then {
+		set $.num = field($msg, 58, 2);
+		action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+	}
+}
+'
+startup
+injectmsg  0 5000
+shutdown_when_empty
+wait_shutdown
+seq_check  0 4999
+exit_test
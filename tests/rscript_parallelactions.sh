@@ -0,0 +1,26 @@
+#!/bin/bash
+# check that actions of a ruleset with parallel action commit all
+# receive the full message sequence
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+template(name="outfmt" type="string" string="%msg:F,58:2%\n")
+
+ruleset(name="rs" parallelactions="2" queue.type="linkedList") {
+	action(type="omfile" file=`echo $RSYSLOG_OUT_LOG` template="outfmt")
+	action(type="omfile" file=`echo $RSYSLOG2_OUT_LOG` template="outfmt")
+	action(type="omfile" file=`echo $RSYSLOG_DYNNAME.3.out.log` template="outfmt")
+}
+
+if $msg contains "msgnum" then call rs
+'
+startup
+injectmsg  0 10000
+shutdown_when_empty
+wait_shutdown
+seq_check  0 9999
+seq_check2 0 9999
+cp ${RSYSLOG_DYNNAME}.3.out.log $RSYSLOG_OUT_LOG
+seq_check  0 9999
+exit_test
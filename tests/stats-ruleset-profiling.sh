@@ -0,0 +1,28 @@
+#!/bin/bash
+# check that per-statement profiling counters are reported via impstats
+# This file is part of the rsyslog project, released under ASL 2.0
+. ${srcdir:=.}/diag.sh init
+generate_conf
+add_conf '
+global(ruleset.profiling="on")
+
+ruleset(name="stats") {
+  action(type="omfile" file="'${RSYSLOG_DYNNAME}'.out.stats.log")
+}
+
+module(load="../plugins/impstats/.libs/impstats" interval="1" severity="7" Ruleset="stats" format="json")
+
+if $msg contains "msgnum" then {
+  action(type="omfile" file=`echo $RSYSLOG_OUT_LOG`)
+}
+'
+startup
+injectmsg 0 100
+wait_queueempty
+. $srcdir/diag.sh wait-for-stats-flush ${RSYSLOG_DYNNAME}.out.stats.log
+echo doing shutdown
+shutdown_when_empty
+echo wait on shutdown
+wait_shutdown
+custom_content_check '"origin": "core.ruleset.profile", "executed": 100, "taken": 100, "time.ns": ' "${RSYSLOG_DYNNAME}.out.stats.log"
+exit_test
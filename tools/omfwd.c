@@ -85,6 +85,7 @@ typedef struct _instanceData {
 	int iStrmDrvrMode;
 	int iStrmDrvrExtendedCertCheck; /* verify also purpose OID in certificate extended field */
 	int iStrmDrvrSANPreference; /* ignore CN when any SAN set */
+	int iStrmDrvrKTLS; /* try kernel TLS offload */
 	char	*target;
 	char	*address;
 	char	*device;
@@ -193,6 +194,7 @@ static struct cnfparamdescr actpdescr[] = {
 	{ "streamdriverpermittedpeers", eCmdHdlrGetWord, 0 },
 	{ "streamdriver.CheckExtendedKeyPurpose", eCmdHdlrBinary, 0 },
 	{ "streamdriver.PrioritizeSAN", eCmdHdlrBinary, 0 },
+	{ "streamdriver.ktls", eCmdHdlrBinary, 0 },
 	{ "resendlastmsgonreconnect", eCmdHdlrBinary, 0 },
 	{ "udp.sendtoall", eCmdHdlrBinary, 0 },
 	{ "udp.senddelay", eCmdHdlrInt, 0 },
@@ -754,6 +756,7 @@ static rsRetVal TCPSendInit(void *pvData)
 		CHKiRet(netstrm.SetDrvrMode(pWrkrData->pNetstrm, pData->iStrmDrvrMode));
 		CHKiRet(netstrm.SetDrvrCheckExtendedKeyUsage(pWrkrData->pNetstrm, pData->iStrmDrvrExtendedCertCheck));
 		CHKiRet(netstrm.SetDrvrPrioritizeSAN(pWrkrData->pNetstrm, pData->iStrmDrvrSANPreference));
+		CHKiRet(netstrm.SetDrvrKTLS(pWrkrData->pNetstrm, pData->iStrmDrvrKTLS));
 		/* now set optional params, but only if they were actually configured */
 		if(pData->pszStrmDrvrAuthMode != NULL) {
 			CHKiRet(netstrm.SetDrvrAuthMode(pWrkrData->pNetstrm, pData->pszStrmDrvrAuthMode));
@@ -928,7 +931,7 @@ static rsRetVal doTryResume(wrkrInstanceData_t *pWrkrData)
 		if(pWrkrData->pSockArray == NULL) {
 			CHKiRet(changeToNs(pData));
 			pWrkrData->pSockArray = net.create_udp_socket((uchar*)address,
-				NULL, bBindRequired, 0, pData->UDPSendBuf, pData->ipfreebind, pData->device);
+				NULL, bBindRequired, 0, pData->UDPSendBuf, pData->ipfreebind, pData->device, 0);
 			CHKiRet(returnToOriginalNs(pData));
 		}
 		if(pWrkrData->pSockArray != NULL) {
@@ -1127,6 +1130,7 @@ setInstParamDefaults(instanceData *pData)
 	pData->iStrmDrvrMode = 0;
 	pData->iStrmDrvrExtendedCertCheck = 0;
 	pData->iStrmDrvrSANPreference = 0;
+	pData->iStrmDrvrKTLS = 0;
 	pData->iRebindInterval = 0;
 	pData->bKeepAlive = 0;
 	pData->iKeepAliveProbes = 0;
@@ -1232,6 +1236,8 @@ CODESTARTnewActInst
 			pData->iStrmDrvrExtendedCertCheck = pvals[i].val.d.n;
 		} else if(!strcmp(actpblk.descr[i].name, "streamdriver.PrioritizeSAN")) {
 			pData->iStrmDrvrSANPreference = pvals[i].val.d.n;
+		} else if(!strcmp(actpblk.descr[i].name, "streamdriver.ktls")) {
+			pData->iStrmDrvrKTLS = pvals[i].val.d.n;
 		} else if(!strcmp(actpblk.descr[i].name, "streamdriverauthmode")) {
 			pData->pszStrmDrvrAuthMode = (uchar*)es_str2cstr(pvals[i].val.d.estr, NULL);
 		} else if(!strcmp(actpblk.descr[i].name, "streamdriver.permitexpiredcerts")) {
@@ -81,6 +81,7 @@ struct instanceConf_s {
 	int bPermitAtSignsInHostname;
 	int bForceTagEndingByColon;
 	int bRemoveMsgFirstSpace;
+	uchar bHostnameChar[256];	/* chars permitted in HOSTNAME, see setHostnameChars() */
 };
 
 
@@ -93,6 +94,23 @@ CODESTARTisCompatibleWithFeature
 ENDisCompatibleWithFeature
 
 
+/* Build the per-instance table of characters permitted inside a HOSTNAME.
+ * This replaces the chain of compares in the HOSTNAME parsing loop by a
+ * single lookup. The closing square bracket is not in the table, because
+ * it depends on the message being parsed.
+ */
+static void
+setHostnameChars(instanceConf_t *const inst)
+{
+	int c;
+	for(c = 0 ; c < 256 ; ++c) {
+		inst->bHostnameChar[c] = isalnum(c) || c == '.' || c == '_' || c == '-'
+			|| (c == '@' && inst->bPermitAtSignsInHostname)
+			|| (c == '/' && inst->bPermitSlashesInHostname);
+	}
+}
+
+
 /* create input instance, set default parameters, and
  * add it to the list of instances.
  */
@@ -108,6 +126,7 @@ createInstance(instanceConf_t **pinst)
 	inst->bPermitAtSignsInHostname = 0;
 	inst->bForceTagEndingByColon = 0;
 	inst->bRemoveMsgFirstSpace = 0;
+	setHostnameChars(inst);
 	bParseHOSTNAMEandTAG=glbl.GetParseHOSTNAMEandTAG();
 	*pinst = inst;
 finalize_it:
@@ -155,6 +174,7 @@ CODESTARTnewParserInst
 			  "param '%s'\n", parserpblk.descr[i].name);
 		}
 	}
+	setHostnameChars(inst);
 finalize_it:
 CODE_STD_FINALIZERnewParserInst
 	if(lst != NULL)
@@ -276,11 +296,8 @@ CODESTARTparse
 				}
 			}
 			while(i < lenMsg
-			        && (isalnum(p2parse[i]) || p2parse[i] == '.'
-					|| p2parse[i] == '_' || p2parse[i] == '-'
-					|| (p2parse[i] == ']' && bHadSBracket)
-					|| (p2parse[i] == '@' && pInst->bPermitAtSignsInHostname)
-					|| (p2parse[i] == '/' && pInst->bPermitSlashesInHostname) )
+			        && (pInst->bHostnameChar[p2parse[i]]
+					|| (p2parse[i] == ']' && bHadSBracket))
 				&& i < (CONF_HOSTNAME_MAXSIZE - 1)) {
 				bufParseHOSTNAME[i] = p2parse[i];
 				++i;
@@ -337,11 +354,12 @@ CODESTARTparse
 		 * in RFC3164...). We now receive the full size, but will modify the
 		 * outputs so that only 32 characters max are used by default.
 		 */
-		i = 0;
-		while(lenMsg > 0 && *p2parse != ':' && *p2parse != ' ' && i < CONF_TAG_MAXSIZE - 2) {
-			bufParseTAG[i++] = *p2parse++;
-			--lenMsg;
-		}
+		const int maxLenTAG = (lenMsg < CONF_TAG_MAXSIZE - 2) ? lenMsg : CONF_TAG_MAXSIZE - 2;
+		for(i = 0 ; i < maxLenTAG && p2parse[i] != ':' && p2parse[i] != ' ' ; ++i)
+			/* just scan */;
+		memcpy(bufParseTAG, p2parse, i);
+		p2parse += i;
+		lenMsg -= i;
 		if(lenMsg > 0 && *p2parse == ':') {
 			++p2parse;
 			--lenMsg;
@@ -80,6 +80,8 @@ ENDisCompatibleWithFeature
 static int parseRFCField(uchar **pp2parse, uchar *pResult, int *pLenStr)
 {
 	uchar *p2parse;
+	uchar *pSP;
+	int lenField;
 	int iRet = 0;
 
 	assert(pp2parse != NULL);
@@ -88,19 +90,26 @@ static int parseRFCField(uchar **pp2parse, uchar *pResult, int *pLenStr)
 
 	p2parse = *pp2parse;
 
-	/* this is the actual parsing loop */
-	while(*pLenStr > 0  && *p2parse != ' ') {
-		*pResult++ = *p2parse++;
-		--(*pLenStr);
+	/* search the SP with memchr(), which libc implements vectorized,
+	 * and then copy the field en bloc.
+	 */
+	pSP = (*pLenStr > 0) ? memchr(p2parse, ' ', *pLenStr) : NULL;
+	if(pSP == NULL) {
+		lenField = (*pLenStr > 0) ? *pLenStr : 0;
+	} else {
+		lenField = (int) (pSP - p2parse);
 	}
+	memcpy(pResult, p2parse, lenField);
+	pResult[lenField] = '\0';
+	p2parse += lenField;
+	*pLenStr -= lenField;
 
-	if(*pLenStr > 0 && *p2parse == ' ') {
+	if(pSP != NULL) {
 		++p2parse; /* eat SP, but only if not at end of string */
 		--(*pLenStr);
 	} else {
 		iRet = 1; /* there MUST be an SP! */
 	}
-	*pResult = '\0';
 
 	/* set the new parse pointer */
 	*pp2parse = p2parse;
@@ -149,6 +158,20 @@ static int parseRFCStructuredData(uchar **pp2parse, uchar *pResult, int *pLenStr
 		--lenStr;
 	} else {
 		while(bCont) {
+			if(lenStr > 2) {
+				/* Everything up to the character in front of the next ']'
+				 * can neither end the SD nor start an escape sequence, so
+				 * we can locate that ']' with memchr() and copy in bulk.
+				 */
+				const uchar *const pEnd = memchr(p2parse, ']', lenStr);
+				const int nBulk = (pEnd == NULL ? lenStr : (int) (pEnd - p2parse)) - 1;
+				if(nBulk > 0) {
+					memcpy(pResult, p2parse, nBulk);
+					pResult += nBulk;
+					p2parse += nBulk;
+					lenStr -= nBulk;
+				}
+			}
 			if(lenStr < 2) {
 				/* we now need to check if we have only structured data */
 				if(lenStr > 0 && *p2parse == ']') {